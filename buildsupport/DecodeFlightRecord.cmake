@@ -0,0 +1,200 @@
+# Turns a flight recorder snapshot (hitch_<n>.pdfr, see inc/pdcpp/pdrecorder.h)
+# copied from the game data folder into a readable timeline.
+#
+# cmake -DRECORD=hitch_00.pdfr [-DOUTPUT=hitch_00.txt] -P buildsupport/DecodeFlightRecord.cmake
+#
+# One line per frame, oldest first: time of the update callback, gap to the
+# next frame (display and system), allocations, buttons held (LRUDBA) and
+# crank, then the time spent after every marker. The frame that went over
+# budget is flagged with '*'.
+
+cmake_minimum_required(VERSION 3.18)
+
+if (NOT RECORD)
+    message(FATAL_ERROR "usage: cmake -DRECORD=<hitch_n.pdfr> [-DOUTPUT=...] -P DecodeFlightRecord.cmake")
+endif ()
+
+file(READ ${RECORD} DATA HEX)
+string(LENGTH "${DATA}" SIZE)
+math(EXPR SIZE "${SIZE} / 2")
+
+# Little endian unsigned integer of BYTES bytes at OFFSET
+function(read_uint OFFSET BYTES OUT)
+    math(EXPR END "${OFFSET} + ${BYTES}")
+    if (END GREATER SIZE)
+        message(FATAL_ERROR "${RECORD}: truncated at byte ${OFFSET}")
+    endif ()
+    set(VALUE "")
+    math(EXPR LAST "${BYTES} - 1")
+    foreach (I RANGE ${LAST})
+        math(EXPR AT "(${OFFSET} + ${I}) * 2")
+        string(SUBSTRING "${DATA}" ${AT} 2 BYTE)
+        set(VALUE "${BYTE}${VALUE}")
+    endforeach ()
+    math(EXPR VALUE "0x${VALUE}")
+    set(${OUT} ${VALUE} PARENT_SCOPE)
+endfunction()
+
+# Microseconds as milliseconds with 2 decimals
+function(format_ms US OUT)
+    math(EXPR MS "${US} / 1000")
+    math(EXPR FRACTION "${US} % 1000 / 10")
+    if (FRACTION LESS 10)
+        set(FRACTION "0${FRACTION}")
+    endif ()
+    set(${OUT} "${MS}.${FRACTION}" PARENT_SCOPE)
+endfunction()
+
+function(pad_left TEXT WIDTH OUT)
+    string(LENGTH "${TEXT}" LEN)
+    math(EXPR MISSING "${WIDTH} - ${LEN}")
+    if (MISSING GREATER 0)
+        string(REPEAT " " ${MISSING} SPACES)
+        set(TEXT "${SPACES}${TEXT}")
+    endif ()
+    set(${OUT} "${TEXT}" PARENT_SCOPE)
+endfunction()
+
+#-------------------------------------------------------------------------------
+# Header
+
+string(SUBSTRING "${DATA}" 0 8 MAGIC)
+if (NOT MAGIC STREQUAL "50444652")
+    message(FATAL_ERROR "${RECORD} is not a flight record")
+endif ()
+read_uint(4 2 VERSION)
+if (NOT VERSION EQUAL 1)
+    message(FATAL_ERROR "${RECORD}: unknown version ${VERSION}")
+endif ()
+read_uint(6 2 FRAME_COUNT)
+read_uint(8 2 MARKERS_PER_FRAME)
+read_uint(10 2 LABEL_COUNT)
+read_uint(12 4 BUDGET)
+read_uint(16 4 TRIGGER)
+
+set(OFFSET 24)
+set(LABELS "")
+if (LABEL_COUNT GREATER 0)
+    foreach (I RANGE 1 ${LABEL_COUNT})
+        read_uint(${OFFSET} 1 LENGTH)
+        set(LABEL "")
+        foreach (C RANGE 1 ${LENGTH})
+            math(EXPR AT "${OFFSET} + ${C}")
+            read_uint(${AT} 1 CODE)
+            string(ASCII ${CODE} CHAR)
+            string(APPEND LABEL "${CHAR}")
+        endforeach ()
+        list(APPEND LABELS "${LABEL}")
+        math(EXPR OFFSET "${OFFSET} + 1 + ${LENGTH}")
+    endforeach ()
+endif ()
+math(EXPR OFFSET "(${OFFSET} + 3) / 4 * 4")
+
+#-------------------------------------------------------------------------------
+# Frames (recorder_frame_t in src/pdrecorder.c)
+
+math(EXPR FRAME_SIZE "32 + 8 * ${MARKERS_PER_FRAME}")
+format_ms(${BUDGET} BUDGET_MS)
+set(REPORT "${RECORD}: ${FRAME_COUNT} frames, frame ${TRIGGER} over the ${BUDGET_MS} ms budget\n")
+string(APPEND REPORT "  frame    update ms  gap ms  allocs  frees     bytes  input   crank  markers\n")
+
+set(BUTTON_NAMES L R U D B A)
+set(PREVIOUS_END "")
+math(EXPR LAST_FRAME "${FRAME_COUNT} - 1")
+foreach (INDEX RANGE ${LAST_FRAME})
+    math(EXPR BASE "${OFFSET} + ${INDEX} * ${FRAME_SIZE}")
+    read_uint(${BASE} 4 FRAME)
+    math(EXPR AT "${BASE} + 4")
+    read_uint(${AT} 4 START)
+    math(EXPR AT "${BASE} + 8")
+    read_uint(${AT} 4 DURATION)
+    math(EXPR AT "${BASE} + 12")
+    read_uint(${AT} 4 ALLOCS)
+    math(EXPR AT "${BASE} + 16")
+    read_uint(${AT} 4 FREES)
+    math(EXPR AT "${BASE} + 20")
+    read_uint(${AT} 4 BYTES)
+    math(EXPR AT "${BASE} + 24")
+    read_uint(${AT} 1 BUTTONS)
+    math(EXPR AT "${BASE} + 27")
+    read_uint(${AT} 1 MARKER_COUNT)
+    math(EXPR AT "${BASE} + 28")
+    read_uint(${AT} 2 CRANK)
+    math(EXPR AT "${BASE} + 30")
+    read_uint(${AT} 1 DOCKED)
+
+    # Time between the end of the previous callback and the start of this one
+    set(GAP "")
+    if (NOT PREVIOUS_END STREQUAL "")
+        math(EXPR GAP "(${START} - ${PREVIOUS_END}) & 0xFFFFFFFF")
+        format_ms(${GAP} GAP)
+    endif ()
+    math(EXPR PREVIOUS_END "${START} + ${DURATION}")
+
+    set(INPUT "")
+    foreach (BIT RANGE 5)
+        list(GET BUTTON_NAMES ${BIT} NAME)
+        math(EXPR HELD "(${BUTTONS} >> ${BIT}) & 1")
+        if (HELD)
+            string(APPEND INPUT "${NAME}")
+        else ()
+            string(APPEND INPUT "-")
+        endif ()
+    endforeach ()
+    if (DOCKED)
+        set(CRANK "docked")
+    else ()
+        math(EXPR CRANK "${CRANK} / 100")
+    endif ()
+
+    set(MARKERS "")
+    set(KEPT ${MARKER_COUNT})
+    if (KEPT GREATER MARKERS_PER_FRAME)
+        set(KEPT ${MARKERS_PER_FRAME})
+    endif ()
+    if (KEPT GREATER 0)
+        foreach (M RANGE 1 ${KEPT})
+            math(EXPR AT "${BASE} + 32 + (${M} - 1) * 8")
+            read_uint(${AT} 2 LABEL)
+            math(EXPR AT "${AT} + 4")
+            read_uint(${AT} 4 MARK)
+            # Up to the next marker, the last one up to the end of the callback
+            set(UNTIL ${DURATION})
+            if (M LESS KEPT)
+                math(EXPR AT "${AT} + 8")
+                read_uint(${AT} 4 UNTIL)
+            endif ()
+            math(EXPR SPENT "${UNTIL} - ${MARK}")
+            format_ms(${SPENT} SPENT)
+            if (LABEL LESS LABEL_COUNT)
+                list(GET LABELS ${LABEL} NAME)
+            else ()
+                set(NAME "?")
+            endif ()
+            string(APPEND MARKERS " ${NAME} ${SPENT}")
+        endforeach ()
+        if (MARKER_COUNT GREATER KEPT)
+            math(EXPR DROPPED "${MARKER_COUNT} - ${KEPT}")
+            string(APPEND MARKERS " (+${DROPPED} dropped)")
+        endif ()
+    endif ()
+
+    set(FLAG " ")
+    if (FRAME EQUAL TRIGGER)
+        set(FLAG "*")
+    endif ()
+    format_ms(${DURATION} DURATION)
+    pad_left("${FRAME}" 7 FRAME)
+    pad_left("${DURATION}" 10 DURATION)
+    pad_left("${GAP}" 7 GAP)
+    pad_left("${ALLOCS}" 7 ALLOCS)
+    pad_left("${FREES}" 6 FREES)
+    pad_left("${BYTES}" 9 BYTES)
+    pad_left("${CRANK}" 7 CRANK)
+    string(APPEND REPORT "${FLAG}${FRAME}${DURATION} ${GAP} ${ALLOCS} ${FREES} ${BYTES}  ${INPUT} ${CRANK} ${MARKERS}\n")
+endforeach ()
+
+if (OUTPUT)
+    file(WRITE ${OUTPUT} "${REPORT}")
+endif ()
+message("${REPORT}")
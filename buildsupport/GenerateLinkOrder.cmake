@@ -0,0 +1,127 @@
+# Generates a linker script with the functions ordered by hotness, from the
+# profile written by a -DPDCPP_PGO_INSTRUMENT=ON build (see readme.md).
+#
+# cmake -DELF=<instrumented game .elf> -DPROFILE=<pgo_profile.txt>
+#       [-DNM=arm-none-eabi-nm] [-DTEMPLATE=buildsupport/link_map.ld]
+#       [-DOUTPUT=buildsupport/link_map_ordered.ld]
+#       -P buildsupport/GenerateLinkOrder.cmake
+#
+# The .text block of the template becomes, in this order:
+#   hot    functions hit during the profiling run, most called first
+#   libs   libc/libm/libgcc/libstdc++, not instrumented but used by the hot code
+#   warm   everything else
+#   cold   .text.unlikely, static initializers (.text.startup) and .text.exit
+# A function name that doesn't exist anymore just matches nothing, so the
+# script stays usable while the code changes, until the next profiling run.
+
+cmake_minimum_required(VERSION 3.18)
+
+if (NOT ELF OR NOT PROFILE)
+    message(FATAL_ERROR "usage: cmake -DELF=<game.elf> -DPROFILE=<pgo_profile.txt> [-DNM=...] [-DTEMPLATE=...] [-DOUTPUT=...] -P GenerateLinkOrder.cmake")
+endif ()
+if (NOT NM)
+    set(NM arm-none-eabi-nm)
+endif ()
+if (NOT TEMPLATE)
+    set(TEMPLATE ${CMAKE_CURRENT_LIST_DIR}/link_map.ld)
+endif ()
+if (NOT OUTPUT)
+    set(OUTPUT ${CMAKE_CURRENT_LIST_DIR}/link_map_ordered.ld)
+endif ()
+
+# Function symbols of the instrumented build: link address -> section suffix
+execute_process(
+    COMMAND ${NM} --defined-only ${ELF}
+    OUTPUT_VARIABLE SYMBOLS
+    RESULT_VARIABLE NM_RESULT
+)
+if (NOT NM_RESULT EQUAL 0)
+    message(FATAL_ERROR "${NM} failed on ${ELF}")
+endif ()
+
+string(REPLACE "\n" ";" SYMBOLS "${SYMBOLS}")
+foreach (LINE IN LISTS SYMBOLS)
+    if (LINE MATCHES "^([0-9a-fA-F]+) [TtWw] (.+)$")
+        # Thumb functions have bit 0 set, ignore it on both sides
+        math(EXPR ADDRESS "(0x${CMAKE_MATCH_1}) & ~1")
+        set(SYMBOL_${ADDRESS} "${CMAKE_MATCH_2}")
+        set(ADDRESS_OF_${CMAKE_MATCH_2} ${ADDRESS})
+    endif ()
+endforeach ()
+
+# Runtime addresses -> link addresses, thanks to the base symbol written first
+file(STRINGS ${PROFILE} PROFILE_LINES)
+set(DELTA "")
+set(HOT "")
+set(UNKNOWN 0)
+foreach (LINE IN LISTS PROFILE_LINES)
+    if (LINE MATCHES "^base ([^ ]+) 0x([0-9a-fA-F]+)$")
+        if (NOT DEFINED ADDRESS_OF_${CMAKE_MATCH_1})
+            message(FATAL_ERROR "${CMAKE_MATCH_1} not found in ${ELF}, is it the instrumented build?")
+        endif ()
+        math(EXPR DELTA "${ADDRESS_OF_${CMAKE_MATCH_1}} - ((0x${CMAKE_MATCH_2}) & ~1)")
+    elseif (LINE MATCHES "^dropped ([0-9]+)$")
+        if (CMAKE_MATCH_1 GREATER 0)
+            message(WARNING "${CMAKE_MATCH_1} function entries didn't fit in the profile table")
+        endif ()
+    elseif (LINE MATCHES "^0x([0-9a-fA-F]+) ([0-9]+)$")
+        if (DELTA STREQUAL "")
+            message(FATAL_ERROR "${PROFILE} has no base line")
+        endif ()
+        math(EXPR ADDRESS "((0x${CMAKE_MATCH_1}) & ~1) + ${DELTA}")
+        if (DEFINED SYMBOL_${ADDRESS})
+            # Zero padded so a string sort is a numeric sort
+            string(LENGTH "${CMAKE_MATCH_2}" DIGITS)
+            math(EXPR PAD "10 - ${DIGITS}")
+            string(REPEAT "0" ${PAD} ZEROS)
+            list(APPEND HOT "${ZEROS}${CMAKE_MATCH_2} ${SYMBOL_${ADDRESS}}")
+        else ()
+            math(EXPR UNKNOWN "${UNKNOWN} + 1")
+        endif ()
+    endif ()
+endforeach ()
+
+list(SORT HOT ORDER DESCENDING)
+list(LENGTH HOT HOT_COUNT)
+if (UNKNOWN GREATER 0)
+    message(WARNING "${UNKNOWN} profiled addresses don't match any function of ${ELF}")
+endif ()
+
+set(TAB "\t\t")
+set(TEXT "/* Generated by GenerateLinkOrder.cmake from ${PROFILE} */\n")
+string(APPEND TEXT "${TAB}/* hot: ${HOT_COUNT} functions, most called first */\n")
+string(APPEND TEXT "${TAB}*(.text.hot .text.hot.*)\n")
+foreach (ENTRY IN LISTS HOT)
+    string(REGEX REPLACE "^[0-9]+ " "" NAME "${ENTRY}")
+    string(APPEND TEXT "${TAB}*(.text.${NAME})\n")
+endforeach ()
+# Wildcards can't exclude, so "everything but the cold sections" is spelled as
+# patterns that can't match their names: .text.[!eus]* .text.e[!x]* ...
+set(COLD_NAMES unlikely startup exit)
+set(WARM ".text .text.[!eus]*")
+foreach (NAME IN LISTS COLD_NAMES)
+    string(LENGTH "${NAME}" LEN)
+    math(EXPR LAST "${LEN} - 1")
+    foreach (I RANGE 1 ${LAST})
+        string(SUBSTRING "${NAME}" 0 ${I} PREFIX)
+        string(SUBSTRING "${NAME}" ${I} 1 NEXT)
+        string(APPEND WARM " .text.${PREFIX}[!${NEXT}]*")
+    endforeach ()
+endforeach ()
+
+string(APPEND TEXT "${TAB}/* libs */\n")
+foreach (LIB libc.a libm.a libgcc.a libstdc++.a libsupc++.a)
+    string(APPEND TEXT "${TAB}*${LIB}:*(${WARM})\n")
+endforeach ()
+string(APPEND TEXT "${TAB}/* warm */\n")
+string(APPEND TEXT "${TAB}*(${WARM})\n")
+string(APPEND TEXT "${TAB}/* cold */\n")
+string(APPEND TEXT "${TAB}*(.text.unlikely .text.unlikely.*)\n")
+string(APPEND TEXT "${TAB}*(.text.startup .text.startup.*)\n")
+string(APPEND TEXT "${TAB}*(.text.exit .text.exit.*)\n")
+string(APPEND TEXT "${TAB}*(.text.*)\n")
+
+file(READ ${TEMPLATE} SCRIPT)
+string(REGEX REPLACE "/\\* PDCPP_TEXT_ORDER_BEGIN[^\n]*\n.*/\\* PDCPP_TEXT_ORDER_END \\*/\n" "${TEXT}" SCRIPT "${SCRIPT}")
+file(WRITE ${OUTPUT} "${SCRIPT}")
+message(STATUS "Wrote ${OUTPUT} (${HOT_COUNT} hot functions)")
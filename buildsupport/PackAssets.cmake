@@ -0,0 +1,216 @@
+# Packs the data files of a Source folder (SVG levels, TGA textures...) into
+# one archive read by examples/common/inc/PakFile.h: a single file to open on
+# device instead of one per asset.
+#
+# cmake -DSOURCE=Source [-DOUTPUT=Source/assets.pak] [-DPATTERNS=*.svg|*.tga] [-DALIGN=16]
+#       [-DCOMPRESSOR=<pdlz>] [-DEXCLUDE=level0.svg|...] [-DSTAGE=<dir>]
+#       -P buildsupport/PackAssets.cmake
+#
+# EXCLUDE lists files relative to SOURCE left out, those compiled in the game.
+# With STAGE, the files of SOURCE that weren't packed are copied to STAGE, the
+# folder given to pdc, and OUTPUT defaults to STAGE/assets.pak: the pdx then
+# carries the packed files once, and nothing is written to SOURCE.
+#
+# Layout: a text index padded to ALIGN bytes, then the files, each one
+# starting on an ALIGN bytes boundary (spaces in between).
+#   PDPAK 2 <count:5> <data start:10>\n
+#   <fnv1a hash:8 hex> <offset:10> <size:10> <unpacked size:10> <path>\n    one per file, sorted by hash
+# Offsets are from the start of the archive, paths relative to SOURCE with '/'.
+# Text rather than binary: a CMake script can't write a 0 byte. pdc only
+# compiles images, fonts, sounds and Lua: the archive is copied to the pdx as is.
+#
+# With COMPRESSOR (pdlz of buildsupport/hosttools, built for the build
+# machine), a file is stored LZ compressed when that saves at least 1/16 of
+# it: size is then the compressed size, smaller than the unpacked one.
+# Noise-like data (the blue noise texture) doesn't compress and stays as it is.
+
+cmake_minimum_required(VERSION 3.18)
+
+if (NOT SOURCE)
+    message(FATAL_ERROR "usage: cmake -DSOURCE=<Source dir> [-DOUTPUT=...] [-DPATTERNS=...] [-DALIGN=...] -P PackAssets.cmake")
+endif ()
+get_filename_component(SOURCE ${SOURCE} ABSOLUTE)
+if (STAGE)
+    get_filename_component(STAGE ${STAGE} ABSOLUTE)
+    if (NOT OUTPUT)
+        set(OUTPUT ${STAGE}/assets.pak)
+    endif ()
+elseif (NOT OUTPUT)
+    set(OUTPUT ${SOURCE}/assets.pak)
+endif ()
+get_filename_component(OUTPUT ${OUTPUT} ABSOLUTE)
+if (NOT PATTERNS)
+    set(PATTERNS "*.svg|*.tga")
+endif ()
+string(REPLACE "|" ";" PATTERNS "${PATTERNS}")
+if (NOT ALIGN)
+    set(ALIGN 16)
+endif ()
+
+# Same as pdcpp_hash_string() of inc/pdcpp/pdhash.h
+function(fnv1a TEXT OUT)
+    string(HEX "${TEXT}" HEX)
+    string(REGEX MATCHALL ".." BYTES "${HEX}")
+    set(HASH 2166136261)
+    foreach (BYTE ${BYTES})
+        math(EXPR HASH "((${HASH} ^ 0x${BYTE}) * 16777619) & 0xFFFFFFFF")
+    endforeach ()
+    math(EXPR HASH "${HASH}" OUTPUT_FORMAT HEXADECIMAL)
+    string(SUBSTRING "${HASH}" 2 -1 HASH)
+    string(TOLOWER "${HASH}" HASH)
+    pad_left("${HASH}" 8 "0" HASH)
+    set(${OUT} ${HASH} PARENT_SCOPE)
+endfunction()
+
+function(pad_left TEXT WIDTH FILL OUT)
+    string(LENGTH "${TEXT}" LEN)
+    math(EXPR MISSING "${WIDTH} - ${LEN}")
+    if (MISSING GREATER 0)
+        string(REPEAT "${FILL}" ${MISSING} PADDING)
+        set(TEXT "${PADDING}${TEXT}")
+    endif ()
+    set(${OUT} "${TEXT}" PARENT_SCOPE)
+endfunction()
+
+#-------------------------------------------------------------------------------
+# Files, sorted by hash
+
+set(GLOBS "")
+foreach (PATTERN ${PATTERNS})
+    list(APPEND GLOBS ${SOURCE}/${PATTERN})
+endforeach ()
+file(GLOB_RECURSE FILES RELATIVE ${SOURCE} ${GLOBS})
+file(RELATIVE_PATH SELF ${SOURCE} ${OUTPUT})
+list(REMOVE_ITEM FILES ${SELF})
+if (EXCLUDE)
+    string(REPLACE "|" ";" EXCLUDE "${EXCLUDE}")
+    list(REMOVE_ITEM FILES ${EXCLUDE})
+endif ()
+
+set(KEYED "")
+foreach (FILE ${FILES})
+    fnv1a("${FILE}" HASH)
+    list(APPEND KEYED "${HASH}|${FILE}")
+endforeach ()
+list(SORT KEYED)
+
+list(LENGTH KEYED COUNT)
+if (COUNT GREATER 99999)
+    message(FATAL_ERROR "${SOURCE}: too many files to pack (${COUNT})")
+endif ()
+
+#-------------------------------------------------------------------------------
+# Index: fixed width numbers, its size is known before the offsets
+
+set(HEADER_SIZE 25)
+foreach (ITEM ${KEYED})
+    string(FIND "${ITEM}" "|" BAR)
+    math(EXPR BAR "${BAR} + 1")
+    string(SUBSTRING "${ITEM}" ${BAR} -1 FILE)
+    string(LENGTH "${FILE}" LEN)
+    math(EXPR HEADER_SIZE "${HEADER_SIZE} + 43 + ${LEN}")
+endforeach ()
+math(EXPR DATA_START "(${HEADER_SIZE} + ${ALIGN} - 1) / ${ALIGN} * ${ALIGN}")
+
+set(WORK ${OUTPUT}.tmp)
+file(REMOVE_RECURSE ${WORK})
+file(MAKE_DIRECTORY ${WORK})
+
+pad_left("${COUNT}" 5 "0" COUNT_TEXT)
+pad_left("${DATA_START}" 10 "0" START_TEXT)
+set(INDEX "PDPAK 2 ${COUNT_TEXT} ${START_TEXT}\n")
+set(PARTS ${WORK}/index)
+set(OFFSET ${DATA_START})
+set(UNPACKED_TOTAL 0)
+foreach (ITEM ${KEYED})
+    string(FIND "${ITEM}" "|" BAR)
+    string(SUBSTRING "${ITEM}" 0 ${BAR} HASH)
+    math(EXPR BAR "${BAR} + 1")
+    string(SUBSTRING "${ITEM}" ${BAR} -1 FILE)
+    file(SIZE ${SOURCE}/${FILE} UNPACKED)
+    math(EXPR UNPACKED_TOTAL "${UNPACKED_TOTAL} + ${UNPACKED}")
+
+    set(PART ${SOURCE}/${FILE})
+    set(SIZE ${UNPACKED})
+    if (COMPRESSOR)
+        execute_process(
+            COMMAND ${COMPRESSOR} ${SOURCE}/${FILE} ${WORK}/${HASH}.lz
+            RESULT_VARIABLE RESULT
+        )
+        if (NOT RESULT EQUAL 0)
+            message(FATAL_ERROR "Can't compress ${SOURCE}/${FILE}")
+        endif ()
+        file(SIZE ${WORK}/${HASH}.lz PACKED)
+        math(EXPR WORTH "${UNPACKED} - ${UNPACKED} / 16")
+        if (PACKED LESS WORTH)
+            set(PART ${WORK}/${HASH}.lz)
+            set(SIZE ${PACKED})
+        endif ()
+    endif ()
+
+    pad_left("${OFFSET}" 10 "0" OFFSET_TEXT)
+    pad_left("${SIZE}" 10 "0" SIZE_TEXT)
+    pad_left("${UNPACKED}" 10 "0" UNPACKED_TEXT)
+    string(APPEND INDEX "${HASH} ${OFFSET_TEXT} ${SIZE_TEXT} ${UNPACKED_TEXT} ${FILE}\n")
+
+    list(APPEND PARTS ${PART})
+    math(EXPR PAD "(${ALIGN} - ${SIZE} % ${ALIGN}) % ${ALIGN}")
+    if (PAD GREATER 0)
+        if (NOT EXISTS ${WORK}/pad${PAD})
+            string(REPEAT " " ${PAD} SPACES)
+            file(WRITE ${WORK}/pad${PAD} "${SPACES}")
+        endif ()
+        list(APPEND PARTS ${WORK}/pad${PAD})
+    endif ()
+    math(EXPR OFFSET "${OFFSET} + ${SIZE} + ${PAD}")
+endforeach ()
+
+math(EXPR PAD "${DATA_START} - ${HEADER_SIZE}")
+if (PAD GREATER 0)
+    string(REPEAT " " ${PAD} SPACES)
+    string(APPEND INDEX "${SPACES}")
+endif ()
+file(WRITE ${WORK}/index "${INDEX}")
+
+# cmake -E cat copies the bytes as they are
+execute_process(
+    COMMAND ${CMAKE_COMMAND} -E cat ${PARTS}
+    OUTPUT_FILE ${OUTPUT}
+    RESULT_VARIABLE RESULT
+)
+file(REMOVE_RECURSE ${WORK})
+if (NOT RESULT EQUAL 0)
+    file(REMOVE ${OUTPUT})
+    message(FATAL_ERROR "Can't write ${OUTPUT}")
+endif ()
+
+file(SIZE ${OUTPUT} TOTAL)
+if (NOT TOTAL EQUAL OFFSET)
+    message(FATAL_ERROR "${OUTPUT}: ${TOTAL} bytes written, ${OFFSET} expected")
+endif ()
+message(STATUS "${COUNT} files packed in ${OUTPUT} (${TOTAL} bytes, ${UNPACKED_TOTAL} unpacked)")
+
+#-------------------------------------------------------------------------------
+# Staging: the rest of SOURCE, the copies left by a previous run removed. The
+# game binary (pdex.*) is copied there by the build.
+
+if (STAGE)
+    file(GLOB_RECURSE LOOSE RELATIVE ${SOURCE} ${SOURCE}/*)
+    list(FILTER LOOSE EXCLUDE REGEX "(^|/)pdex\\.[a-z]+$")
+    # assets.pak: left in SOURCE by a build that packed there
+    list(REMOVE_ITEM LOOSE ${SELF} assets.pak ${FILES})
+    foreach (FILE ${LOOSE})
+        # Only rewritten when different
+        configure_file(${SOURCE}/${FILE} ${STAGE}/${FILE} COPYONLY)
+    endforeach ()
+
+    file(RELATIVE_PATH STAGED_PAK ${STAGE} ${OUTPUT})
+    file(GLOB_RECURSE STAGED RELATIVE ${STAGE} ${STAGE}/*)
+    list(FILTER STAGED EXCLUDE REGEX "(^|/)pdex\\.[a-z]+$")
+    list(REMOVE_ITEM STAGED ${STAGED_PAK} ${LOOSE})
+    foreach (FILE ${STAGED})
+        file(REMOVE ${STAGE}/${FILE})
+    endforeach ()
+    list(LENGTH LOOSE LOOSE_COUNT)
+    message(STATUS "${LOOSE_COUNT} other files staged in ${STAGE}")
+endif ()
@@ -0,0 +1,225 @@
+# Summarizes the stack usage data of a -DPDCPP_STACK_USAGE=ON build (see
+# readme.md). Run by the <application>_stack_report targets, or by hand:
+#
+# cmake -DBUILD_DIR=<build dir> [-DAPPLICATION_DIR=<dir> -DAPPLICATION_DIRS=<dir|dir...>]
+#       [-DSTACK_SIZE=61800] [-DTOP=20] [-DOUTPUT=<build dir>/stack_report.txt]
+#       -P buildsupport/StackUsageReport.cmake
+#
+# Lists the largest frames from the .su files (-fstack-usage), then the
+# deepest call chains from the .ci call graphs (gcc -fcallgraph-info=su).
+# The objects under the other APPLICATION_DIRS are skipped, so functions with
+# the same name in several examples don't mix.
+# Calls through pointers (PlaydateAPI, virtuals, std::function) end a chain,
+# and the libraries and the system below them don't show: the real usage is
+# higher than the report, keep a margin.
+
+cmake_minimum_required(VERSION 3.18)
+
+if (NOT BUILD_DIR)
+    message(FATAL_ERROR "usage: cmake -DBUILD_DIR=<build dir> [-DAPPLICATION_DIR=... -DAPPLICATION_DIRS=...] [-DSTACK_SIZE=...] [-DTOP=...] [-DOUTPUT=...] -P StackUsageReport.cmake")
+endif ()
+if (NOT TOP)
+    set(TOP 20)
+endif ()
+if (NOT OUTPUT)
+    set(OUTPUT ${BUILD_DIR}/stack_report.txt)
+endif ()
+
+string(REPLACE "|" ";" APPLICATION_DIRS "${APPLICATION_DIRS}")
+list(REMOVE_ITEM APPLICATION_DIRS "${APPLICATION_DIR}")
+
+# Build outputs of the given type, minus those of the other applications
+function(collect_files EXTENSION OUT)
+    file(GLOB_RECURSE FILES ${BUILD_DIR}/*.${EXTENSION})
+    foreach (DIR ${APPLICATION_DIRS})
+        list(FILTER FILES EXCLUDE REGEX "^${DIR}/")
+    endforeach ()
+    set(${OUT} ${FILES} PARENT_SCOPE)
+endfunction()
+
+set(REPORT "")
+macro(report LINE)
+    string(APPEND REPORT "${LINE}\n")
+endmacro()
+
+# Zero padded so the natural sort of "<bytes>|..." entries orders by size
+function(pad_bytes VALUE OUT)
+    string(LENGTH "${VALUE}" LEN)
+    math(EXPR MISSING "8 - ${LEN}")
+    set(PADDED "${VALUE}")
+    if (MISSING GREATER 0)
+        string(REPEAT "0" ${MISSING} ZEROS)
+        set(PADDED "${ZEROS}${VALUE}")
+    endif ()
+    set(${OUT} ${PADDED} PARENT_SCOPE)
+endfunction()
+
+#-------------------------------------------------------------------------------
+# Largest frames
+
+collect_files(su SU_FILES)
+if (NOT SU_FILES)
+    message(FATAL_ERROR "No .su file under ${BUILD_DIR}: configure with -DPDCPP_STACK_USAGE=ON and build first")
+endif ()
+
+set(FRAMES "")
+set(INDEX 0)
+foreach (SU ${SU_FILES})
+    file(STRINGS ${SU} LINES)
+    foreach (LINE ${LINES})
+        # file:line:col:function<TAB>bytes<TAB>static|dynamic|dynamic,bounded
+        # Anchored on the location: C++ names have colons of their own. They
+        # can hold ; and [] too ([with T = ...; U = ...]), kept out of the list.
+        if (LINE MATCHES "^(.+):([0-9]+):([0-9]+):(.*)\t([0-9]+)\t(.*)$")
+            pad_bytes(${CMAKE_MATCH_5} BYTES)
+            set(FRAME_NAME_${INDEX} "${CMAKE_MATCH_4}")
+            set(FRAME_KIND_${INDEX} "${CMAKE_MATCH_6}")
+            set(FRAME_WHERE_${INDEX} "${CMAKE_MATCH_1}:${CMAKE_MATCH_2}:${CMAKE_MATCH_3}")
+            list(APPEND FRAMES "${BYTES}|${INDEX}")
+            math(EXPR INDEX "${INDEX} + 1")
+        endif ()
+    endforeach ()
+endforeach ()
+list(SORT FRAMES COMPARE NATURAL ORDER DESCENDING)
+
+report("Largest stack frames")
+set(COUNT 0)
+foreach (FRAME ${FRAMES})
+    if (COUNT EQUAL TOP)
+        break()
+    endif ()
+    string(REPLACE "|" ";" FIELDS "${FRAME}")
+    list(GET FIELDS 0 BYTES)
+    list(GET FIELDS 1 INDEX)
+    math(EXPR BYTES "${BYTES}")
+    report("  ${BYTES}\t${FRAME_NAME_${INDEX}} (${FRAME_KIND_${INDEX}}) ${FRAME_WHERE_${INDEX}}")
+    math(EXPR COUNT "${COUNT} + 1")
+endforeach ()
+
+#-------------------------------------------------------------------------------
+# Deepest call chains
+
+collect_files(ci CI_FILES)
+if (CI_FILES)
+    set(NODES "")
+    foreach (CI ${CI_FILES})
+        file(STRINGS ${CI} LINES)
+        foreach (LINE ${LINES})
+            if (LINE MATCHES "^node: { title: \"([^\"]+)\" label: \"[^\"]*\\\\n([0-9]+) bytes")
+                string(MAKE_C_IDENTIFIER "${CMAKE_MATCH_1}" ID)
+                if (NOT DEFINED NAME_${ID})
+                    list(APPEND NODES ${ID})
+                    set(NAME_${ID} "${CMAKE_MATCH_1}")
+                endif ()
+                set(BYTES_${ID} ${CMAKE_MATCH_2})
+            elseif (LINE MATCHES "^edge: { sourcename: \"([^\"]+)\" targetname: \"([^\"]+)\"")
+                string(MAKE_C_IDENTIFIER "${CMAKE_MATCH_1}" FROM)
+                string(MAKE_C_IDENTIFIER "${CMAKE_MATCH_2}" TO)
+                list(APPEND CALLEES_${FROM} ${TO})
+            endif ()
+        endforeach ()
+    endforeach ()
+
+    # depth(f) = frame(f) + max depth(callee), depth first. A call back into a
+    # function being visited is recursion: it is counted once and the chains
+    # going through it are flagged.
+    function(stack_depth ID)
+        get_property(STATE GLOBAL PROPERTY STATE_${ID})
+        if (STATE STREQUAL "done")
+            return()
+        elseif (STATE STREQUAL "active")
+            set_property(GLOBAL APPEND PROPERTY RECURSIVE ${ID})
+            return()
+        endif ()
+        set_property(GLOBAL PROPERTY STATE_${ID} active)
+
+        set(BEST 0)
+        set(NEXT "")
+        foreach (CALLEE ${CALLEES_${ID}})
+            if (DEFINED BYTES_${CALLEE})
+                stack_depth(${CALLEE})
+                get_property(DEPTH GLOBAL PROPERTY DEPTH_${CALLEE})
+                if (DEPTH GREATER BEST)
+                    set(BEST ${DEPTH})
+                    set(NEXT ${CALLEE})
+                endif ()
+            endif ()
+        endforeach ()
+
+        math(EXPR DEPTH "${BYTES_${ID}} + ${BEST}")
+        set_property(GLOBAL PROPERTY DEPTH_${ID} ${DEPTH})
+        set_property(GLOBAL PROPERTY NEXT_${ID} "${NEXT}")
+        set_property(GLOBAL PROPERTY STATE_${ID} done)
+    endfunction()
+
+    foreach (ID ${NODES})
+        if (CALLEES_${ID})
+            list(REMOVE_DUPLICATES CALLEES_${ID})
+        endif ()
+    endforeach ()
+    foreach (ID ${NODES})
+        stack_depth(${ID})
+    endforeach ()
+    get_property(RECURSIVE GLOBAL PROPERTY RECURSIVE)
+
+    set(CHAINS "")
+    foreach (ID ${NODES})
+        get_property(DEPTH GLOBAL PROPERTY DEPTH_${ID})
+        pad_bytes(${DEPTH} DEPTH)
+        list(APPEND CHAINS "${DEPTH}|${ID}")
+    endforeach ()
+    list(SORT CHAINS COMPARE NATURAL ORDER DESCENDING)
+
+    report("")
+    if (STACK_SIZE)
+        report("Deepest call chains (stack size ${STACK_SIZE} bytes)")
+    else ()
+        report("Deepest call chains")
+    endif ()
+    set(COUNT 0)
+    foreach (CHAIN ${CHAINS})
+        if (COUNT EQUAL TOP)
+            break()
+        endif ()
+        string(REPLACE "|" ";" FIELDS "${CHAIN}")
+        list(GET FIELDS 1 ID)
+        get_property(DEPTH GLOBAL PROPERTY DEPTH_${ID})
+        set(LINE "  ${DEPTH}")
+        if (STACK_SIZE)
+            math(EXPR PERCENT "${DEPTH} * 100 / ${STACK_SIZE}")
+            string(APPEND LINE " (${PERCENT}%)")
+        endif ()
+
+        set(STEP ${ID})
+        set(PATH "")
+        set(FLAG "")
+        while (STEP)
+            if (STEP IN_LIST RECURSIVE)
+                set(FLAG " + recursion")
+            endif ()
+            # Static functions are titled <source path>:<name>, keep the file name
+            string(REGEX REPLACE "^.*/" "" NAME "${NAME_${STEP}}")
+            list(APPEND PATH "${NAME}(${BYTES_${STEP}})")
+            get_property(STEP GLOBAL PROPERTY NEXT_${STEP})
+        endwhile ()
+        list(JOIN PATH " > " PATH)
+        report("${LINE}${FLAG}\t${PATH}")
+        math(EXPR COUNT "${COUNT} + 1")
+    endforeach ()
+else ()
+    report("")
+    report("No .ci call graph (gcc -fcallgraph-info=su): call chains not available")
+endif ()
+
+file(WRITE ${OUTPUT} "${REPORT}")
+
+# C++ names are mangled in the .ci files
+find_program(CXXFILT NAMES arm-none-eabi-c++filt c++filt)
+if (CXXFILT)
+    execute_process(COMMAND ${CXXFILT} INPUT_FILE ${OUTPUT} OUTPUT_VARIABLE DEMANGLED RESULT_VARIABLE CXXFILT_RESULT)
+    if (CXXFILT_RESULT EQUAL 0)
+        set(REPORT "${DEMANGLED}")
+        file(WRITE ${OUTPUT} "${REPORT}")
+    endif ()
+endif ()
+message("${REPORT}Written to ${OUTPUT}")
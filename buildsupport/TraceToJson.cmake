@@ -0,0 +1,173 @@
+# Converts the trace written by a -DPDCPP_TRACE=ON build (trace.pdtr in the
+# game data folder, see inc/pdcpp/pdtrace.h) to the trace_event JSON format of
+# chrome://tracing and ui.perfetto.dev.
+#
+# cmake -DTRACE=trace.pdtr [-DOUTPUT=trace.json] -P buildsupport/TraceToJson.cmake
+#
+# Timestamps are microseconds from the first event. Scopes still open when
+# the recording stopped are closed at the last timestamp.
+
+cmake_minimum_required(VERSION 3.18)
+
+if (NOT TRACE)
+    message(FATAL_ERROR "usage: cmake -DTRACE=<trace.pdtr> [-DOUTPUT=...] -P TraceToJson.cmake")
+endif ()
+if (NOT OUTPUT)
+    get_filename_component(OUTPUT ${TRACE} NAME_WE)
+    get_filename_component(DIR ${TRACE} DIRECTORY)
+    if (DIR)
+        set(OUTPUT ${DIR}/${OUTPUT}.json)
+    else ()
+        set(OUTPUT ${OUTPUT}.json)
+    endif ()
+endif ()
+
+file(READ ${TRACE} DATA HEX)
+string(LENGTH "${DATA}" SIZE)
+
+# Little endian unsigned integer from the hex string of its bytes
+function(hex_le HEX OUT)
+    string(LENGTH "${HEX}" LEN)
+    set(VALUE "")
+    set(AT 0)
+    while (AT LESS LEN)
+        string(SUBSTRING "${HEX}" ${AT} 2 BYTE)
+        set(VALUE "${BYTE}${VALUE}")
+        math(EXPR AT "${AT} + 2")
+    endwhile ()
+    math(EXPR VALUE "0x${VALUE}")
+    set(${OUT} ${VALUE} PARENT_SCOPE)
+endfunction()
+
+# Text of the hex string of its bytes, up to the first 0, escaped for JSON
+function(hex_text HEX OUT)
+    string(REGEX MATCHALL ".." BYTES "${HEX}")
+    set(TEXT "")
+    foreach (BYTE ${BYTES})
+        if (BYTE STREQUAL "00")
+            break()
+        endif ()
+        math(EXPR CODE "0x${BYTE}")
+        string(ASCII ${CODE} CHAR)
+        string(APPEND TEXT "${CHAR}")
+    endforeach ()
+    string(REPLACE "\\" "\\\\" TEXT "${TEXT}")
+    string(REPLACE "\"" "\\\"" TEXT "${TEXT}")
+    set(${OUT} "${TEXT}" PARENT_SCOPE)
+endfunction()
+
+#-------------------------------------------------------------------------------
+# Header (trace_header_t in src/pdtrace.c) and names
+
+string(SUBSTRING "${DATA}" 0 8 MAGIC)
+if (NOT MAGIC STREQUAL "50445452")
+    message(FATAL_ERROR "${TRACE} is not a pdcpp trace")
+endif ()
+string(SUBSTRING "${DATA}" 8 4 HEX)
+hex_le(${HEX} VERSION)
+if (NOT VERSION EQUAL 1)
+    message(FATAL_ERROR "${TRACE}: unknown version ${VERSION}")
+endif ()
+string(SUBSTRING "${DATA}" 12 4 HEX)
+hex_le(${HEX} LABEL_COUNT)
+string(SUBSTRING "${DATA}" 16 8 HEX)
+hex_le(${HEX} EVENT_COUNT)
+string(SUBSTRING "${DATA}" 24 8 HEX)
+hex_le(${HEX} DROPPED)
+
+set(AT 32)
+set(LABELS "")
+if (LABEL_COUNT GREATER 0)
+    foreach (I RANGE 1 ${LABEL_COUNT})
+        string(SUBSTRING "${DATA}" ${AT} 2 HEX)
+        math(EXPR LENGTH "0x${HEX}")
+        math(EXPR AT "${AT} + 2")
+        math(EXPR HEX_LENGTH "${LENGTH} * 2")
+        string(SUBSTRING "${DATA}" ${AT} ${HEX_LENGTH} HEX)
+        hex_text("${HEX}" LABEL)
+        # Names are list items
+        string(REPLACE ";" "," LABEL "${LABEL}")
+        list(APPEND LABELS "${LABEL}")
+        math(EXPR AT "${AT} + ${HEX_LENGTH}")
+    endforeach ()
+endif ()
+math(EXPR AT "(${AT} + 7) / 8 * 8")
+
+math(EXPR EVENTS_LENGTH "${EVENT_COUNT} * 16")
+math(EXPR EXPECTED "${AT} + ${EVENTS_LENGTH}")
+if (EXPECTED GREATER SIZE)
+    message(FATAL_ERROR "${TRACE}: truncated")
+endif ()
+string(SUBSTRING "${DATA}" ${AT} ${EVENTS_LENGTH} EVENTS)
+string(REGEX MATCHALL "................" EVENTS "${EVENTS}")
+
+#-------------------------------------------------------------------------------
+# Events (trace_event_t in src/pdtrace.c)
+
+set(JSON "{\"displayTimeUnit\":\"ms\",\"otherData\":{\"dropped\":${DROPPED}},\"traceEvents\":[\n")
+set(FIRST "")
+set(TS 0)
+set(DEPTH 0)
+set(SKIP 0)
+set(TEXT_HEX "")
+set(PENDING "")
+foreach (EVENT ${EVENTS})
+    # Text of the previous begin
+    if (SKIP GREATER 0)
+        string(APPEND TEXT_HEX "${EVENT}")
+        math(EXPR SKIP "${SKIP} - 1")
+        if (SKIP EQUAL 0)
+            hex_text("${TEXT_HEX}" TEXT)
+            string(APPEND JSON "${PENDING},\"args\":{\"text\":\"${TEXT}\"}},\n")
+        endif ()
+        continue()
+    endif ()
+
+    string(SUBSTRING "${EVENT}" 0 8 HEX)
+    hex_le(${HEX} US)
+    if (FIRST STREQUAL "")
+        set(FIRST ${US})
+    endif ()
+    # Timestamps wrap after ~71 minutes
+    math(EXPR TS "(${US} - ${FIRST}) & 0xFFFFFFFF")
+    string(SUBSTRING "${EVENT}" 8 4 HEX)
+    hex_le(${HEX} LABEL)
+    string(SUBSTRING "${EVENT}" 12 2 HEX)
+    math(EXPR TYPE "0x${HEX}")
+    string(SUBSTRING "${EVENT}" 14 2 HEX)
+    math(EXPR CHUNKS "0x${HEX}")
+
+    if (LABEL LESS LABEL_COUNT)
+        list(GET LABELS ${LABEL} NAME)
+    else ()
+        set(NAME "?")
+    endif ()
+    set(COMMON "\"pid\":1,\"tid\":1,\"ts\":${TS}")
+
+    if (TYPE EQUAL 0)
+        string(APPEND JSON "{\"name\":\"${NAME}\",\"ph\":\"B\",${COMMON}},\n")
+        math(EXPR DEPTH "${DEPTH} + 1")
+    elseif (TYPE EQUAL 1)
+        # An end without its begin: the trace was cleared in the middle of a scope
+        if (DEPTH GREATER 0)
+            string(APPEND JSON "{\"ph\":\"E\",${COMMON}},\n")
+            math(EXPR DEPTH "${DEPTH} - 1")
+        endif ()
+    elseif (TYPE EQUAL 2)
+        string(APPEND JSON "{\"name\":\"${NAME}\",\"ph\":\"i\",\"s\":\"t\",${COMMON}},\n")
+    elseif (TYPE EQUAL 3)
+        set(PENDING "{\"name\":\"${NAME}\",\"ph\":\"B\",${COMMON}")
+        set(TEXT_HEX "")
+        set(SKIP ${CHUNKS})
+        math(EXPR DEPTH "${DEPTH} + 1")
+    endif ()
+endforeach ()
+
+while (DEPTH GREATER 0)
+    string(APPEND JSON "{\"ph\":\"E\",\"pid\":1,\"tid\":1,\"ts\":${TS}},\n")
+    math(EXPR DEPTH "${DEPTH} - 1")
+endwhile ()
+string(APPEND JSON "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"args\":{\"name\":\"Playdate\"}}\n]}\n")
+
+file(WRITE ${OUTPUT} "${JSON}")
+message("${EVENT_COUNT} events (${DROPPED} dropped) written to ${OUTPUT}")
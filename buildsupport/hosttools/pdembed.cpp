@@ -0,0 +1,237 @@
+// Asset embedding of add_playdate_embedded_assets(), see
+// examples/common/inc/Embedded.h for the types.
+//
+// pdembed <texture|polylines|binary> <input> <output.h> <name> [align]
+//
+// Writes a header with the content of `input` as constexpr arrays, aligned
+// to `align` bytes (16 by default), and a constexpr embedded::<name> pointing
+// at them:
+//   texture    8 bpp grayscale TGA -> EmbeddedTexture, the pixels only
+//   polylines  SVG paths, flattened by svgParsePathText() -> EmbeddedPolylines
+//   binary     the file as it is -> EmbeddedBinary
+
+#include "SvgLoader.h"
+
+#include <cmath>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <vector>
+
+namespace
+{
+    bool readFile(const char* path, std::vector<uint8_t>& data)
+    {
+        FILE* file = fopen(path, "rb");
+        if (file == nullptr)
+        {
+            return false;
+        }
+        uint8_t buffer[64 * 1024];
+        size_t bytes;
+        while ((bytes = fread(buffer, 1, sizeof(buffer), file)) > 0)
+        {
+            data.insert(data.end(), buffer, buffer + bytes);
+        }
+        bool ok = ferror(file) == 0;
+        fclose(file);
+        return ok;
+    }
+
+    void appendf(std::string& out, const char* format, ...)
+    {
+        char line[256];
+        va_list args;
+        va_start(args, format);
+        vsnprintf(line, sizeof(line), format, args);
+        va_end(args);
+        out += line;
+    }
+
+    void appendBytes(std::string& out, const uint8_t* data, size_t size)
+    {
+        for (size_t i = 0; i < size; ++i)
+        {
+            appendf(out, "%s0x%02x,%s", i % 16 == 0 ? "            " : "", data[i], i % 16 == 15 || i + 1 == size ? "\n" : " ");
+        }
+        // No zero-sized arrays in C++
+        if (size == 0)
+        {
+            out += "            0\n";
+        }
+    }
+
+    // Shortest text that reads back to the same float, as a float literal
+    // Finite values only, nan and inf have no literal
+    std::string floatLiteral(float value)
+    {
+        char text[32];
+        for (int digits = 6; digits <= 9; ++digits)
+        {
+            snprintf(text, sizeof(text), "%.*g", digits, double(value));
+            if (strtof(text, nullptr) == value)
+            {
+                break;
+            }
+        }
+        std::string literal = text;
+        if (literal.find_first_of(".e") == std::string::npos)
+        {
+            literal += ".0";
+        }
+        return literal + "f";
+    }
+
+    // Same checks as read_tga_header_grayscale() of ImageLoader.cpp
+    bool textureArrays(const std::vector<uint8_t>& tga, const char* name, int align, std::string& arrays, std::string& value)
+    {
+        if (tga.size() < 18 || tga[2] != 3 || tga[16] != 8)
+        {
+            return false;
+        }
+        int width = tga[12] | tga[13] << 8;
+        int height = tga[14] | tga[15] << 8;
+        size_t offset = 18 + tga[0];
+        if (width == 0 || width > 2048 || height == 0 || height > 2048 || tga.size() < offset + size_t(width) * height)
+        {
+            return false;
+        }
+
+        appendf(arrays, "        alignas(%d) inline constexpr uint8_t %s_pixels[] = {\n", align, name);
+        appendBytes(arrays, tga.data() + offset, size_t(width) * height);
+        arrays += "        };\n";
+        appendf(value, "inline constexpr EmbeddedTexture %s{ detail::%s_pixels, %d, %d };", name, name, width, height);
+        return true;
+    }
+
+    bool polylineArrays(const std::vector<uint8_t>& svg, const char* name, int align, std::string& arrays, std::string& value)
+    {
+        std::string text(svg.begin(), svg.end());
+        std::vector<std::vector<vec2>> polygons = svgParsePathText(text.c_str(), text.size());
+        for (const std::vector<vec2>& polygon : polygons)
+        {
+            for (const vec2& point : polygon)
+            {
+                if (!std::isfinite(point.x) || !std::isfinite(point.y))
+                {
+                    return false;
+                }
+            }
+        }
+
+        appendf(arrays, "        alignas(%d) inline constexpr vec2 %s_points[] = {\n", align, name);
+        std::vector<uint32_t> ends;
+        uint32_t count = 0;
+        for (const std::vector<vec2>& polygon : polygons)
+        {
+            for (const vec2& point : polygon)
+            {
+                appendf(arrays, "%s{ %s, %s },%s", count % 4 == 0 ? "            " : "",
+                    floatLiteral(point.x).c_str(), floatLiteral(point.y).c_str(), count % 4 == 3 ? "\n" : " ");
+                ++count;
+            }
+            ends.push_back(count);
+        }
+        if (count == 0)
+        {
+            arrays += "            { 0.0f, 0.0f }\n";
+        }
+        else if (count % 4 != 0)
+        {
+            arrays.back() = '\n';
+        }
+        arrays += "        };\n";
+
+        appendf(arrays, "        inline constexpr uint32_t %s_ends[] = {", name);
+        for (uint32_t end : ends)
+        {
+            appendf(arrays, " %u,", end);
+        }
+        arrays += ends.empty() ? " 0 };\n" : " };\n";
+        appendf(value, "inline constexpr EmbeddedPolylines %s{ detail::%s_points, detail::%s_ends, %d };", name, name, name, int(ends.size()));
+        return true;
+    }
+
+    void binaryArrays(const std::vector<uint8_t>& data, const char* name, int align, std::string& arrays, std::string& value)
+    {
+        appendf(arrays, "        alignas(%d) inline constexpr uint8_t %s_data[] = {\n", align, name);
+        appendBytes(arrays, data.data(), data.size());
+        arrays += "        };\n";
+        appendf(value, "inline constexpr EmbeddedBinary %s{ detail::%s_data, %zu };", name, name, data.size());
+    }
+}
+
+//******************************************************************************
+int main(int argc, char** argv)
+{
+    if (argc != 5 && argc != 6)
+    {
+        fprintf(stderr, "usage: pdembed <texture|polylines|binary> <input> <output.h> <name> [align]\n");
+        return 2;
+    }
+    const char* kind = argv[1];
+    const char* input = argv[2];
+    const char* output = argv[3];
+    const char* name = argv[4];
+    int align = argc == 6 ? atoi(argv[5]) : 16;
+    if (align <= 0 || (align & (align - 1)) != 0)
+    {
+        fprintf(stderr, "pdembed: the alignment must be a power of two, not %s\n", argv[5]);
+        return 2;
+    }
+
+    std::vector<uint8_t> data;
+    if (!readFile(input, data))
+    {
+        fprintf(stderr, "pdembed: can't read %s\n", input);
+        return 1;
+    }
+
+    std::string arrays;
+    std::string value;
+    if (strcmp(kind, "texture") == 0)
+    {
+        if (!textureArrays(data, name, align, arrays, value))
+        {
+            fprintf(stderr, "pdembed: %s isn't an 8 bpp grayscale TGA\n", input);
+            return 1;
+        }
+    }
+    else if (strcmp(kind, "polylines") == 0)
+    {
+        if (!polylineArrays(data, name, align, arrays, value))
+        {
+            fprintf(stderr, "pdembed: %s has a point that isn't a finite number\n", input);
+            return 1;
+        }
+    }
+    else if (strcmp(kind, "binary") == 0)
+    {
+        binaryArrays(data, name, align, arrays, value);
+    }
+    else
+    {
+        fprintf(stderr, "pdembed: unknown kind %s\n", kind);
+        return 2;
+    }
+
+    const char* file = strrchr(input, '/');
+    std::string header;
+    appendf(header, "// Generated by add_playdate_embedded_assets() from %s, edit that file instead\n", file ? file + 1 : input);
+    header += "#pragma once\n\n#include \"Embedded.h\"\n\nnamespace embedded\n{\n    namespace detail\n    {\n";
+    header += arrays;
+    header += "    }\n\n    ";
+    header += value;
+    header += "\n}\n";
+
+    FILE* out = fopen(output, "wb");
+    bool written = out != nullptr && fwrite(header.data(), 1, header.size(), out) == header.size();
+    if (out == nullptr || fclose(out) != 0 || !written)
+    {
+        fprintf(stderr, "pdembed: can't write %s\n", output);
+        return 1;
+    }
+    return 0;
+}
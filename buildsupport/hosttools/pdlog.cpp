@@ -0,0 +1,504 @@
+// Host side of the binary log, see inc/pdcpp/pdlog.h.
+//
+// pdlog table <output.txt> <file or directory>...
+//     Scans the C/C++ sources for PDCPP_LOG_<LEVEL>("format"...) and writes
+//     the formats keyed by their hash, one per line:
+//       <fnv1a hash:8 hex> <file>:<line> <format, C escapes>
+//     The output is only rewritten when it changes.
+// pdlog print <table.txt> <log.pdlg>
+//     Formats the records of the log with the formats of the table.
+
+#include "pdcpp/pdhash.h"
+
+#include <algorithm>
+#include <filesystem>
+#include <map>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+namespace
+{
+    // pdcpp_log_record_t of pdlog.h
+    constexpr int Args = 5;
+    constexpr size_t RecordSize = 12 + Args * 4;
+    constexpr size_t HeaderSize = 16;
+
+    const char* const Levels[] = { "TRACE", "DEBUG", "INFO", "WARN", "ERROR" };
+
+    struct Format
+    {
+        std::string Text;           // unescaped
+        std::string Location;       // file:line of the first use
+    };
+
+    bool readFile(const fs::path& path, std::string& data)
+    {
+        FILE* file = fopen(path.string().c_str(), "rb");
+        if (file == nullptr)
+        {
+            return false;
+        }
+        char buffer[64 * 1024];
+        size_t bytes;
+        while ((bytes = fread(buffer, 1, sizeof(buffer), file)) > 0)
+        {
+            data.append(buffer, bytes);
+        }
+        bool ok = ferror(file) == 0;
+        fclose(file);
+        return ok;
+    }
+
+    int hexDigit(char c)
+    {
+        if (c >= '0' && c <= '9') return c - '0';
+        if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+        if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+        return -1;
+    }
+
+    // Reads a string literal starting at the quote, as the compiler sees it.
+    // False on anything else than plain characters and simple escapes.
+    bool readLiteral(const std::string& text, size_t& i, std::string& out)
+    {
+        ++i;
+        while (i < text.size() && text[i] != '"')
+        {
+            char c = text[i++];
+            if (c == '\n')
+            {
+                return false;
+            }
+            if (c != '\\')
+            {
+                out += c;
+                continue;
+            }
+            if (i == text.size())
+            {
+                return false;
+            }
+            c = text[i++];
+            switch (c)
+            {
+            case 'n': out += '\n'; break;
+            case 't': out += '\t'; break;
+            case 'r': out += '\r'; break;
+            case '\\': case '"': case '\'': case '?': out += c; break;
+            case 'x':
+            {
+                int value = 0;
+                int digits = 0;
+                while (i < text.size() && hexDigit(text[i]) >= 0)
+                {
+                    value = value * 16 + hexDigit(text[i++]);
+                    ++digits;
+                }
+                if (digits == 0)
+                {
+                    return false;
+                }
+                out += char(value);
+                break;
+            }
+            default:
+                return false;
+            }
+        }
+        if (i == text.size())
+        {
+            return false;
+        }
+        ++i;
+        return true;
+    }
+
+    void skipSpaces(const std::string& text, size_t& i)
+    {
+        while (i < text.size() && (text[i] == ' ' || text[i] == '\t' || text[i] == '\r' || text[i] == '\n'))
+        {
+            ++i;
+        }
+    }
+
+    std::string escape(const std::string& text)
+    {
+        std::string out;
+        for (unsigned char c : text)
+        {
+            switch (c)
+            {
+            case '\n': out += "\\n"; break;
+            case '\t': out += "\\t"; break;
+            case '\r': out += "\\r"; break;
+            case '\\': out += "\\\\"; break;
+            default:
+                if (c < 32 || c >= 127)
+                {
+                    char hex[8];
+                    snprintf(hex, sizeof(hex), "\\x%02x", c);
+                    out += hex;
+                }
+                else
+                {
+                    out += char(c);
+                }
+            }
+        }
+        return out;
+    }
+
+    std::string unescape(const std::string& text)
+    {
+        std::string out;
+        for (size_t i = 0; i < text.size(); ++i)
+        {
+            if (text[i] != '\\' || i + 1 == text.size())
+            {
+                out += text[i];
+                continue;
+            }
+            char c = text[++i];
+            if (c == 'n') out += '\n';
+            else if (c == 't') out += '\t';
+            else if (c == 'r') out += '\r';
+            else if (c == 'x' && i + 2 < text.size() && hexDigit(text[i + 1]) >= 0 && hexDigit(text[i + 2]) >= 0)
+            {
+                out += char(hexDigit(text[i + 1]) * 16 + hexDigit(text[i + 2]));
+                i += 2;
+            }
+            else out += c;
+        }
+        return out;
+    }
+
+    bool scanFile(const fs::path& path, std::map<uint32_t, Format>& formats)
+    {
+        std::string text;
+        if (!readFile(path, text))
+        {
+            fprintf(stderr, "pdlog: can't read %s\n", path.string().c_str());
+            return false;
+        }
+
+        static const char* const Macros[] = { "PDCPP_LOG_TRACE", "PDCPP_LOG_DEBUG", "PDCPP_LOG_INFO", "PDCPP_LOG_WARN", "PDCPP_LOG_ERROR" };
+        bool ok = true;
+        size_t at = 0;
+        while ((at = text.find("PDCPP_LOG_", at)) != std::string::npos)
+        {
+            size_t i = at;
+            at += 10;
+            const char* const* macro = std::find_if(std::begin(Macros), std::end(Macros),
+                [&](const char* name) { return text.compare(i, strlen(name), name) == 0; });
+            if (macro == std::end(Macros))
+            {
+                continue;
+            }
+            // Not the examples of the comments
+            size_t lineStart = text.rfind('\n', i);
+            lineStart = lineStart == std::string::npos ? 0 : lineStart + 1;
+            if (text.find("//", lineStart) < i)
+            {
+                continue;
+            }
+            i += strlen(*macro);
+            skipSpaces(text, i);
+            if (i == text.size() || text[i] != '(')
+            {
+                continue;
+            }
+            ++i;
+            skipSpaces(text, i);
+            if (i == text.size() || text[i] != '"')
+            {
+                continue;
+            }
+
+            // Adjacent literals are one string
+            std::string format;
+            bool literal = true;
+            while (i < text.size() && text[i] == '"' && (literal = readLiteral(text, i, format)))
+            {
+                skipSpaces(text, i);
+            }
+            std::string location = path.filename().string() + ":" + std::to_string(std::count(text.begin(), text.begin() + at, '\n') + 1);
+            if (!literal)
+            {
+                fprintf(stderr, "pdlog: %s: can't read the log format\n", location.c_str());
+                ok = false;
+                continue;
+            }
+
+            uint32_t hash = pdcpp_hash_string(format.c_str());
+            auto found = formats.find(hash);
+            if (found == formats.end())
+            {
+                formats[hash] = Format{ format, location };
+            }
+            else if (found->second.Text != format)
+            {
+                fprintf(stderr, "pdlog: %s: same hash as the format of %s, change one of them\n",
+                    location.c_str(), found->second.Location.c_str());
+                ok = false;
+            }
+        }
+        return ok;
+    }
+
+    int table(const char* output, int count, char** inputs)
+    {
+        // Sorted, for the same table whatever the order of the file system
+        std::vector<fs::path> files;
+        for (int i = 0; i < count; ++i)
+        {
+            std::error_code error;
+            if (fs::is_directory(inputs[i], error))
+            {
+                for (const fs::directory_entry& entry : fs::recursive_directory_iterator(inputs[i], error))
+                {
+                    std::string extension = entry.path().extension().string();
+                    if (entry.is_regular_file() && (extension == ".c" || extension == ".cpp" || extension == ".h"
+                        || extension == ".hpp" || extension == ".hcpp"))
+                    {
+                        files.push_back(entry.path());
+                    }
+                }
+            }
+            else if (fs::is_regular_file(inputs[i], error))
+            {
+                files.push_back(inputs[i]);
+            }
+            if (error)
+            {
+                fprintf(stderr, "pdlog: can't read %s: %s\n", inputs[i], error.message().c_str());
+                return 1;
+            }
+        }
+        std::sort(files.begin(), files.end());
+
+        std::map<uint32_t, Format> formats;
+        bool ok = true;
+        for (const fs::path& file : files)
+        {
+            ok = scanFile(file, formats) && ok;
+        }
+        if (!ok)
+        {
+            return 1;
+        }
+
+        std::string text = "# Log formats (pdlog table), <hash> <first use> <format>\n";
+        for (const auto& [hash, format] : formats)
+        {
+            char key[16];
+            snprintf(key, sizeof(key), "%08x ", hash);
+            text += key + format.Location + " " + escape(format.Text) + "\n";
+        }
+
+        std::string previous;
+        if (readFile(output, previous) && previous == text)
+        {
+            return 0;
+        }
+        FILE* out = fopen(output, "wb");
+        bool written = out != nullptr && fwrite(text.data(), 1, text.size(), out) == text.size();
+        if (out == nullptr || fclose(out) != 0 || !written)
+        {
+            fprintf(stderr, "pdlog: can't write %s\n", output);
+            return 1;
+        }
+        return 0;
+    }
+
+    bool readTable(const char* path, std::map<uint32_t, Format>& formats)
+    {
+        std::string text;
+        if (!readFile(path, text))
+        {
+            return false;
+        }
+        size_t start = 0;
+        while (start < text.size())
+        {
+            size_t end = text.find('\n', start);
+            if (end == std::string::npos)
+            {
+                end = text.size();
+            }
+            std::string line = text.substr(start, end - start);
+            start = end + 1;
+
+            size_t space = line.find(' ', 9);
+            if (line.empty() || line[0] == '#' || line.size() < 9 || line[8] != ' ' || space == std::string::npos)
+            {
+                continue;
+            }
+            uint32_t hash = uint32_t(strtoul(line.substr(0, 8).c_str(), nullptr, 16));
+            formats[hash] = Format{ unescape(line.substr(space + 1)), line.substr(9, space - 9) };
+        }
+        return true;
+    }
+
+    uint32_t word(const uint8_t* data)
+    {
+        return data[0] | data[1] << 8 | data[2] << 16 | uint32_t(data[3]) << 24;
+    }
+
+    // printf with the arguments of the record, each conversion on its own
+    std::string formatRecord(const std::string& format, const uint32_t* args, int count)
+    {
+        std::string out;
+        int arg = 0;
+        for (size_t i = 0; i < format.size(); ++i)
+        {
+            if (format[i] != '%')
+            {
+                out += format[i];
+                continue;
+            }
+            if (i + 1 < format.size() && format[i + 1] == '%')
+            {
+                out += '%';
+                ++i;
+                continue;
+            }
+
+            // Flags, width and precision as they are, without the length
+            std::string spec = "%";
+            size_t j = i + 1;
+            while (j < format.size() && strchr("-+ #0123456789.", format[j]))
+            {
+                spec += format[j++];
+            }
+            while (j < format.size() && (format[j] == 'h' || format[j] == 'l'))
+            {
+                ++j;
+            }
+            if (j == format.size() || arg == count)
+            {
+                out += format.substr(i);
+                break;
+            }
+            char conversion = format[j];
+            uint32_t value = args[arg++];
+            char text[512];
+            if (strchr("fFeEgGaA", conversion))
+            {
+                float f;
+                memcpy(&f, &value, sizeof(f));
+                snprintf(text, sizeof(text), (spec + conversion).c_str(), double(f));
+            }
+            else if (conversion == 'd' || conversion == 'i')
+            {
+                snprintf(text, sizeof(text), (spec + conversion).c_str(), int(int32_t(value)));
+            }
+            else if (conversion == 'p')
+            {
+                snprintf(text, sizeof(text), "0x%08x", value);
+            }
+            else if (conversion == 'c')
+            {
+                snprintf(text, sizeof(text), (spec + conversion).c_str(), int(value));
+            }
+            else
+            {
+                snprintf(text, sizeof(text), (spec + conversion).c_str(), (unsigned int)value);
+            }
+            out += text;
+            i = j;
+        }
+        return out;
+    }
+
+    int print(const char* tablePath, const char* logPath)
+    {
+        std::map<uint32_t, Format> formats;
+        if (!readTable(tablePath, formats))
+        {
+            fprintf(stderr, "pdlog: can't read %s\n", tablePath);
+            return 1;
+        }
+        std::string log;
+        if (!readFile(logPath, log))
+        {
+            fprintf(stderr, "pdlog: can't read %s\n", logPath);
+            return 1;
+        }
+        const uint8_t* data = reinterpret_cast<const uint8_t*>(log.data());
+        if (log.size() < HeaderSize || memcmp(data, "PDLG", 4) != 0 || (data[4] | data[5] << 8) != 1
+            || (data[6] | data[7] << 8) != Args)
+        {
+            fprintf(stderr, "pdlog: %s isn't a version 1 log\n", logPath);
+            return 1;
+        }
+        uint32_t count = word(data + 8);
+        uint32_t lost = word(data + 12);
+        if (log.size() < HeaderSize + count * RecordSize)
+        {
+            fprintf(stderr, "pdlog: %s: truncated\n", logPath);
+            count = uint32_t((log.size() - HeaderSize) / RecordSize);
+        }
+        if (lost)
+        {
+            printf("(%u older records overwritten)\n", lost);
+        }
+
+        int unknown = 0;
+        for (uint32_t r = 0; r < count; ++r)
+        {
+            const uint8_t* record = data + HeaderSize + r * RecordSize;
+            uint32_t hash = word(record);
+            uint32_t us = word(record + 4);
+            int level = record[8] | record[9] << 8;
+            int argCount = std::min(record[10] | record[11] << 8, Args);
+            uint32_t args[Args];
+            for (int a = 0; a < Args; ++a)
+            {
+                args[a] = word(record + 12 + a * 4);
+            }
+
+            printf("%5u.%06u %-5s ", us / 1000000, us % 1000000, level < 5 ? Levels[level] : "?");
+            auto found = formats.find(hash);
+            if (found == formats.end())
+            {
+                ++unknown;
+                printf("<format %08x>", hash);
+                for (int a = 0; a < argCount; ++a)
+                {
+                    printf(" 0x%08x", args[a]);
+                }
+                printf("\n");
+            }
+            else
+            {
+                printf("%s: %s\n", found->second.Location.c_str(), formatRecord(found->second.Text, args, argCount).c_str());
+            }
+        }
+        if (unknown)
+        {
+            fprintf(stderr, "pdlog: %d records with a format missing from %s, is it from the same build?\n", unknown, tablePath);
+        }
+        return 0;
+    }
+}
+
+//******************************************************************************
+int main(int argc, char** argv)
+{
+    if (argc >= 4 && strcmp(argv[1], "table") == 0)
+    {
+        return table(argv[2], argc - 3, argv + 3);
+    }
+    if (argc == 4 && strcmp(argv[1], "print") == 0)
+    {
+        return print(argv[2], argv[3]);
+    }
+    fprintf(stderr, "usage: pdlog table <output.txt> <file or directory>...\n"
+                    "       pdlog print <table.txt> <log.pdlg>\n");
+    return 2;
+}
@@ -0,0 +1,234 @@
+// LZ compressor of the asset archive, see examples/common/inc/LzDecoder.h for
+// the format.
+//
+// pdlz <input> <output>
+//
+// Greedy parse over hash chains, with one step of lazy matching: slower than
+// the LZ4 fast path, but it runs once per build and the device only pays for
+// the decoding, which doesn't depend on how hard the compressor looked.
+// Every output is decoded again with LzDecoder (in small pieces, like the
+// asset loader does) and compared to the input before it is written.
+
+#include "LzDecoder.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+
+namespace
+{
+    constexpr int HashBits = 16;
+    constexpr int ChainDepth = 256;
+
+    struct Match
+    {
+        int Length = 0;
+        int Distance = 0;
+    };
+
+    uint32_t hash4(const uint8_t* p)
+    {
+        uint32_t word;
+        memcpy(&word, p, 4);
+        return (word * 2654435761u) >> (32 - HashBits);
+    }
+
+    void putCount(std::vector<uint8_t>& out, int count)
+    {
+        count -= 15;
+        while (count >= 255)
+        {
+            out.push_back(255);
+            count -= 255;
+        }
+        out.push_back(uint8_t(count));
+    }
+
+    // A match length of 0 for the last sequence, literals only
+    void putSequence(std::vector<uint8_t>& out, const uint8_t* literals, int count, Match match)
+    {
+        int length = match.Length > 0 ? match.Length - LZ_MIN_MATCH : 0;
+        out.push_back(uint8_t((count < 15 ? count : 15) << 4 | (length < 15 ? length : 15)));
+        if (count >= 15)
+        {
+            putCount(out, count);
+        }
+        out.insert(out.end(), literals, literals + count);
+
+        if (match.Length > 0)
+        {
+            out.push_back(uint8_t(match.Distance));
+            out.push_back(uint8_t(match.Distance >> 8));
+            if (length >= 15)
+            {
+                putCount(out, length);
+            }
+        }
+    }
+
+    class Compressor
+    {
+    public:
+        explicit Compressor(const std::vector<uint8_t>& input)
+        : In(input)
+        , Head(size_t(1) << HashBits, -1)
+        , Prev(input.size(), -1)
+        {
+        }
+
+        std::vector<uint8_t> Run()
+        {
+            std::vector<uint8_t> out;
+            const uint8_t* src = In.data();
+            int size = int(In.size());
+            int anchor = 0;
+
+            // The format wants literals at the end: short inputs are nothing else
+            int matchStartLimit = size - LZ_MATCH_LIMIT;
+            int pos = 0;
+            while (pos < matchStartLimit)
+            {
+                Match match = Find(pos);
+                if (match.Length < LZ_MIN_MATCH)
+                {
+                    ++pos;
+                    continue;
+                }
+                // One literal more when it gets a longer match
+                if (pos + 1 < matchStartLimit && Find(pos + 1).Length > match.Length)
+                {
+                    ++pos;
+                    continue;
+                }
+
+                putSequence(out, src + anchor, pos - anchor, match);
+                pos += match.Length;
+                anchor = pos;
+            }
+            putSequence(out, src + anchor, size - anchor, Match());
+            return out;
+        }
+
+    private:
+        // Longest match at `pos` with the bytes before it
+        Match Find(int pos)
+        {
+            const uint8_t* src = In.data();
+            for (; Inserted < pos; ++Inserted)
+            {
+                uint32_t h = hash4(src + Inserted);
+                Prev[Inserted] = Head[h];
+                Head[h] = Inserted;
+            }
+
+            int maxLength = int(In.size()) - LZ_LAST_LITERALS - pos;
+            Match best;
+            int candidate = Head[hash4(src + pos)];
+            for (int depth = 0; candidate >= 0 && depth < ChainDepth && pos - candidate <= LZ_MAX_OFFSET; ++depth)
+            {
+                int length = 0;
+                while (length < maxLength && src[candidate + length] == src[pos + length])
+                {
+                    ++length;
+                }
+                if (length > best.Length)
+                {
+                    best.Length = length;
+                    best.Distance = pos - candidate;
+                    if (length == maxLength)
+                    {
+                        break;
+                    }
+                }
+                candidate = Prev[candidate];
+            }
+            return best;
+        }
+
+        const std::vector<uint8_t>& In;
+        std::vector<int> Head;
+        std::vector<int> Prev;
+        int Inserted = 0;
+    };
+
+    bool readFile(const char* path, std::vector<uint8_t>& data)
+    {
+        FILE* file = fopen(path, "rb");
+        if (file == nullptr)
+        {
+            return false;
+        }
+        uint8_t buffer[64 * 1024];
+        size_t bytes;
+        while ((bytes = fread(buffer, 1, sizeof(buffer), file)) > 0)
+        {
+            data.insert(data.end(), buffer, buffer + bytes);
+        }
+        bool ok = ferror(file) == 0;
+        fclose(file);
+        return ok;
+    }
+
+    bool writeFile(const char* path, const std::vector<uint8_t>& data)
+    {
+        FILE* file = fopen(path, "wb");
+        if (file == nullptr)
+        {
+            return false;
+        }
+        bool ok = fwrite(data.data(), 1, data.size(), file) == data.size();
+        return fclose(file) == 0 && ok;
+    }
+
+    bool check(const std::vector<uint8_t>& input, const std::vector<uint8_t>& packed)
+    {
+        std::vector<uint8_t> decoded(input.size());
+        LzDecoder decoder;
+        decoder.Begin(decoded.data(), int(decoded.size()));
+        // Odd pieces, to cross every state of the decoder
+        for (size_t at = 0; at < packed.size(); at += 997)
+        {
+            size_t bytes = packed.size() - at < 997 ? packed.size() - at : 997;
+            if (!decoder.Feed(packed.data() + at, int(bytes)))
+            {
+                return false;
+            }
+        }
+        return decoder.Done() && decoded == input;
+    }
+}
+
+//******************************************************************************
+int main(int argc, char** argv)
+{
+    if (argc != 3)
+    {
+        fprintf(stderr, "usage: pdlz <input> <output>\n");
+        return 2;
+    }
+
+    std::vector<uint8_t> input;
+    if (!readFile(argv[1], input))
+    {
+        fprintf(stderr, "pdlz: can't read %s\n", argv[1]);
+        return 1;
+    }
+    if (input.size() > 0x7fffffff)
+    {
+        fprintf(stderr, "pdlz: %s is too large\n", argv[1]);
+        return 1;
+    }
+
+    std::vector<uint8_t> packed = Compressor(input).Run();
+    if (!check(input, packed))
+    {
+        fprintf(stderr, "pdlz: %s doesn't decode back to the input\n", argv[1]);
+        return 1;
+    }
+    if (!writeFile(argv[2], packed))
+    {
+        fprintf(stderr, "pdlz: can't write %s\n", argv[2]);
+        return 1;
+    }
+    return 0;
+}
@@ -1,3 +1,43 @@
+set(PDCPP_BUILDSUPPORT_DIR ${CMAKE_CURRENT_LIST_DIR}/../buildsupport)
+
+# Tools of the build (buildsupport/hosttools): a project of their own, so that
+# they get the host compiler and not the toolchain of the games. Built the
+# first time a rule needs them, then again when one of their sources changes.
+set(PDCPP_HOST_TOOLS_DIR ${CMAKE_BINARY_DIR}/hosttools)
+set(PDCPP_LZ_COMPRESSOR ${PDCPP_HOST_TOOLS_DIR}/pdlz${CMAKE_HOST_EXECUTABLE_SUFFIX})
+set(PDCPP_EMBEDDER ${PDCPP_HOST_TOOLS_DIR}/pdembed${CMAKE_HOST_EXECUTABLE_SUFFIX})
+set(PDCPP_LOG_TOOL ${PDCPP_HOST_TOOLS_DIR}/pdlog${CMAKE_HOST_EXECUTABLE_SUFFIX})
+
+# Sources of pdcpp scanned for the log formats, with those of every application
+set(PDCPP_LOG_SOURCE_DIRS
+    ${CMAKE_CURRENT_LIST_DIR}/../inc
+    ${CMAKE_CURRENT_LIST_DIR}/../src
+    ${CMAKE_CURRENT_LIST_DIR}/../examples/common
+)
+
+function(pdcpp_host_tools)
+    if (TARGET pdcpp_host_tools)
+        return()
+    endif ()
+    include(ExternalProject)
+    ExternalProject_Add(pdcpp_host_tools
+        SOURCE_DIR ${PDCPP_BUILDSUPPORT_DIR}/hosttools
+        BINARY_DIR ${PDCPP_HOST_TOOLS_DIR}
+        CMAKE_ARGS -DCMAKE_BUILD_TYPE=Release -DCMAKE_TOOLCHAIN_FILE=
+        BUILD_COMMAND ${CMAKE_COMMAND} --build <BINARY_DIR> --config Release
+        INSTALL_COMMAND ""
+        BUILD_BYPRODUCTS ${PDCPP_LZ_COMPRESSOR} ${PDCPP_EMBEDDER} ${PDCPP_LOG_TOOL}
+    )
+    file(GLOB TOOL_SOURCES CONFIGURE_DEPENDS ${PDCPP_BUILDSUPPORT_DIR}/hosttools/*)
+    set(COMMON ${PDCPP_BUILDSUPPORT_DIR}/../examples/common)
+    ExternalProject_Add_StepDependencies(pdcpp_host_tools build
+        ${TOOL_SOURCES}
+        ${COMMON}/inc/LzDecoder.h ${COMMON}/src/LzDecoder.cpp
+        ${COMMON}/inc/SvgLoader.h ${COMMON}/src/SvgParser.cpp ${COMMON}/inc/SimpleMath.h
+        ${PDCPP_BUILDSUPPORT_DIR}/../inc/pdcpp/pdhash.h
+    )
+endfunction()
+
 function(add_playdate_application PLAYDATE_GAME_NAME)
     message(STATUS "Adding playdate application ${PLAYDATE_GAME_NAME}")
 
@@ -7,6 +47,14 @@ function(add_playdate_application PLAYDATE_GAME_NAME)
       set(PDCPP_STAGING_DIR ${CMAKE_CURRENT_SOURCE_DIR})
     endif ()
 
+    # Folder compiled by pdc. Packing assets stages a copy of Source, without
+    # the packed files and with the archive, in the binary dir.
+    if (PDCPP_PACK_ASSETS)
+        set(PDCPP_PDC_SOURCE ${CMAKE_CURRENT_BINARY_DIR}/Source)
+    else ()
+        set(PDCPP_PDC_SOURCE ${PDCPP_STAGING_DIR}/Source)
+    endif ()
+
     if (TOOLCHAIN STREQUAL "armgcc")
         add_executable(${PLAYDATE_GAME_NAME})
 
@@ -16,19 +64,19 @@ function(add_playdate_application PLAYDATE_GAME_NAME)
             TARGET ${PLAYDATE_GAME_NAME} POST_BUILD
             COMMAND ${CMAKE_COMMAND} -E copy
             ${CMAKE_CURRENT_BINARY_DIR}/${BUILD_SUB_DIR}${PLAYDATE_GAME_NAME}.elf
-            ${PDCPP_STAGING_DIR}/Source/pdex.elf
+            ${PDCPP_PDC_SOURCE}/pdex.elf
         )
 
         add_custom_command(
             TARGET ${PLAYDATE_GAME_NAME} POST_BUILD
             COMMAND ${CMAKE_STRIP} --strip-unneeded -R .comment -g
             ${PLAYDATE_GAME_NAME}.elf
-            -o ${PDCPP_STAGING_DIR}/Source/pdex.elf
+            -o ${PDCPP_PDC_SOURCE}/pdex.elf
         )
 
         add_custom_command(
             TARGET ${PLAYDATE_GAME_NAME} POST_BUILD
-            COMMAND ${PDC} Source ${PLAYDATE_GAME_NAME}.pdx
+            COMMAND ${PDC} ${PDCPP_PDC_SOURCE} ${PLAYDATE_GAME_NAME}.pdx
             WORKING_DIRECTORY ${PDCPP_STAGING_DIR}
         )
 
@@ -37,6 +85,11 @@ function(add_playdate_application PLAYDATE_GAME_NAME)
             ${PDCPP_STAGING_DIR}/${PLAYDATE_GAME_NAME}.pdx
         )
 
+    elseif (PDCPP_HOST_BUILD)
+        # Native executable, main() comes from playdate_sdk. Run it from the
+        # application directory or point --source at its Source folder.
+        add_executable(${PLAYDATE_GAME_NAME})
+
     else ()
         add_library(${PLAYDATE_GAME_NAME} SHARED)
 
@@ -53,13 +106,13 @@ function(add_playdate_application PLAYDATE_GAME_NAME)
                     TARGET ${PLAYDATE_GAME_NAME} POST_BUILD
                     COMMAND ${CMAKE_COMMAND} -E copy
                     ${CMAKE_CURRENT_BINARY_DIR}/${BUILD_SUB_DIR}${PLAYDATE_GAME_NAME}.dll
-                    ${PDCPP_STAGING_DIR}/Source/pdex.dll)
+                    ${PDCPP_PDC_SOURCE}/pdex.dll)
         elseif (MINGW)
             add_custom_command(
                     TARGET ${PLAYDATE_GAME_NAME} POST_BUILD
                     COMMAND ${CMAKE_COMMAND} -E copy
                     ${CMAKE_CURRENT_BINARY_DIR}/lib${PLAYDATE_GAME_NAME}.dll
-                    ${PDCPP_STAGING_DIR}/Source/pdex.dll)
+                    ${PDCPP_PDC_SOURCE}/pdex.dll)
         elseif(APPLE)
             if(${CMAKE_GENERATOR} MATCHES "Xcode" )
                 set(BUILD_SUB_DIR $<CONFIG>/)
@@ -71,14 +124,14 @@ function(add_playdate_application PLAYDATE_GAME_NAME)
                 TARGET ${PLAYDATE_GAME_NAME} POST_BUILD
                 COMMAND ${CMAKE_COMMAND} -E copy
                 ${CMAKE_CURRENT_BINARY_DIR}/${BUILD_SUB_DIR}lib${PLAYDATE_GAME_NAME}.dylib
-                ${PDCPP_STAGING_DIR}/Source/pdex.dylib)
+                ${PDCPP_PDC_SOURCE}/pdex.dylib)
 
         elseif(UNIX)
             add_custom_command(
                 TARGET ${PLAYDATE_GAME_NAME} POST_BUILD
                 COMMAND ${CMAKE_COMMAND} -E copy
                 ${CMAKE_CURRENT_BINARY_DIR}/lib${PLAYDATE_GAME_NAME}.so
-                ${PDCPP_STAGING_DIR}/Source/pdex.so)
+                ${PDCPP_PDC_SOURCE}/pdex.so)
         else()
             message(FATAL_ERROR "Platform not supported!")
         endif()
@@ -90,9 +143,136 @@ function(add_playdate_application PLAYDATE_GAME_NAME)
 
         add_custom_command(
             TARGET ${PLAYDATE_GAME_NAME} POST_BUILD
-            COMMAND ${PDC} ${PDCPP_STAGING_DIR}/Source
+            COMMAND ${PDC} ${PDCPP_PDC_SOURCE}
             ${PDCPP_STAGING_DIR}/${PLAYDATE_GAME_NAME}.pdx)
     endif()
 
     target_link_libraries(${PLAYDATE_GAME_NAME} PUBLIC pdcpp_core)
+
+    if (PDCPP_PACK_ASSETS)
+        # Data files packed in assets.pak, the others copied next to it, in
+        # the folder pdc compiles (the source tree is left alone)
+        set(PAK ${PDCPP_PDC_SOURCE}/assets.pak)
+        file(GLOB_RECURSE PAK_INPUTS CONFIGURE_DEPENDS ${CMAKE_CURRENT_SOURCE_DIR}/Source/*)
+        list(FILTER PAK_INPUTS EXCLUDE REGEX "/pdex\\.[a-z]+$|/Source/assets\\.pak$")
+        list(JOIN PDCPP_PACK_PATTERNS "|" PAK_PATTERNS)
+        set(PAK_COMPRESSOR "")
+        set(PAK_TOOLS "")
+        if (PDCPP_PACK_COMPRESS)
+            pdcpp_host_tools()
+            set(PAK_COMPRESSOR ${PDCPP_LZ_COMPRESSOR})
+            set(PAK_TOOLS ${PDCPP_LZ_COMPRESSOR} pdcpp_host_tools)
+        endif ()
+        # Less the files compiled in by add_playdate_embedded_assets()
+        add_custom_command(
+            OUTPUT ${PAK}
+            COMMAND ${CMAKE_COMMAND} -DSOURCE=${CMAKE_CURRENT_SOURCE_DIR}/Source -DSTAGE=${PDCPP_PDC_SOURCE}
+                -DPATTERNS=${PAK_PATTERNS} -DCOMPRESSOR=${PAK_COMPRESSOR}
+                "-DEXCLUDE=$<JOIN:$<TARGET_PROPERTY:${PLAYDATE_GAME_NAME},PDCPP_EMBEDDED_FILES>,|>"
+                -P ${PDCPP_BUILDSUPPORT_DIR}/PackAssets.cmake
+            DEPENDS ${PAK_INPUTS} ${PAK_TOOLS} ${PDCPP_BUILDSUPPORT_DIR}/PackAssets.cmake
+            COMMENT "Packing the assets of ${PLAYDATE_GAME_NAME}"
+            VERBATIM
+        )
+        add_custom_target(${PLAYDATE_GAME_NAME}_pak DEPENDS ${PAK})
+        add_dependencies(${PLAYDATE_GAME_NAME} ${PLAYDATE_GAME_NAME}_pak)
+    endif ()
+
+    if (NOT PDCPP_LOG_LEVEL STREQUAL "OFF")
+        # Formats of the binary log (pdlog.h), for `pdlog print`. Scanned again
+        # when one of the sources changes; the table itself is only rewritten
+        # when a format changes, the stamp tells when it was last checked.
+        pdcpp_host_tools()
+        set(LOG_SOURCES "")
+        foreach (DIR ${CMAKE_CURRENT_SOURCE_DIR} ${PDCPP_LOG_SOURCE_DIRS})
+            file(GLOB_RECURSE FOUND CONFIGURE_DEPENDS
+                ${DIR}/*.c ${DIR}/*.cpp ${DIR}/*.h ${DIR}/*.hpp ${DIR}/*.hcpp)
+            list(APPEND LOG_SOURCES ${FOUND})
+        endforeach ()
+        set(LOG_TABLE ${CMAKE_CURRENT_BINARY_DIR}/${PLAYDATE_GAME_NAME}_log_formats.txt)
+        add_custom_command(
+            OUTPUT ${LOG_TABLE}.stamp
+            BYPRODUCTS ${LOG_TABLE}
+            COMMAND ${PDCPP_LOG_TOOL} table ${LOG_TABLE} ${CMAKE_CURRENT_SOURCE_DIR} ${PDCPP_LOG_SOURCE_DIRS}
+            COMMAND ${CMAKE_COMMAND} -E touch ${LOG_TABLE}.stamp
+            DEPENDS ${LOG_SOURCES} ${PDCPP_LOG_TOOL} pdcpp_host_tools
+            COMMENT "Scanning the log formats of ${PLAYDATE_GAME_NAME}"
+            VERBATIM
+        )
+        add_custom_target(${PLAYDATE_GAME_NAME}_log_formats DEPENDS ${LOG_TABLE}.stamp)
+        add_dependencies(${PLAYDATE_GAME_NAME} ${PLAYDATE_GAME_NAME}_log_formats)
+    endif ()
+
+    if (PDCPP_STACK_USAGE)
+        # One report per application: the objects of the other ones are left out
+        set_property(TARGET pdcpp_core APPEND PROPERTY PDCPP_APPLICATION_DIRS ${CMAKE_CURRENT_BINARY_DIR})
+        add_custom_target(${PLAYDATE_GAME_NAME}_stack_report
+            COMMAND ${CMAKE_COMMAND} -DBUILD_DIR=${CMAKE_BINARY_DIR}
+                -DAPPLICATION_DIR=${CMAKE_CURRENT_BINARY_DIR}
+                "-DAPPLICATION_DIRS=$<JOIN:$<TARGET_PROPERTY:pdcpp_core,PDCPP_APPLICATION_DIRS>,|>"
+                -DSTACK_SIZE=${STACK_SIZE}
+                -DOUTPUT=${CMAKE_CURRENT_BINARY_DIR}/stack_report.txt
+                -P ${PDCPP_BUILDSUPPORT_DIR}/StackUsageReport.cmake
+            DEPENDS ${PLAYDATE_GAME_NAME}
+            COMMENT "Summarizing the stack usage of ${PLAYDATE_GAME_NAME}"
+            VERBATIM
+        )
+    endif ()
+endfunction()
+
+# add_playdate_embedded_assets(<application>
+#     [TEXTURES <tga>...] [POLYLINES <svg>...] [BINARIES <file>...] [ALIGN <bytes>])
+#
+# Compiles files that never change into the game (examples/common/inc/Embedded.h):
+# a header per file, named after it, with a constexpr embedded::<name> and its
+# arrays, aligned to ALIGN bytes (16 by default).
+#   TEXTURES   8 bpp grayscale TGA -> EmbeddedTexture
+#   POLYLINES  SVG paths, flattened as svgParsePath() does -> EmbeddedPolylines
+#   BINARIES   any file, as it is -> EmbeddedBinary
+# Paths are relative to the application directory. <name> is the file name
+# without its extension, as a C identifier (level-1.svg: level_1). The files
+# of Source/ embedded this way are left out of assets.pak.
+function(add_playdate_embedded_assets PLAYDATE_GAME_NAME)
+    cmake_parse_arguments(EMBED "" "ALIGN" "TEXTURES;POLYLINES;BINARIES" ${ARGN})
+    if (NOT EMBED_ALIGN)
+        set(EMBED_ALIGN 16)
+    endif ()
+    pdcpp_host_tools()
+
+    set(DIR ${CMAKE_CURRENT_BINARY_DIR}/embedded)
+    file(MAKE_DIRECTORY ${DIR})
+    set(KIND_TEXTURES texture)
+    set(KIND_POLYLINES polylines)
+    set(KIND_BINARIES binary)
+    set(NAMES "")
+    set(HEADERS "")
+    foreach (GROUP TEXTURES POLYLINES BINARIES)
+        foreach (FILE ${EMBED_${GROUP}})
+            get_filename_component(INPUT ${FILE} ABSOLUTE)
+            get_filename_component(NAME ${FILE} NAME_WE)
+            string(MAKE_C_IDENTIFIER "${NAME}" NAME)
+            if (NAME IN_LIST NAMES)
+                message(FATAL_ERROR "add_playdate_embedded_assets(${PLAYDATE_GAME_NAME}): more than one file named ${NAME}")
+            endif ()
+            list(APPEND NAMES ${NAME})
+
+            add_custom_command(
+                OUTPUT ${DIR}/${NAME}.h
+                COMMAND ${PDCPP_EMBEDDER} ${KIND_${GROUP}} ${INPUT} ${DIR}/${NAME}.h ${NAME} ${EMBED_ALIGN}
+                DEPENDS ${INPUT} ${PDCPP_EMBEDDER} pdcpp_host_tools
+                COMMENT "Embedding ${FILE} in ${PLAYDATE_GAME_NAME}"
+                VERBATIM
+            )
+            list(APPEND HEADERS ${DIR}/${NAME}.h)
+
+            # Not packed in assets.pak as well (PDCPP_PACK_ASSETS)
+            file(RELATIVE_PATH PACKED ${CMAKE_CURRENT_SOURCE_DIR}/Source ${INPUT})
+            if (NOT PACKED MATCHES "^\\.\\./")
+                set_property(TARGET ${PLAYDATE_GAME_NAME} APPEND PROPERTY PDCPP_EMBEDDED_FILES ${PACKED})
+            endif ()
+        endforeach ()
+    endforeach ()
+
+    target_sources(${PLAYDATE_GAME_NAME} PRIVATE ${HEADERS})
+    target_include_directories(${PLAYDATE_GAME_NAME} PRIVATE ${DIR})
 endfunction()
@@ -18,7 +18,8 @@ class Application
 public: 
     explicit Application(PlaydateAPI* api);
     void Initialize();
-    void Update();
+    // Returns false when the screen didn't change (see playdate_cpp_app.hcpp)
+    bool Update();
     void Finalize();
 
     // Reference time of the application in seconds
@@ -1,4 +1,5 @@
 #pragma once
 
 
-void test(float Time);
\ No newline at end of file
+// Returns true when the screen was redrawn
+bool test(float Time);
\ No newline at end of file
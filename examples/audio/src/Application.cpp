@@ -3,6 +3,7 @@
 #include "Audio.h"
 
 #include <pd_api.h>
+#include <pdcpp/pdprofile.h>
 #include <math.h>
 #include <assert.h>
 
@@ -47,15 +48,18 @@ void Application::Finalize()
 
 
 //******************************************************************************
-void Application::Update()
+bool Application::Update()
 {    
     GlobalTime = pd->system->getElapsedTime();
-    pd->graphics->clear(kColorWhite);
 
-    test(GlobalTime);
-
-    pd->graphics->setFont(Font);
-    pd->system->drawFPS(0, 240-14);
+    // A menu: only redrawn when the selection changes
+    bool changed = test(GlobalTime);
+    if (changed)
+    {
+        pd->graphics->setFont(Font);
+        PDCPP_PROFILE_HUD(pd, 0, 240-14);
+    }
 
     ++FrameCount;
+    return changed;
 }
\ No newline at end of file
@@ -4,6 +4,8 @@
 #include "SvgLoader.h"
 
 #include <pd_api.h>
+#include <pdcpp/pdlazy.h>
+#include <pdcpp/pdprofile.h>
 #include <assert.h>
 #include <float.h>
 #include <vector>
@@ -614,7 +616,9 @@ inline void Sfx_GrazeMid()   { Sfx_GrazeCrackle(0.55f); }
 inline void Sfx_GrazeBoost() { Sfx_GrazeCrackle(0.85f); }
 
 // Remplacer l'initialisation du vector 'sounds' par cette version étendue (ajoute le vent)
-static std::vector< std::pair<std::string, std::function<void(void)> > > sounds = {
+// Built on first use: 40 strings and std::function don't need to slow down the launch
+using SoundList = std::vector< std::pair<std::string, std::function<void(void)> > >;
+static pdcpp::Lazy<SoundList> sounds([]{ return SoundList{
     {"Bleep",      [](){ Sfx_Bleep(); }},
     {"Explosion",  [](){ Sfx_Explosion(); }},
     {"Laser",      [](){ Sfx_Laser(); }},
@@ -662,14 +666,21 @@ static std::vector< std::pair<std::string, std::function<void(void)> > > sounds
     {"Graze Soft",  [](){ Sfx_GrazeSoft(); }},
     {"Graze Mid",   [](){ Sfx_GrazeMid(); }},
     {"Graze Boost", [](){ Sfx_GrazeBoost(); }},
-};
+}; });
 
 
-void test(float t)
+static void trigger(int index)
+{
+    PDCPP_PROFILE_SCOPE("sfx trigger");
+    (*sounds)[index].second();
+}
+
+bool test(float t)
 {
     PlaydateAPI* pd = _G.pd;
     static bool sInit = false;
     static int soundIndex = 0;
+    static int sDrawnIndex = -1;
     if (!sInit)
     {
         sInit = true;
@@ -680,26 +691,33 @@ void test(float t)
     pd->system->getButtonState(&current, &pushed, &released);
     if (pushed & kButtonUp)
     {
-        soundIndex = ++soundIndex % sounds.size();
-        sounds[soundIndex].second();
+        soundIndex = ++soundIndex % sounds->size();
+        trigger(soundIndex);
     }
 
     if (pushed & kButtonDown)
     {
         if(soundIndex == 0)
-            soundIndex = (int)sounds.size() - 1;
+            soundIndex = (int)sounds->size() - 1;
         --soundIndex;
 
-        sounds[soundIndex].second();
+        trigger(soundIndex);
     }
 
     if(current & kButtonA)
     {
-        sounds[soundIndex].second();
+        trigger(soundIndex);
+    }
+
+    if (soundIndex == sDrawnIndex)
+    {
+        return false;
     }
+    sDrawnIndex = soundIndex;
 
     pd->graphics->clear(kColorWhite);
     
-    pd->graphics->drawText(sounds[soundIndex].first.c_str(), strlen(sounds[soundIndex].first.c_str()), kASCIIEncoding, 10, 10);
+    pd->graphics->drawText((*sounds)[soundIndex].first.c_str(), strlen((*sounds)[soundIndex].first.c_str()), kASCIIEncoding, 10, 10);
+    return true;
 }
 
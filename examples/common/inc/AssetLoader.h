@@ -0,0 +1,197 @@
+#pragma once
+
+#include "SimpleMath.h"
+#include "LzDecoder.h"
+#include "PakFile.h"
+
+#include <pd_api.h>
+#include <pdcpp/pdcontainers.h>
+#include <pdcpp/pdhash.h>
+#include <pdcpp/pdtask.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <deque>
+#include <vector>
+
+//******************************************************************************
+// Asset types
+//******************************************************************************
+using Polygons = std::vector<std::vector<vec2>>;
+
+// 8 bpp grayscale TGA (ImageLoader.h)
+struct GrayTexture
+{
+    uint8_t* Pixels = nullptr;
+    int Width = 0;
+    int Height = 0;
+};
+
+enum class AssetState : uint8_t
+{
+    Queued,
+    Loading,
+    Ready,
+    Failed,
+    Unloaded
+};
+
+// Typed slot of an AssetLoader, -1 when the request couldn't be queued
+template <typename T>
+struct AssetHandle
+{
+    int Slot = -1;
+
+    bool Valid() const { return Slot >= 0; }
+};
+
+//******************************************************************************
+// Class definition
+//******************************************************************************
+/**
+ * Loads assets in the background, a step at a time: one bitmap or font, or a
+ * chunk of ChunkBytes of a file (TGA, SVG). The loader runs as a pdcpp::Task
+ * spawned with the first request, and leaves the frame after `frameBudgetUs`
+ * of steps. Progress() drives a loading screen; Get() returns the asset once
+ * it is Ready and nullptr until then.
+ *
+ * It is also the cache of these assets. Paths are keyed by their hash, taken
+ * at compile time for literals (pdcpp::HashedString): loading a path again
+ * returns the same slot and counts one more reference, Release() gives one
+ * back. An asset nobody references stays loaded until the memory is needed
+ * (least recently used first) or Trim() is called at the end of a scene.
+ *
+ * The memory of the assets is charged against `budgetBytes`: a request that
+ * would go over, even after evicting the unreferenced assets, fails (logged)
+ * instead of loading. Bitmaps are charged their pixels (and mask) once
+ * loaded, textures their pixels, levels the file while reading it then their
+ * points. Fonts aren't counted, the API doesn't tell, and are never evicted:
+ * it can't free them either.
+ *
+ * Entries stored compressed in the archive are decoded as their chunks come
+ * in, straight into the memory of the asset: the texture holds the whole TGA
+ * while loading, the pixels are moved to the front at the end. The chunk
+ * itself goes through a ChunkBytes buffer, allocated while decoding and not
+ * charged to the budget.
+ *
+ * The loader has to outlive its task: a global, a static or a member of the
+ * Application, the app framework clears the tasks before Finalize().
+ */
+class AssetLoader
+{
+public:
+    static constexpr int ChunkBytes = 8 * 1024;
+    static constexpr int MaxPath = 64;
+
+    explicit AssetLoader(size_t budgetBytes, uint32_t frameBudgetUs = 2000);
+    ~AssetLoader();
+
+    AssetLoader(const AssetLoader&) = delete;
+    AssetLoader& operator=(const AssetLoader&) = delete;
+
+    // pd->graphics->loadBitmap
+    AssetHandle<LCDBitmap> LoadBitmap(pdcpp::HashedString path);
+    // pd->graphics->loadFont
+    AssetHandle<LCDFont> LoadFont(pdcpp::HashedString path);
+    // read_tga_file_grayscale, in chunks
+    AssetHandle<GrayTexture> LoadTexture(pdcpp::HashedString path);
+    // svgParsePath, the file in chunks then the parse in one step
+    AssetHandle<Polygons> LoadPolygons(pdcpp::HashedString path);
+
+    AssetState State(int slot) const;
+    template <typename T>
+    AssetState State(AssetHandle<T> handle) const { return State(handle.Slot); }
+
+    LCDBitmap* Get(AssetHandle<LCDBitmap> handle) const;
+    LCDFont* Get(AssetHandle<LCDFont> handle) const;
+    const GrayTexture* Get(AssetHandle<GrayTexture> handle) const;
+    const Polygons* Get(AssetHandle<Polygons> handle) const;
+
+    // One reference less. The last one cancels a request still queued or
+    // loading, a loaded asset stays cached until evicted.
+    void Release(int slot);
+    template <typename T>
+    void Release(AssetHandle<T> handle) { Release(handle.Slot); }
+
+    // Textures and levels found in the archive are read from it, through its
+    // open handle (and decompressed), the others from their file. nullptr to stop.
+    void UsePak(PakFile* pak) { Pak = pak; }
+
+    // Frees the assets nobody references
+    void Trim();
+    // Frees everything, references or not, drops the requests not loaded yet
+    void Clear();
+
+    // Nothing queued or loading
+    bool Done() const { return Pending == 0; }
+    // 0..1 over the requests since the loader was last Done()
+    float Progress() const;
+    // Outline and filled part of Progress(), for a loading screen
+    void DrawProgress(int x, int y, int width, int height) const;
+
+    size_t Used() const { return UsedBytes; }
+    size_t Budget() const { return BudgetBytes; }
+
+private:
+    enum class Kind : uint8_t
+    {
+        Bitmap,
+        Font,
+        Texture,
+        Polygons
+    };
+
+    struct Entry
+    {
+        Kind Type;
+        AssetState Status = AssetState::Queued;
+        char Path[MaxPath];
+        uint16_t Refs = 0;
+        uint32_t LastUse = 0;   // Uses when last loaded or released, for the LRU
+        size_t Bytes = 0;       // charged to the budget
+        int Size = 0;           // chunked reads: bytes to read, and read so far
+        int Read = 0;
+        int Unpacked = 0;       // bytes of Data, Size unless compressed
+        SDFile* File = nullptr;
+        int PakEntry = -1;      // read from the pak instead of File
+        int PakOffset = 0;      // of the first byte to read in the entry
+        bool Compressed = false;
+        LzDecoder Decoder;
+        uint32_t Hash = 0;
+        uint8_t* Data = nullptr;
+        LCDBitmap* Bitmap = nullptr;
+        LCDFont* Font = nullptr;
+        GrayTexture Texture;
+        Polygons Shapes;
+    };
+
+    int Queue(Kind type, pdcpp::HashedString path);
+    pdcpp::Task Pump();
+    // Loads a bit of the oldest request. False once nothing is left.
+    bool Step();
+    void Open(Entry& entry);
+    void ReadChunk(Entry& entry);
+    // The TGA decoded in Data to the pixels of the texture
+    bool UnpackTexture(Entry& entry);
+    void Finish(Entry& entry, AssetState status);
+    // Evicts unreferenced assets if needed, fails the entry if it still doesn't fit
+    bool Charge(Entry& entry, size_t bytes);
+    bool Evict(size_t bytes);
+    void Fail(Entry& entry, const char* reason);
+    void Free(Entry& entry);
+
+    // Get() hands out pointers into the entries: a deque doesn't move them.
+    // An entry per distinct path, reloaded in place after an eviction.
+    std::deque<Entry> Entries;
+    pdcpp::FlatMap<uint32_t, int, 64, pdcpp::Overflow::Heap> Slots;
+    PakFile* Pak = nullptr;
+    uint8_t* Chunk = nullptr;   // compressed reads, ChunkBytes
+    size_t BudgetBytes;
+    size_t UsedBytes = 0;
+    uint32_t FrameBudgetUs;
+    uint32_t Uses = 0;
+    int Pending = 0;
+    size_t Next = 0;            // oldest entry maybe not loaded yet
+    int BatchCount = 0;         // requests since the loader was last Done(), for Progress()
+    int BatchDone = 0;
+    bool Pumping = false;
+};
@@ -0,0 +1,65 @@
+#pragma once
+
+#include "SimpleMath.h"
+
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+//******************************************************************************
+// Assets compiled into the game
+//******************************************************************************
+// add_playdate_embedded_assets() (cmake/AddPlaydateApplication.cmake) writes a
+// header per file with a constexpr instance of one of these, in namespace
+// `embedded`:
+//   #include "BlueNoise.h"
+//   const uint8_t* noise = embedded::BlueNoise.Pixels;
+// The data is in .rodata, converted at build time: nothing to open, allocate
+// or parse at run time.
+
+// 8 bpp grayscale TGA, the pixels without the header (GrayTexture of AssetLoader.h)
+struct EmbeddedTexture
+{
+    const uint8_t* Pixels;
+    int Width;
+    int Height;
+};
+
+struct EmbeddedPolyline
+{
+    const vec2* Points;
+    int Count;
+};
+
+// The paths of an SVG, flattened as svgParsePath() does
+struct EmbeddedPolylines
+{
+    const vec2* Points;         // of all the polylines, one after the other
+    const uint32_t* Ends;       // index in Points past the last point of each polyline
+    int Count;
+
+    constexpr EmbeddedPolyline operator[](int index) const
+    {
+        uint32_t start = index > 0 ? Ends[index - 1] : 0;
+        return { Points + start, int(Ends[index] - start) };
+    }
+
+    // A copy, for the code that moves the points (same type as svgParsePath())
+    std::vector<std::vector<vec2>> ToPolygons() const
+    {
+        std::vector<std::vector<vec2>> polygons(Count);
+        for (int i = 0; i < Count; ++i)
+        {
+            EmbeddedPolyline polyline = (*this)[i];
+            polygons[i].assign(polyline.Points, polyline.Points + polyline.Count);
+        }
+        return polygons;
+    }
+};
+
+// Any file, as it is
+struct EmbeddedBinary
+{
+    const uint8_t* Data;
+    size_t Size;
+};
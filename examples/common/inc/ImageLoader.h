@@ -2,4 +2,12 @@
 
 #include <stdint.h>
 
-uint8_t* read_tga_file_grayscale(const char* path, int* out_w, int* out_h);
\ No newline at end of file
+#include <pd_api.h>
+
+uint8_t* read_tga_file_grayscale(const char* path, int* out_w, int* out_h);
+
+// Checks the header of an 8 bpp grayscale TGA in memory. Returns the offset of the pixels, -1 if it isn't one.
+int tga_header_grayscale(const void* data, int size, int* out_w, int* out_h);
+
+// Reads and checks the header of an 8 bpp grayscale TGA, leaves the file at the pixels
+bool read_tga_header_grayscale(SDFile* file, int* out_w, int* out_h);
\ No newline at end of file
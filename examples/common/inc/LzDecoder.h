@@ -0,0 +1,71 @@
+#pragma once
+
+#include <stdint.h>
+
+// LZ4 block format, written by pdlz (buildsupport/hosttools, on the build
+// machine) for the compressed entries of the asset archive. A stream is a
+// list of sequences:
+//   token             high 4 bits: literal count, low 4 bits: match length - LZ_MIN_MATCH
+//   [255...] n        counts of 15 go on in the next bytes, added up until one isn't 255
+//   literals
+//   offset            2 bytes little endian, back from the current output, 1..65535
+//   [255...] n        match length, as the literal count
+// The last sequence stops after its literals: it ends the output.
+#define LZ_MIN_MATCH 4
+#define LZ_MAX_OFFSET 65535
+// The last match starts at least LZ_MATCH_LIMIT bytes before the end, and the
+// last LZ_LAST_LITERALS bytes are literals (the limits of the LZ4 format)
+#define LZ_MATCH_LIMIT 12
+#define LZ_LAST_LITERALS 5
+
+//******************************************************************************
+// Class definition
+//******************************************************************************
+/**
+ * Streaming decoder: the stream comes in pieces of any size (the chunks read
+ * from the archive), the output goes straight to its final buffer. Matches
+ * copy from the bytes already decoded in that buffer, so there is no window
+ * to keep: the buffer has to hold the whole output, e.g. the pixels of a
+ * texture. It doesn't allocate and doesn't depend on the Playdate API (the
+ * compressor checks its output with it).
+ */
+class LzDecoder
+{
+public:
+    // The output is exactly `size` bytes
+    void Begin(uint8_t* output, int size);
+    // Decodes the next `bytes` of the stream. False if the stream is corrupt or
+    // goes on after the output is complete.
+    bool Feed(const uint8_t* input, int bytes);
+
+    bool Done() const { return Current == State::Done; }
+    int Decoded() const { return int(Out - Start); }
+
+private:
+    enum class State : uint8_t
+    {
+        Token,
+        LiteralCount,
+        Literals,
+        Offset,
+        OffsetHigh,
+        MatchLength,
+        Done,
+        Error
+    };
+
+    bool Copy();
+    bool Match();
+
+    uint8_t* Start = nullptr;
+    uint8_t* Out = nullptr;
+    uint8_t* End = nullptr;
+    int Literals = 0;           // left to copy
+    int Length = 0;             // of the match
+    int Distance = 0;
+    State Current = State::Error;
+};
+
+// Whole stream in one call. Returns the bytes decoded, -1 if the stream is
+// corrupt or doesn't decode to exactly `size` bytes.
+int lz_decode(const uint8_t* input, int bytes, uint8_t* output, int size);
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <pd_api.h>
+#include <pdcpp/pdhash.h>
+#include <stdint.h>
+#include <vector>
+
+//******************************************************************************
+// Class definition
+//******************************************************************************
+/**
+ * Reader of the archives of buildsupport/PackAssets.cmake. Open() reads the
+ * index once and keeps the file open: every read afterwards is a seek and a
+ * read on that handle, no more pd->file->open per asset. Entries are looked
+ * up by the hash of their path (binary search on the sorted index), the path
+ * itself is compared to rule out a collision.
+ *
+ * An entry may be stored LZ compressed (LzDecoder.h): Read() and Seek() give
+ * the stored bytes, Load() the unpacked ones.
+ */
+class PakFile
+{
+public:
+    PakFile() = default;
+    ~PakFile() { Close(); }
+
+    PakFile(const PakFile&) = delete;
+    PakFile& operator=(const PakFile&) = delete;
+
+    // False if the file is missing, or (logged) isn't an archive
+    bool Open(const char* path);
+    void Close();
+    bool IsOpen() const { return File != nullptr; }
+
+    // Index of the entry, -1 if the archive doesn't have it
+    int Find(pdcpp::HashedString path) const { return Find(path.Hash, path.Text); }
+    int Find(uint32_t hash, const char* path) const;
+
+    int Count() const { return int(Entries.size()); }
+    const char* Path(int entry) const { return Entries[entry].Path; }
+    // Of the file that was packed
+    int Size(int entry) const { return int(Entries[entry].Unpacked); }
+    // In the archive
+    int StoredSize(int entry) const { return int(Entries[entry].Size); }
+    bool Compressed(int entry) const { return Entries[entry].Size != Entries[entry].Unpacked; }
+    // From the start of the archive
+    int Offset(int entry) const { return int(Entries[entry].Offset); }
+
+    // Up to `bytes` of the stored entry from `offset` into `buffer`. Returns the bytes read, -1 on error.
+    int Read(int entry, int offset, void* buffer, int bytes);
+    // The whole file, decompressed straight into `buffer`. False if it doesn't
+    // fit in `capacity` bytes (Size()) or is corrupt.
+    bool Load(int entry, void* buffer, int capacity);
+
+    // The shared handle at `offset` in the entry, for readers taking an SDFile
+    // (they must not read past the entry). nullptr on error.
+    SDFile* Seek(int entry, int offset);
+
+private:
+    struct Entry
+    {
+        uint32_t Hash;
+        uint32_t Offset;
+        uint32_t Size;
+        uint32_t Unpacked;
+        const char* Path;   // in Index
+    };
+
+    SDFile* File = nullptr;
+    char* Index = nullptr;
+    std::vector<Entry> Entries;
+};
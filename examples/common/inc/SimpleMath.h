@@ -25,8 +25,8 @@ inline float RandomFloat01(uint32_t* state)
 struct vec2 {
     float x, y;
     vec2() = default;
-    vec2(float _x) : x(_x), y(_x) {}
-    vec2(float _x, float _y) : x(_x), y(_y) {}
+    constexpr vec2(float _x) : x(_x), y(_x) {}
+    constexpr vec2(float _x, float _y) : x(_x), y(_y) {}
     
     vec2 operator+(const vec2& v) const { return vec2(x + v.x, y + v.y); }
     vec2 operator-(const vec2& v) const { return vec2(x - v.x, y - v.y); }    
@@ -4,4 +4,7 @@
 #include <vector>
 
 // Parse svg and extract all path
-std::vector<std::vector<vec2>> svgParsePath(const char* filename);
\ No newline at end of file
+std::vector<std::vector<vec2>> svgParsePath(const char* filename);
+
+// Same on a document already in memory, null terminated, `size` bytes before the terminator
+std::vector<std::vector<vec2>> svgParsePathText(const char* text, size_t size);
\ No newline at end of file
@@ -0,0 +1,601 @@
+#include "AssetLoader.h"
+#include "Globals.h"
+#include "ImageLoader.h"
+#include "SvgLoader.h"
+
+#include <pdcpp/pdclock.h>
+#include <pdcpp/pdprofile.h>
+#include <stdlib.h>
+#include <string.h>
+
+//******************************************************************************
+AssetLoader::AssetLoader(size_t budgetBytes, uint32_t frameBudgetUs)
+: BudgetBytes(budgetBytes)
+, FrameBudgetUs(frameBudgetUs)
+{
+}
+
+//******************************************************************************
+AssetLoader::~AssetLoader()
+{
+    Clear();
+}
+
+//******************************************************************************
+AssetHandle<LCDBitmap> AssetLoader::LoadBitmap(pdcpp::HashedString path)
+{
+    return { Queue(Kind::Bitmap, path) };
+}
+
+AssetHandle<LCDFont> AssetLoader::LoadFont(pdcpp::HashedString path)
+{
+    return { Queue(Kind::Font, path) };
+}
+
+AssetHandle<GrayTexture> AssetLoader::LoadTexture(pdcpp::HashedString path)
+{
+    return { Queue(Kind::Texture, path) };
+}
+
+AssetHandle<Polygons> AssetLoader::LoadPolygons(pdcpp::HashedString path)
+{
+    return { Queue(Kind::Polygons, path) };
+}
+
+//******************************************************************************
+int AssetLoader::Queue(Kind type, pdcpp::HashedString path)
+{
+    int slot;
+    if (int* cached = Slots.find(path.Hash))
+    {
+        slot = *cached;
+        Entry& entry = Entries[slot];
+        if (entry.Type != type || strcmp(entry.Path, path.Text) != 0)
+        {
+            _G.pd->system->logToConsole("Can't load %s: same hash as %s", path.Text, entry.Path);
+            return -1;
+        }
+
+        ++entry.Refs;
+        entry.LastUse = ++Uses;
+        if (entry.Status != AssetState::Unloaded)
+        {
+            return slot;
+        }
+
+        // Evicted earlier: loaded again in the same slot
+        entry.Status = AssetState::Queued;
+        if (size_t(slot) < Next)
+        {
+            Next = slot;
+        }
+    }
+    else
+    {
+        if (strlen(path.Text) >= MaxPath)
+        {
+            _G.pd->system->logToConsole("Can't load %s: path longer than %d", path.Text, MaxPath - 1);
+            return -1;
+        }
+
+        slot = int(Entries.size());
+        if (Slots.try_emplace(path.Hash, slot) == nullptr)
+        {
+            _G.pd->system->logToConsole("Can't load %s: out of memory", path.Text);
+            return -1;
+        }
+
+        Entry& entry = Entries.emplace_back();
+        entry.Type = type;
+        entry.Hash = path.Hash;
+        strcpy(entry.Path, path.Text);
+        entry.Refs = 1;
+        entry.LastUse = ++Uses;
+    }
+
+    // A new batch for Progress()
+    if (Pending == 0)
+    {
+        BatchCount = 0;
+        BatchDone = 0;
+    }
+    ++BatchCount;
+    ++Pending;
+
+    if (!Pumping)
+    {
+        Pumping = true;
+        pdcpp::Tasks.Spawn(Pump());
+    }
+    return slot;
+}
+
+//******************************************************************************
+pdcpp::Task AssetLoader::Pump()
+{
+    uint32_t frame = pdcpp::Tasks.Frame();
+    uint32_t start = pdcpp_clock_us();
+    while (Step())
+    {
+        if (pdcpp_clock_us() - start >= FrameBudgetUs)
+        {
+            co_await pdcpp::NextFrame();
+        }
+        else
+        {
+            co_await pdcpp::Yield();
+        }
+
+        // The scheduler may also have run out of time and left it for the next frame
+        if (pdcpp::Tasks.Frame() != frame)
+        {
+            frame = pdcpp::Tasks.Frame();
+            start = pdcpp_clock_us();
+        }
+    }
+    free(Chunk);
+    Chunk = nullptr;
+    Pumping = false;
+}
+
+//******************************************************************************
+bool AssetLoader::Step()
+{
+    while (Next < Entries.size()
+        && Entries[Next].Status != AssetState::Queued
+        && Entries[Next].Status != AssetState::Loading)
+    {
+        ++Next;
+    }
+    if (Next == Entries.size())
+    {
+        return false;
+    }
+
+    Entry& entry = Entries[Next];
+    PDCPP_PROFILE_SCOPE_TEXT("load asset", entry.Path);
+    if (entry.Status == AssetState::Queued)
+    {
+        Open(entry);
+    }
+    else
+    {
+        ReadChunk(entry);
+    }
+    return Pending > 0;
+}
+
+//******************************************************************************
+void AssetLoader::Open(Entry& entry)
+{
+    PlaydateAPI* pd = _G.pd;
+    const char* err = nullptr;
+
+    switch (entry.Type)
+    {
+    case Kind::Bitmap:
+    {
+        entry.Bitmap = pd->graphics->loadBitmap(entry.Path, &err);
+        if (entry.Bitmap == nullptr)
+        {
+            Fail(entry, err ? err : "no message");
+            return;
+        }
+
+        int width, height, rowBytes;
+        uint8_t* mask = nullptr;
+        uint8_t* data = nullptr;
+        pd->graphics->getBitmapData(entry.Bitmap, &width, &height, &rowBytes, &mask, &data);
+        if (!Charge(entry, size_t(rowBytes) * height * (mask ? 2 : 1)))
+        {
+            return;
+        }
+        break;
+    }
+
+    case Kind::Font:
+        entry.Font = pd->graphics->loadFont(entry.Path, &err);
+        if (entry.Font == nullptr)
+        {
+            Fail(entry, err ? err : "no message");
+            return;
+        }
+        break;
+
+    case Kind::Texture:
+        if (Pak && (entry.PakEntry = Pak->Find(entry.Hash, entry.Path)) >= 0)
+        {
+            if (Pak->Compressed(entry.PakEntry))
+            {
+                // The header is decoded with the pixels, UnpackTexture() reads it
+                entry.Compressed = true;
+                entry.Size = Pak->StoredSize(entry.PakEntry);
+                entry.Unpacked = Pak->Size(entry.PakEntry);
+                break;
+            }
+
+            SDFile* file = Pak->Seek(entry.PakEntry, 0);
+            if (file == nullptr || !read_tga_header_grayscale(file, &entry.Texture.Width, &entry.Texture.Height))
+            {
+                Fail(entry, "not an 8 bpp grayscale TGA");
+                return;
+            }
+            entry.PakOffset = pd->file->tell(file) - Pak->Offset(entry.PakEntry);
+        }
+        else
+        {
+            entry.File = pd->file->open(entry.Path, kFileRead);
+            if (entry.File == nullptr)
+            {
+                Fail(entry, pd->file->geterr());
+                return;
+            }
+            if (!read_tga_header_grayscale(entry.File, &entry.Texture.Width, &entry.Texture.Height))
+            {
+                Fail(entry, "not an 8 bpp grayscale TGA");
+                return;
+            }
+        }
+        entry.Size = entry.Texture.Width * entry.Texture.Height;
+        entry.Unpacked = entry.Size;
+        break;
+
+    case Kind::Polygons:
+        if (Pak && (entry.PakEntry = Pak->Find(entry.Hash, entry.Path)) >= 0)
+        {
+            entry.Compressed = Pak->Compressed(entry.PakEntry);
+            entry.Size = Pak->StoredSize(entry.PakEntry);
+            entry.Unpacked = Pak->Size(entry.PakEntry);
+        }
+        else
+        {
+            FileStat stat;
+            if (pd->file->stat(entry.Path, &stat) != 0)
+            {
+                Fail(entry, pd->file->geterr());
+                return;
+            }
+            entry.File = pd->file->open(entry.Path, kFileRead);
+            if (entry.File == nullptr)
+            {
+                Fail(entry, pd->file->geterr());
+                return;
+            }
+            entry.Size = int(stat.size);
+            entry.Unpacked = entry.Size;
+        }
+        break;
+    }
+
+    if (entry.Type == Kind::Bitmap || entry.Type == Kind::Font)
+    {
+        Finish(entry, AssetState::Ready);
+        return;
+    }
+
+    // Room for the terminator of the SVG text
+    if (!Charge(entry, size_t(entry.Unpacked) + 1))
+    {
+        return;
+    }
+    entry.Data = static_cast<uint8_t*>(malloc(entry.Unpacked + 1));
+    if (entry.Data == nullptr)
+    {
+        Fail(entry, "out of memory");
+        return;
+    }
+    if (entry.Compressed)
+    {
+        if (Chunk == nullptr && (Chunk = static_cast<uint8_t*>(malloc(ChunkBytes))) == nullptr)
+        {
+            Fail(entry, "out of memory");
+            return;
+        }
+        entry.Decoder.Begin(entry.Data, entry.Unpacked);
+    }
+    entry.Status = AssetState::Loading;
+}
+
+//******************************************************************************
+void AssetLoader::ReadChunk(Entry& entry)
+{
+    PlaydateAPI* pd = _G.pd;
+
+    int wanted = entry.Size - entry.Read;
+    if (wanted > ChunkBytes)
+    {
+        wanted = ChunkBytes;
+    }
+    if (wanted > 0)
+    {
+        // Compressed entries are only in the pak
+        uint8_t* to = entry.Compressed ? Chunk : entry.Data + entry.Read;
+        int bytes = entry.PakEntry >= 0
+            ? Pak->Read(entry.PakEntry, entry.PakOffset + entry.Read, to, wanted)
+            : pd->file->read(entry.File, to, wanted);
+        if (bytes <= 0)
+        {
+            Fail(entry, bytes < 0 ? pd->file->geterr() : "file shorter than expected");
+            return;
+        }
+        if (entry.Compressed && !entry.Decoder.Feed(Chunk, bytes))
+        {
+            Fail(entry, "corrupt compressed data");
+            return;
+        }
+        entry.Read += bytes;
+        if (entry.Read < entry.Size)
+        {
+            return;
+        }
+    }
+    if (entry.Compressed && !entry.Decoder.Done())
+    {
+        Fail(entry, "compressed data shorter than expected");
+        return;
+    }
+
+    if (entry.File)
+    {
+        pd->file->close(entry.File);
+        entry.File = nullptr;
+    }
+
+    if (entry.Type == Kind::Texture)
+    {
+        if (entry.Compressed && !UnpackTexture(entry))
+        {
+            return;
+        }
+        entry.Texture.Pixels = entry.Data;
+        entry.Data = nullptr;
+    }
+    else
+    {
+        // The text goes back to the budget, the points are charged instead
+        entry.Data[entry.Unpacked] = '\0';
+        entry.Shapes = svgParsePathText(reinterpret_cast<const char*>(entry.Data), entry.Unpacked);
+        free(entry.Data);
+        entry.Data = nullptr;
+        UsedBytes -= entry.Bytes;
+        entry.Bytes = 0;
+
+        size_t bytes = entry.Shapes.capacity() * sizeof(std::vector<vec2>);
+        for (const std::vector<vec2>& shape : entry.Shapes)
+        {
+            bytes += shape.capacity() * sizeof(vec2);
+        }
+        if (!Charge(entry, bytes))
+        {
+            return;
+        }
+    }
+
+    Finish(entry, AssetState::Ready);
+}
+
+bool AssetLoader::UnpackTexture(Entry& entry)
+{
+    int offset = tga_header_grayscale(entry.Data, entry.Unpacked, &entry.Texture.Width, &entry.Texture.Height);
+    int pixels = entry.Texture.Width * entry.Texture.Height;
+    if (offset < 0 || entry.Unpacked - offset < pixels)
+    {
+        Fail(entry, "not an 8 bpp grayscale TGA");
+        return false;
+    }
+    // The pixels at the start of the allocation, freed as any texture
+    memmove(entry.Data, entry.Data + offset, pixels);
+    return true;
+}
+
+//******************************************************************************
+void AssetLoader::Finish(Entry& entry, AssetState status)
+{
+    entry.Status = status;
+    --Pending;
+    ++BatchDone;
+}
+
+//******************************************************************************
+bool AssetLoader::Charge(Entry& entry, size_t bytes)
+{
+    if (UsedBytes + bytes > BudgetBytes && !Evict(UsedBytes + bytes - BudgetBytes))
+    {
+        _G.pd->system->logToConsole("%s needs %d bytes, %d of %d used", entry.Path, int(bytes), int(UsedBytes), int(BudgetBytes));
+        Fail(entry, "over the memory budget");
+        return false;
+    }
+    UsedBytes += bytes;
+    entry.Bytes += bytes;
+    return true;
+}
+
+// Least recently used first. A scan of the entries: a game has tens of assets,
+// and this only runs when the budget is reached.
+bool AssetLoader::Evict(size_t bytes)
+{
+    // Nothing is evicted for a request that wouldn't fit anyway
+    size_t evictable = 0;
+    for (const Entry& entry : Entries)
+    {
+        if (entry.Refs == 0 && entry.Status == AssetState::Ready && entry.Type != Kind::Font)
+        {
+            evictable += entry.Bytes;
+        }
+    }
+    if (evictable < bytes)
+    {
+        return false;
+    }
+
+    size_t evicted = 0;
+    while (evicted < bytes)
+    {
+        Entry* oldest = nullptr;
+        for (Entry& entry : Entries)
+        {
+            if (entry.Refs == 0 && entry.Status == AssetState::Ready && entry.Type != Kind::Font
+                && (oldest == nullptr || int32_t(entry.LastUse - oldest->LastUse) < 0))
+            {
+                oldest = &entry;
+            }
+        }
+        if (oldest == nullptr)
+        {
+            return false;
+        }
+
+        evicted += oldest->Bytes;
+        Free(*oldest);
+        oldest->Status = AssetState::Unloaded;
+    }
+    return true;
+}
+
+//******************************************************************************
+void AssetLoader::Fail(Entry& entry, const char* reason)
+{
+    _G.pd->system->logToConsole("Can't load %s: %s", entry.Path, reason);
+    Free(entry);
+    Finish(entry, AssetState::Failed);
+}
+
+//******************************************************************************
+void AssetLoader::Free(Entry& entry)
+{
+    PlaydateAPI* pd = _G.pd;
+    if (entry.File)
+    {
+        pd->file->close(entry.File);
+        entry.File = nullptr;
+    }
+    if (entry.Bitmap)
+    {
+        pd->graphics->freeBitmap(entry.Bitmap);
+        entry.Bitmap = nullptr;
+    }
+    free(entry.Data);
+    entry.Data = nullptr;
+    free(entry.Texture.Pixels);
+    entry.Texture = {};
+    Polygons().swap(entry.Shapes);
+    entry.Size = 0;
+    entry.Read = 0;
+    entry.Unpacked = 0;
+    entry.PakEntry = -1;
+    entry.PakOffset = 0;
+    entry.Compressed = false;
+
+    UsedBytes -= entry.Bytes;
+    entry.Bytes = 0;
+}
+
+//******************************************************************************
+AssetState AssetLoader::State(int slot) const
+{
+    if (slot < 0 || slot >= int(Entries.size()))
+    {
+        return AssetState::Failed;
+    }
+    return Entries[slot].Status;
+}
+
+LCDBitmap* AssetLoader::Get(AssetHandle<LCDBitmap> handle) const
+{
+    return State(handle) == AssetState::Ready ? Entries[handle.Slot].Bitmap : nullptr;
+}
+
+LCDFont* AssetLoader::Get(AssetHandle<LCDFont> handle) const
+{
+    return State(handle) == AssetState::Ready ? Entries[handle.Slot].Font : nullptr;
+}
+
+const GrayTexture* AssetLoader::Get(AssetHandle<GrayTexture> handle) const
+{
+    return State(handle) == AssetState::Ready ? &Entries[handle.Slot].Texture : nullptr;
+}
+
+const Polygons* AssetLoader::Get(AssetHandle<Polygons> handle) const
+{
+    return State(handle) == AssetState::Ready ? &Entries[handle.Slot].Shapes : nullptr;
+}
+
+//******************************************************************************
+void AssetLoader::Release(int slot)
+{
+    if (slot < 0 || slot >= int(Entries.size()) || Entries[slot].Refs == 0)
+    {
+        return;
+    }
+
+    Entry& entry = Entries[slot];
+    entry.LastUse = ++Uses;
+    if (--entry.Refs == 0 && (entry.Status == AssetState::Queued || entry.Status == AssetState::Loading))
+    {
+        Free(entry);
+        Finish(entry, AssetState::Unloaded);
+    }
+}
+
+void AssetLoader::Trim()
+{
+    for (Entry& entry : Entries)
+    {
+        if (entry.Refs == 0 && entry.Status == AssetState::Ready && entry.Type != Kind::Font)
+        {
+            Free(entry);
+            entry.Status = AssetState::Unloaded;
+        }
+    }
+}
+
+void AssetLoader::Clear()
+{
+    if (_G.pd)
+    {
+        for (Entry& entry : Entries)
+        {
+            Free(entry);
+        }
+    }
+    Entries.clear();
+    Slots.clear();
+    free(Chunk);
+    Chunk = nullptr;
+    UsedBytes = 0;
+    Pending = 0;
+    Next = 0;
+    BatchCount = 0;
+    BatchDone = 0;
+}
+
+//******************************************************************************
+float AssetLoader::Progress() const
+{
+    if (BatchCount == 0)
+    {
+        return 1.0f;
+    }
+
+    float done = float(BatchDone);
+    if (Next < Entries.size())
+    {
+        const Entry& entry = Entries[Next];
+        if (entry.Status == AssetState::Loading && entry.Size > 0)
+        {
+            done += float(entry.Read) / float(entry.Size + 1);
+        }
+    }
+    return done / float(BatchCount);
+}
+
+void AssetLoader::DrawProgress(int x, int y, int width, int height) const
+{
+    PlaydateAPI* pd = _G.pd;
+    pd->graphics->drawRect(x, y, width, height, kColorBlack);
+    int filled = int(Progress() * float(width - 4));
+    if (filled > 0)
+    {
+        pd->graphics->fillRect(x + 2, y + 2, filled, height - 4, kColorBlack);
+    }
+}
@@ -3,7 +3,9 @@
 #include "ImageLoader.h"
 #include "Globals.h"
 #include <pd_api.h>
+#include <pdcpp/pdprofile.h>
 #include <assert.h>
+#include <string.h>
 
 typedef struct TgaHeader
 {
@@ -22,9 +24,54 @@ typedef struct TgaHeader
 static_assert(sizeof(TgaHeader) == 18, "TgaHeader should be 18 bytes");
 
 
+static bool check_tga_header_grayscale(const TgaHeader& header, int* out_w, int* out_h)
+{
+	if ((header.image_type != 3) // only support grayscale images
+		|| (header.bits_per_pixel != 8) // only support 8bpp
+		|| (header.width == 0 || header.width > 2048 || header.height == 0 || header.height > 2048) // out of bounds sizes
+		)
+	{
+		return false;
+	}
+
+	*out_w = header.width;
+	*out_h = header.height;
+	return true;
+}
+
+int tga_header_grayscale(const void* data, int size, int* out_w, int* out_h)
+{
+	*out_w = *out_h = 0;
+	TgaHeader header;
+	if (size < (int)sizeof(header))
+		return -1;
+
+	memcpy(&header, data, sizeof(header));
+	if (!check_tga_header_grayscale(header, out_w, out_h))
+		return -1;
+	return (int)sizeof(header) + header.id_size;
+}
+
+bool read_tga_header_grayscale(SDFile* file, int* out_w, int* out_h)
+{
+	PlaydateAPI* pd = _G.pd;
+
+	*out_w = *out_h = 0;
+	TgaHeader header;
+	int bytes = pd->file->read(file, &header, sizeof(header));
+	if (bytes != sizeof(header) || !check_tga_header_grayscale(header, out_w, out_h))
+	{
+		return false;
+	}
+
+	pd->file->seek(file, header.id_size, SEEK_CUR);
+	return true;
+}
+
 uint8_t* read_tga_file_grayscale(const char* path, int* out_w, int* out_h)
 {
     PlaydateAPI* pd = _G.pd;
+    PDCPP_PROFILE_SCOPE_TEXT("load tga", path);
 
 	*out_w = *out_h = 0;
 	SDFile* file = pd->file->open(path, kFileRead);
@@ -32,27 +79,16 @@ uint8_t* read_tga_file_grayscale(const char* path, int* out_w, int* out_h)
 		return NULL;
 
 	uint8_t* res = NULL;
-	TgaHeader header;
-	int bytes = pd->file->read(file, &header, sizeof(header));
-	if (bytes != sizeof(header)
-		|| (header.image_type != 3) // only support grayscale images
-		|| (header.bits_per_pixel != 8) // only support 8bpp
-		|| (header.width == 0 || header.width > 2048 || header.height == 0 || header.height > 2048) // out of bounds sizes
-		)
+	if (!read_tga_header_grayscale(file, out_w, out_h))
 	{
 		pd->file->close(file);
 		return res;
 	}
-		
 
-	*out_w = header.width;
-	*out_h = header.height;
-
-	int image_size = header.width * header.height;
+	int image_size = *out_w * *out_h;
 	res = (uint8_t*)malloc(image_size);
 
-	pd->file->seek(file, header.id_size, SEEK_CUR);
-	bytes = pd->file->read(file, res, image_size);
+	int bytes = pd->file->read(file, res, image_size);
 	if (bytes != image_size) {
 		free(res);
 		res = nullptr;
@@ -0,0 +1,176 @@
+#include "LzDecoder.h"
+
+#include <string.h>
+
+//******************************************************************************
+void LzDecoder::Begin(uint8_t* output, int size)
+{
+    Start = output;
+    Out = output;
+    End = output + size;
+    Literals = 0;
+    Length = 0;
+    Distance = 0;
+    Current = State::Token;
+}
+
+//******************************************************************************
+bool LzDecoder::Feed(const uint8_t* input, int bytes)
+{
+    const uint8_t* in = input;
+    const uint8_t* inEnd = input + bytes;
+
+    while (in < inEnd)
+    {
+        switch (Current)
+        {
+        case State::Token:
+        {
+            uint8_t token = *in++;
+            Literals = token >> 4;
+            Length = (token & 15) + LZ_MIN_MATCH;
+            if (Literals == 15)
+            {
+                Current = State::LiteralCount;
+            }
+            else if (Literals > 0)
+            {
+                Current = State::Literals;
+            }
+            else
+            {
+                Current = Out == End ? State::Done : State::Offset;
+            }
+            break;
+        }
+
+        case State::LiteralCount:
+        {
+            uint8_t more = *in++;
+            Literals += more;
+            if (more != 255)
+            {
+                Current = State::Literals;
+            }
+            break;
+        }
+
+        case State::Literals:
+        {
+            int count = Literals < int(inEnd - in) ? Literals : int(inEnd - in);
+            if (count > int(End - Out))
+            {
+                Current = State::Error;
+                return false;
+            }
+            memcpy(Out, in, count);
+            Out += count;
+            in += count;
+            Literals -= count;
+            if (Literals == 0)
+            {
+                Current = Out == End ? State::Done : State::Offset;
+            }
+            break;
+        }
+
+        case State::Offset:
+            // Usually both bytes are in this piece
+            if (inEnd - in >= 2)
+            {
+                Distance = in[0] | (in[1] << 8);
+                in += 2;
+                if (!Match())
+                {
+                    return false;
+                }
+            }
+            else
+            {
+                Distance = *in++;
+                Current = State::OffsetHigh;
+            }
+            break;
+
+        case State::OffsetHigh:
+            Distance |= *in++ << 8;
+            if (!Match())
+            {
+                return false;
+            }
+            break;
+
+        case State::MatchLength:
+        {
+            uint8_t more = *in++;
+            Length += more;
+            if (more != 255 && !Copy())
+            {
+                return false;
+            }
+            break;
+        }
+
+        case State::Done:
+        case State::Error:
+            Current = State::Error;
+            return false;
+        }
+    }
+    return Current != State::Error;
+}
+
+// Offset read: the match, or its length first
+bool LzDecoder::Match()
+{
+    if (Distance == 0 || Distance > int(Out - Start))
+    {
+        Current = State::Error;
+        return false;
+    }
+    if (Length == 15 + LZ_MIN_MATCH)
+    {
+        Current = State::MatchLength;
+        return true;
+    }
+    return Copy();
+}
+
+bool LzDecoder::Copy()
+{
+    if (Length > int(End - Out))
+    {
+        Current = State::Error;
+        return false;
+    }
+
+    const uint8_t* from = Out - Distance;
+    if (Distance >= Length)
+    {
+        memcpy(Out, from, Length);
+        Out += Length;
+    }
+    else
+    {
+        // Overlapping: repeats the last Distance bytes
+        uint8_t* end = Out + Length;
+        while (Out < end)
+        {
+            *Out++ = *from++;
+        }
+    }
+    Current = State::Token;
+    return true;
+}
+
+//******************************************************************************
+int lz_decode(const uint8_t* input, int bytes, uint8_t* output, int size)
+{
+    LzDecoder decoder;
+    decoder.Begin(output, size);
+    if (!decoder.Feed(input, bytes) || !decoder.Done())
+    {
+        return -1;
+    }
+    return decoder.Decoded();
+}
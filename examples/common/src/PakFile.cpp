@@ -0,0 +1,179 @@
+#include "PakFile.h"
+#include "Globals.h"
+#include "LzDecoder.h"
+
+#include <pdcpp/pdprofile.h>
+#include <stdlib.h>
+#include <string.h>
+
+// "PDPAK 2 <count:5> <data start:10>\n", see buildsupport/PackAssets.cmake
+#define PAK_FIRST_LINE 25
+
+//******************************************************************************
+bool PakFile::Open(const char* path)
+{
+    PlaydateAPI* pd = _G.pd;
+    PDCPP_PROFILE_SCOPE_TEXT("open pak", path);
+    Close();
+
+    // Quietly: without the archive the game reads the loose files
+    File = pd->file->open(path, kFileRead);
+    if (File == nullptr)
+    {
+        return false;
+    }
+
+    char first[PAK_FIRST_LINE + 1] = {};
+    if (pd->file->read(File, first, PAK_FIRST_LINE) != PAK_FIRST_LINE
+        || memcmp(first, "PDPAK 2 ", 8) != 0
+        || first[PAK_FIRST_LINE - 1] != '\n')
+    {
+        pd->system->logToConsole("%s isn't a version 2 pak", path);
+        Close();
+        return false;
+    }
+    int count = atoi(first + 8);
+    int dataStart = atoi(first + 14);
+
+    // Kept whole: the paths of the entries point into it
+    int indexSize = dataStart - PAK_FIRST_LINE;
+    if (indexSize >= 0)
+    {
+        Index = static_cast<char*>(malloc(indexSize + 1));
+    }
+    if (Index == nullptr || pd->file->read(File, Index, indexSize) != indexSize)
+    {
+        pd->system->logToConsole("%s: truncated index", path);
+        Close();
+        return false;
+    }
+    Index[indexSize] = '\0';
+
+    Entries.resize(count);
+    char* cur = Index;
+    for (Entry& entry : Entries)
+    {
+        char* end = nullptr;
+        entry.Hash = uint32_t(strtoul(cur, &end, 16));
+        entry.Offset = uint32_t(strtoul(end, &end, 10));
+        entry.Size = uint32_t(strtoul(end, &end, 10));
+        entry.Unpacked = uint32_t(strtoul(end, &end, 10));
+        if (*end != ' ')
+        {
+            pd->system->logToConsole("%s: bad index line %d", path, int(&entry - Entries.data()));
+            Close();
+            return false;
+        }
+        entry.Path = end + 1;
+
+        char* line = strchr(end + 1, '\n');
+        if (line == nullptr)
+        {
+            pd->system->logToConsole("%s: truncated index", path);
+            Close();
+            return false;
+        }
+        *line = '\0';
+        cur = line + 1;
+    }
+    return true;
+}
+
+void PakFile::Close()
+{
+    if (File)
+    {
+        _G.pd->file->close(File);
+        File = nullptr;
+    }
+    free(Index);
+    Index = nullptr;
+    Entries.clear();
+}
+
+//******************************************************************************
+int PakFile::Find(uint32_t hash, const char* path) const
+{
+    // Lower bound of the hash, then the paths sharing it
+    size_t first = 0;
+    size_t count = Entries.size();
+    while (count > 0)
+    {
+        size_t half = count / 2;
+        if (Entries[first + half].Hash < hash)
+        {
+            first += half + 1;
+            count -= half + 1;
+        }
+        else
+        {
+            count = half;
+        }
+    }
+
+    for (size_t i = first; i < Entries.size() && Entries[i].Hash == hash; ++i)
+    {
+        if (strcmp(Entries[i].Path, path) == 0)
+        {
+            return int(i);
+        }
+    }
+    return -1;
+}
+
+//******************************************************************************
+SDFile* PakFile::Seek(int entry, int offset)
+{
+    if (File == nullptr || entry < 0 || entry >= Count() || offset < 0 || offset > StoredSize(entry))
+    {
+        return nullptr;
+    }
+    if (_G.pd->file->seek(File, Offset(entry) + offset, SEEK_SET) != 0)
+    {
+        return nullptr;
+    }
+    return File;
+}
+
+int PakFile::Read(int entry, int offset, void* buffer, int bytes)
+{
+    SDFile* file = Seek(entry, offset);
+    if (file == nullptr)
+    {
+        return -1;
+    }
+
+    int left = StoredSize(entry) - offset;
+    if (bytes > left)
+    {
+        bytes = left;
+    }
+    return bytes > 0 ? _G.pd->file->read(file, buffer, bytes) : 0;
+}
+
+bool PakFile::Load(int entry, void* buffer, int capacity)
+{
+    if (entry < 0 || entry >= Count() || Size(entry) > capacity)
+    {
+        return false;
+    }
+    PDCPP_PROFILE_SCOPE_TEXT("load pak entry", Path(entry));
+    if (!Compressed(entry))
+    {
+        return Read(entry, 0, buffer, Size(entry)) == Size(entry);
+    }
+
+    LzDecoder decoder;
+    decoder.Begin(static_cast<uint8_t*>(buffer), Size(entry));
+    uint8_t chunk[1024];
+    for (int offset = 0; offset < StoredSize(entry);)
+    {
+        int bytes = Read(entry, offset, chunk, sizeof(chunk));
+        if (bytes <= 0 || !decoder.Feed(chunk, bytes))
+        {
+            return false;
+        }
+        offset += bytes;
+    }
+    return decoder.Done();
+}
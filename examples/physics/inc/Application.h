@@ -18,10 +18,14 @@ class Application
 public: 
     explicit Application(PlaydateAPI* api);
     void Initialize();
-    void Update();
     void Finalize();
 
-    // Reference time of the application in seconds
+    // Fixed timestep (playdate_cpp_app.hcpp): the simulation at a constant dt,
+    // then one render per frame, alpha between the last two steps
+    void FixedUpdate(float dt);
+    void Render(float alpha);
+
+    // Simulated time of the application in seconds, the sum of the steps
     inline float GetGlobalTime() const { return GlobalTime;  }
     // Number of frames since application started
     inline uint32_t GetFrameCount() const { return FrameCount; }
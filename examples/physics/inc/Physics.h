@@ -2,4 +2,7 @@
 
 
 
-void test(float Time);
\ No newline at end of file
+// One step of the simulation, dt is constant (PDCPP_FIXED_STEP_MS)
+void physicsStep(float dt);
+// Draws the game between the last two steps, alpha from 0 to 1
+void physicsRender(float alpha);
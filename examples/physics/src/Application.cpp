@@ -3,6 +3,7 @@
 #include "Physics.h"
 
 #include <pd_api.h>
+#include <pdcpp/pdprofile.h>
 #include <math.h>
 #include <assert.h>
 
@@ -36,19 +37,21 @@ void Application::Finalize()
 }
 
 //******************************************************************************
-void Application::Update()
+void Application::FixedUpdate(float dt)
+{
+    GlobalTime += dt;
+    physicsStep(dt);
+}
+
+//******************************************************************************
+void Application::Render(float alpha)
 {    
-    GlobalTime = pd->system->getElapsedTime();
     pd->graphics->clear(kColorWhite);
 
-    static float t = 0.0f;
-    test(GlobalTime);
-    //test(t);
-
-//    t += 0.1;
+    physicsRender(alpha);
 
     pd->graphics->setFont(Font);
-    pd->system->drawFPS(0, 240-14);
+    PDCPP_PROFILE_HUD(pd, 0, 240-14);
 
     ++FrameCount;
-}
\ No newline at end of file
+}
@@ -1,9 +1,21 @@
+// The ship state of the debug view is logged at DEBUG level
+#define PDCPP_LOG_MODULE_LEVEL PDCPP_LOG_LEVEL_DEBUG
+
 #include "Physics.h"
 #include "Globals.h"
 #include "SimpleMath.h"
-#include "SvgLoader.h"
+#include "AssetLoader.h"
+#include "debug_curve.h"
+#include "level0.h"
 #include "SoundFx.h"
 
+#include <pdcpp/pdapi.h>
+#include <pdcpp/pdarena.h>
+#include <pdcpp/pdcontainers.h>
+#include <pdcpp/pdformat.h>
+#include <pdcpp/pdlog.h>
+#include <pdcpp/pdprofile.h>
+#include <pdcpp/pdtask.h>
 #include <pd_api.h>
 #include <assert.h>
 #include <float.h>
@@ -11,62 +23,57 @@
 
 static uint32_t RNG = 0xDEADBEEF;
 
-#define LOG_ENABLE
-#ifdef LOG_ENABLE
-#define PD_LOG(_format_, ...) _G.pd->system->logToConsole(_format_, ##__VA_ARGS__)
-#else
-#define PD_LOG(...)
-#endif
-
 #define PD_ERROR(_format_, ...) _G.pd->system->error(_format_, ##__VA_ARGS__)
 #define PD_ERROR_IF(_cond_, _format_, ...) do { if(!(_cond_)) _G.pd->system->error(_format_, ##__VA_ARGS__); } while(0)
 
 inline void drawSegment(float x0, float y0, float x1, float y1, float w = 1)
 {
-    _G.pd->graphics->drawLine(x0, y0, x1, y1, w, kColorBlack);
+    pdcpp::Api.graphics.drawLine(x0, y0, x1, y1, w, kColorBlack);
 }
 
 void drawSegment(const vec2& p0, const vec2& p1, float w = 1)
 {
-    _G.pd->graphics->drawLine(p0.x, p0.y, p1.x, p1.y, w, kColorBlack);
+    pdcpp::Api.graphics.drawLine(p0.x, p0.y, p1.x, p1.y, w, kColorBlack);
 }
 
 inline void drawCirle(float xc, float yc, float r, float w = 1)
 {
-    _G.pd->graphics->drawEllipse(xc - r, yc - r, r * 2, r * 2, w, 0, 0, kColorBlack);
+    pdcpp::Api.graphics.drawEllipse(xc - r, yc - r, r * 2, r * 2, w, 0, 0, kColorBlack);
 }
 
 inline void drawCross(float x, float y, float size=4, float w = 1)
 {
-    _G.pd->graphics->drawLine(x - size, y - size, x + size, y + size, w, kColorBlack);
-    _G.pd->graphics->drawLine(x - size, y + size, x + size, y - size, w, kColorBlack);
+    pdcpp::Api.graphics.drawLine(x - size, y - size, x + size, y + size, w, kColorBlack);
+    pdcpp::Api.graphics.drawLine(x - size, y + size, x + size, y - size, w, kColorBlack);
 }
 
-inline void drawPolyline(vec2 p[], int count, float w, bool closed = false)
+inline void drawPolyline(const vec2 p[], int count, float w, bool closed = false)
 {
+    // Loaded once: the calls could change pdcpp::Api as far as the compiler knows
+    auto drawLine = pdcpp::Api.graphics.drawLine;
     for (int i = 0; i < count - 1; ++i)
     {
-        _G.pd->graphics->drawLine(p[i].x, p[i].y, p[i + 1].x, p[i + 1].y, w, kColorBlack);
+        drawLine(p[i].x, p[i].y, p[i + 1].x, p[i + 1].y, w, kColorBlack);
     }
 
     if(closed && count > 2)
     {
-        _G.pd->graphics->drawLine(p[count - 1].x, p[count - 1].y, p[0].x, p[0].y, w, kColorBlack);
+        drawLine(p[count - 1].x, p[count - 1].y, p[0].x, p[0].y, w, kColorBlack);
     }
 }
 
 inline void drawArrow(float x0, float y0, float x1, float y1, float w = 1)
 {
-    _G.pd->graphics->drawLine(x0, y0, x1, y1, w, kColorBlack);
+    pdcpp::Api.graphics.drawLine(x0, y0, x1, y1, w, kColorBlack);
     float angle = atan2f(y1 - y0, x1 - x0);
     float arrowSize = 6.0f;
     float angle1 = angle + 3.14159f * 3.0f / 4.0f;
     float angle2 = angle - 3.14159f * 3.0f / 4.0f;
-    _G.pd->graphics->drawLine(x1, y1,
+    pdcpp::Api.graphics.drawLine(x1, y1,
         x1 + cosf(angle1) * arrowSize,
         y1 + sinf(angle1) * arrowSize,
         w, kColorBlack);
-    _G.pd->graphics->drawLine(x1, y1,
+    pdcpp::Api.graphics.drawLine(x1, y1,
         x1 + cosf(angle2) * arrowSize,
         y1 + sinf(angle2) * arrowSize,
         w, kColorBlack);
@@ -458,25 +465,17 @@ void testPicoSvg(float Time)
 {
     PlaydateAPI* pd = _G.pd;
 
-    static bool sIsInit = false;
-    static std::vector<std::vector<vec2>> polygons;
-    if (!sIsInit)
-    {
-        sIsInit = true;
-        polygons = svgParsePath("level0.svg");
-    }
-    
-
     float speed = 10.0f;
     int offset = cosf(Time * speed) * 100.0f;
     //pd->graphics->setDrawOffset(offset, 0);
     pd->graphics->setLineCapStyle(kLineCapStyleRound);
-    for (size_t p = 0; p < polygons.size(); ++p)
+    for (int p = 0; p < embedded::level0.Count; ++p)
     {
-        for (size_t i = 0; i < polygons[p].size() - 1; ++i)
+        EmbeddedPolyline polygon = embedded::level0[p];
+        for (int i = 0; i < polygon.Count - 1; ++i)
         {
-            const vec2& p0 = polygons[p][i] * 2.0;
-            const vec2& p1 = polygons[p][i + 1] * 2.0;
+            const vec2& p0 = polygon.Points[i] * 2.0;
+            const vec2& p1 = polygon.Points[i + 1] * 2.0;
             pd->graphics->drawLine(p0.x, p0.y, p1.x, p1.y, 3, kColorBlack);
         }
     }
@@ -601,25 +600,19 @@ struct Contact
 };
 
 
-static std::vector<Contact> sContacts;
-static std::vector<vec2> sRayIntersects;
+// Per-frame scratch. The contacts come from the frame arena, their count
+// depends on the level. The ray hits are inline, the extra ones are dropped:
+// they only add to the wall thrust.
+using ContactList = std::vector<Contact, pdcpp::FrameAllocator<Contact>>;
+using PointList = pdcpp::StaticVector<vec2, 32, pdcpp::Overflow::Drop>;
 
 void testCircleCCD2(float t)
 {
     static float previousTime = t;
     static bool sFirst = true;
-    static bool sIsInit = false;
-    static std::vector<std::vector<vec2>> polygons;
-    static vec2* polyline = nullptr;
-    static int polylineCount = 0;
-    if (!sIsInit)
-    {
-        sIsInit = true;
-        polygons = svgParsePath("debug_curve.svg");
-        assert(polygons.size() && polygons[0].size() >= 2);
-        polylineCount = (int)polygons[0].size();
-        polyline = polygons[0].data();
-    }
+    static_assert(embedded::debug_curve.Count > 0, "debug_curve.svg has no path");
+    const vec2* polyline = embedded::debug_curve[0].Points;
+    const int polylineCount = embedded::debug_curve[0].Count;
 
     float dt = t - previousTime;
     PlaydateAPI* pd = _G.pd;
@@ -642,7 +635,8 @@ void testCircleCCD2(float t)
 
 
     // Brute-force test against all segments
-    sContacts.clear();
+    ContactList contacts;
+    contacts.reserve(16);
     for(int i=0; i< polylineCount-1; ++i)
     {
         vec2 s0 = polyline[i];
@@ -656,7 +650,7 @@ void testCircleCCD2(float t)
             
             vec2 newCenter = c0 + (c1 - c0) * outT;
 
-            sContacts.push_back({ {contact.x, contact.y}, {normal.x, normal.y}, newCenter } );
+            contacts.push_back({ {contact.x, contact.y}, {normal.x, normal.y}, newCenter } );
             /*drawCirle(newCenter.x, newCenter.y, radius);
             drawCross(contact.x, contact.y);
             drawNormal(contact.x, contact.y, normal.x, normal.y, 15.0f, 1);*/
@@ -664,18 +658,18 @@ void testCircleCCD2(float t)
     }
 
     // search the nearest new position
-    if (sContacts.size())
+    if (contacts.size())
     {
         float bestDist2 = FLT_MAX;
         Contact* bestContact = nullptr;
-        for (size_t i = 0; i < sContacts.size(); ++i)
+        for (size_t i = 0; i < contacts.size(); ++i)
         {
-            vec2 d = vec2(sContacts[i].newPos.x - c0.x, sContacts[i].newPos.y - c0.y);
+            vec2 d = vec2(contacts[i].newPos.x - c0.x, contacts[i].newPos.y - c0.y);
             float dist2 = dot(d, d);
             if (dist2 < bestDist2)
             {
                 bestDist2 = dist2;
-                bestContact = &sContacts[i];
+                bestContact = &contacts[i];
             }
         }
         // Draw best contact
@@ -712,146 +706,212 @@ struct ParallaxBitmap
     float pF; // parralax factor
 };
 
-void test(float t)
-{
-    PlaydateAPI* pd = _G.pd;
-    //debugOneCCD(t);
-    //testCircleCCD(t);
-    //testCircleCCD2(t);
-    //return;
+//******************************************************************************
+// Bitmaps and level are loaded in the background (AssetLoader.h), the level
+// from Source/assets.pak when built with -DPDCPP_PACK_ASSETS=ON. The debug
+// levels are compiled in (add_playdate_embedded_assets(), CMakeLists.txt).
+static PakFile sPak;
+static AssetLoader sAssets(192 * 1024);
 
-    static float previousTime = t;
-    static bool sFirst = true;
-    static std::vector<std::vector<vec2>> polygons;        
-    static float crashTime = t;
-    static bool debugDraw = false;
-    const char* planetUrls[] = {
+// First frames: resources, random scenery and level, a step at a time in the
+// background (pdcpp/pdtask.h) so the frame loop keeps running meanwhile
+static pdcpp::Task loadLevel(std::vector<std::vector<vec2>>& polygons, std::vector<ParallaxBitmap>& planets, std::vector<ParallaxBitmap>& stars, bool& ready)
+{
+    static constexpr pdcpp::HashedString planetUrls[] = {
         "images/dither/atkinson",
         "images/dither/floyd"
     };
-    static LCDBitmap* planetBitmaps[ARRAY_SIZE(planetUrls)] = {};
-    const char* starUrls[] = {
+    AssetHandle<LCDBitmap> planetBitmaps[ARRAY_SIZE(planetUrls)];
+    static constexpr pdcpp::HashedString starUrls[] = {
         "images/particles/snowflake1",
         "images/particles/snowflake2",
         "images/particles/snowflake3",
         "images/particles/snowflake4"
     };
-    static LCDBitmap* starBitmaps[ARRAY_SIZE(starUrls)] = {};
+    AssetHandle<LCDBitmap> starBitmaps[ARRAY_SIZE(starUrls)];
 
-    //static ParallaxBitmap planets[30];
-    //static ParallaxBitmap particles[30];
-    static std::vector<ParallaxBitmap> planets;
-    static std::vector<ParallaxBitmap> stars;
+    PDCPP_LOG_INFO("Initializing...");
 
-    //static ParallaxBitmap stars[300];
-    //static ParallaxBitmap stars[300];
+    PDCPP_LOG_INFO("Generate audio...");
+    AudioSfx_Initialize();
+    co_await pdcpp::Yield();
 
-    if (sFirst)
+    PDCPP_LOG_INFO("Load planet, particles and level...");
+    if (sPak.Open("assets.pak"))
     {
-        PD_LOG("Initializing...");
+        sAssets.UsePak(&sPak);
+    }
+    for (int i = 0; i < ARRAY_SIZE(planetUrls); ++i)
+    {
+        planetBitmaps[i] = sAssets.LoadBitmap(planetUrls[i]);
+    }
+    for (int i = 0; i < ARRAY_SIZE(starUrls); ++i)
+    {
+        starBitmaps[i] = sAssets.LoadBitmap(starUrls[i]);
+    }
+    AssetHandle<Polygons> level = sAssets.LoadPolygons("level3.svg");
 
-        sFirst = false;
-        PD_LOG("Generate audio...");
-        AudioSfx_Initialize();
+    while (!sAssets.Done())
+    {
+        co_await pdcpp::NextFrame();
+    }
 
-        PD_LOG("Load planet...");
-        // Load planet bitmaps
-        for(int i = 0; i< ARRAY_SIZE(planetUrls); ++i)
-        {
-            const char* outErr = nullptr;
-            const char* path = planetUrls[i];
-            planetBitmaps[i] = pd->graphics->loadBitmap(path, &outErr);
-            PD_ERROR_IF(planetBitmaps[i] != nullptr, "Can't load bitmap %s (%s)", path, outErr ? outErr : "no message");
-        }
+    for (int i = 0; i < ARRAY_SIZE(planetUrls); ++i)
+    {
+        PD_ERROR_IF(sAssets.Get(planetBitmaps[i]) != nullptr, "Can't load bitmap %s", planetUrls[i].Text);
+    }
+    for (int i = 0; i < ARRAY_SIZE(starUrls); ++i)
+    {
+        PD_ERROR_IF(sAssets.Get(starBitmaps[i]) != nullptr, "Can't load bitmap %s", starUrls[i].Text);
+    }
 
-        PD_LOG("Load particles...");
-        // Load particle bitmaps
-        for (int i = 0; i < ARRAY_SIZE(starUrls); ++i)
+    // Random planet generation
+    PDCPP_LOG_INFO("Planet generation...");
+    const int planetCount = 10;
+    planets.resize(planetCount);
+    for (int i = 0; i < planets.size(); ++i)
+    {
+        float x = mapRange(RandomFloat01(&RNG), 0.0, 1.0, 64, 1600 - 64);
+        float y = mapRange(RandomFloat01(&RNG), 0.0, 1.0, 64, 960 - 64);
+        float parallaxF = mapRange(RandomFloat01(&RNG), 0.0, 1.0, 0.4, 0.7);
+        int bitmapId = rand() % ARRAY_SIZE(planetUrls);
+        planets[i] = { sAssets.Get(planetBitmaps[bitmapId]), (int)x, (int)y, parallaxF };
+    }
+    co_await pdcpp::Yield();
+
+    // Random particle generation
+    PDCPP_LOG_INFO("Stars generation...");
+
+    const int starCount = 300;
+    stars.resize(starCount);
+    for (int i = 0; i < stars.size(); ++i)
+    {
+        float x = mapRange(RandomFloat01(&RNG), 0.0, 1.0, 0, 1600);
+        float y = mapRange(RandomFloat01(&RNG), 0.0, 1.0, 0, 960);
+
+        float parallaxF;
+        if (i % 2 == 0)
         {
-            const char* outErr = nullptr;
-            const char* path = starUrls[i];
-            starBitmaps[i] = pd->graphics->loadBitmap(path, &outErr);
-            PD_ERROR_IF(starBitmaps[i] != nullptr, "Can't load bitmap %s", path, outErr ? outErr : "no message");
+            parallaxF = mapRange(RandomFloat01(&RNG), 0.0, 1.0, 0.4, 0.7);
         }
-
-        
-        // Random planet generation
-        PD_LOG("Planet generation...");
-        const int planetCount = 10;
-        planets.resize(planetCount);
-        for (int i = 0; i < planets.size(); ++i)
+        else
         {
-            float x = mapRange(RandomFloat01(&RNG), 0.0, 1.0, 64, 1600 - 64);
-            float y = mapRange(RandomFloat01(&RNG), 0.0, 1.0, 64, 960 - 64);
-            float parallaxF = mapRange(RandomFloat01(&RNG), 0.0, 1.0, 0.4, 0.7);
-            int bitmapId = rand() % ARRAY_SIZE(planetUrls);
-            planets[i] = { planetBitmaps[bitmapId], (int)x, (int)y, parallaxF };
+            parallaxF = mapRange(RandomFloat01(&RNG), 0.0, 1.0, 1.2, 1.8);
         }
+        int bitmapId = rand() % ARRAY_SIZE(starUrls);
+        stars[i] = { sAssets.Get(starBitmaps[bitmapId]), (int)x, (int)y, parallaxF };
 
-        // Random particle generation
-        PD_LOG("Stars generation...");
-
-        const int starCount = 300;
-        stars.resize(starCount);
-        for (int i = 0; i < stars.size(); ++i)
+        if (i % 100 == 99)
         {
-            float x = mapRange(RandomFloat01(&RNG), 0.0, 1.0, 0, 1600);
-            float y = mapRange(RandomFloat01(&RNG), 0.0, 1.0, 0, 960);
-
-            float parallaxF;
-            if (i % 2 == 0)
-            {
-                parallaxF = mapRange(RandomFloat01(&RNG), 0.0, 1.0, 0.4, 0.7);
-            }
-            else
-            {
-                parallaxF = mapRange(RandomFloat01(&RNG), 0.0, 1.0, 1.2, 1.8);
-            }
-            int bitmapId = rand() % ARRAY_SIZE(starUrls);
-            stars[i] = { starBitmaps[bitmapId], (int)x, (int)y, parallaxF };
+            co_await pdcpp::Yield();
         }
+    }
 
 
-        // Level 2
-        //const float scaleWorld = 4.0;
-        //ship.pos = { 183, 23 } ;
+    // Level 2
+    //const float scaleWorld = 4.0;
+    //ship.pos = { 183, 23 } ;
 
-        // Level 3
-        const float scaleWorld = 1.0;
-        ship.pos = { 670, 90 } ;
+    // Level 3
+    const float scaleWorld = 1.0;
+    ship.pos = { 670, 90 } ;
 
-        ship.pos = ship.pos * scaleWorld; // scale up
-        
-        ship.thrust = 1024.0f;
+    ship.pos = ship.pos * scaleWorld; // scale up
+    
+    ship.thrust = 1024.0f;
 
-        PD_LOG("Load level...");
-        polygons = svgParsePath("level3.svg");
+    // The game keeps its own copy, scaled
+    if (const Polygons* shapes = sAssets.Get(level))
+    {
+        polygons = *shapes;
+    }
+    sAssets.Release(level);
+    co_await pdcpp::Yield();
 
-        for (int i = 0; i < polygons.size(); ++i)
+    for (int i = 0; i < polygons.size(); ++i)
+    {
+        for (int j = 0; j < polygons[i].size(); ++j)
         {
-            for (int j = 0; j < polygons[i].size(); ++j)
-            {
-                polygons[i][j] = polygons[i][j] * scaleWorld; // scale up
-            }
+            polygons[i][j] = polygons[i][j] * scaleWorld; // scale up
         }
+    }
 
+    PDCPP_LOG_INFO("Init finished: %d polygons, %d planets, %d stars", int(polygons.size()), int(planets.size()), int(stars.size()));
+    ready = true;
+}
 
-        PD_LOG("Init finished.");
+//******************************************************************************
+// The game state, stepped by physicsStep() at a fixed rate and drawn by
+// physicsRender() once per frame (Application.h)
+static bool sFirst = true;
+static bool sReady = false;
+static std::vector<std::vector<vec2>> polygons;
+static std::vector<ParallaxBitmap> planets;
+static std::vector<ParallaxBitmap> stars;
+
+static float simTime = 0.0f;            // Sum of the steps, seconds
+static float crashTime = 0.0f;
+static bool debugDraw = false;
+static bool enableParticles = false;
+
+// Ship at the start of the last step, rendering interpolates from it
+static Ship previousShip;
+
+// Buttons pushed since the last step, they only show on one frame
+static PDButtons pushedButtons = (PDButtons)0;
+static uint32_t inputFrame = 0;
+static uint32_t renderFrame = 0;
+
+// What the last step computed, for the debug drawing
+static float targetAngle = 0.0f;
+static float debugFF = 0.0f;
+static vec2 thrustOrigin = { 0.0f, 0.0f };
+static vec2 thrustDir[5];
+static int thrustDirCount = 0;
+static PointList rayIntersects;
+
+// Angle are between 0 and 360, and i wan't to reach by the shorstest arc the target angle
+static const float maxAngleSpeed = 360.0f;     // degrees per second
+static const float shipRadius = 4.0f;          // Space ship bounding circle radius
+static const float crashDuration = 0.5f;       // How long the ship engine is disabled after crash
+static const float thrustLength = 24.0f;       // Length of the extra thrust raycasts
+static const float thrustExtraForce = 512.0f;  // Max extra thrust force from wall proximity
+
+// Reads the buttons once per frame, by the first step or else by the render
+static void latchInput()
+{
+    if (inputFrame == renderFrame + 1)
+    {
+        return;
     }
+    inputFrame = renderFrame + 1;
 
-    // Angle are between 0 and 360, and i wan't to reach by the shorstest arc the target angle
-    const float maxAngleSpeed = 360.0f;     // degrees per second
-    const float shipRadius = 4.0f;          // Space ship bounding circle radius
-    const float crashDuration = 0.5f;       // How long the ship engine is disabled after crash
-    const float thrustLength = 24.0f;       // Length of the extra thrust raycasts
-    const float thrustExtraForce = 512.0f;  // Max extra thrust force from wall proximity
-    
-    float dt = t - previousTime;    
+    PDButtons current, pushed, released;
+    _G.pd->system->getButtonState(&current, &pushed, &released);
+    pushedButtons = (PDButtons)(pushedButtons | pushed);
+}
 
-    pd->graphics->setDrawOffset(0, 0);
-       
-    Ship previousShip = ship;    
-    bool engineOn = t - crashTime > crashDuration;
+void physicsStep(float dt)
+{
+    PlaydateAPI* pd = _G.pd;
+
+    if (sFirst)
+    {
+        sFirst = false;
+        pdcpp::Tasks.Spawn(loadLevel(polygons, planets, stars, sReady));
+    }
+
+    // The game starts once the level is there
+    if (!sReady)
+    {
+        previousShip = ship;
+        return;
+    }
+
+    simTime += dt;
+
+    previousShip = ship;
+    bool engineOn = simTime - crashTime > crashDuration;
     ship.thrust = 1024;
     if (!engineOn)
     {
@@ -859,8 +919,11 @@ void test(float t)
     }
 
     // Input management
+    latchInput();
     PDButtons current, pushed, released;
     pd->system->getButtonState(&current, &pushed, &released);
+    pushed = pushedButtons;
+    pushedButtons = (PDButtons)0;
     if (pushed & kButtonUp)
     {
         ship.thrust *= 2.0f;
@@ -884,7 +947,6 @@ void test(float t)
         debugDraw = !debugDraw;
     }
 
-    static bool enableParticles = false;
     if (pushed & kButtonA)
     {
         enableParticles = !enableParticles;
@@ -894,7 +956,7 @@ void test(float t)
 
     ship.thrust = clamp(ship.thrust, 0.0f, 10000.0f);
 
-    float targetAngle = pd->system->getCrankAngle();
+    targetAngle = pd->system->getCrankAngle();
     float currentAngle = normalizeAngle(degrees(ship.angle));
     if (pd->system->isCrankDocked())
     {
@@ -919,35 +981,13 @@ void test(float t)
     float angleInput = angleDiff;
     ship.angle += radians(clamp(angleInput, -maxAngleSpeed * dt, maxAngleSpeed * dt));
     
-   
-    vec2 drawOffset = { -ship.pos.x + 200, -ship.pos.y + 120 };
-    pd->graphics->setDrawOffset(drawOffset.x, drawOffset.y);
-    
-    // Populate background with parallax planets
-    for (int i = 0; i < planets.size(); ++i)
-    {
-        //pd->graphics->setDrawOffset(drawOffset.x* planets[i].pF, drawOffset.y* planets[i].pF);
-        pd->graphics->drawBitmap(planets[i].bitmap, planets[i].x - drawOffset.x * planets[i].pF, planets[i].y - drawOffset.y * planets[i].pF, kBitmapUnflipped);
-    }
-
-    // Populate foreground with parallax particles
-    if (enableParticles)
-    {
-        for (int i = 0; i < stars.size(); ++i)
-        {
-            pd->graphics->drawBitmap(stars[i].bitmap, stars[i].x - drawOffset.x * stars[i].pF, stars[i].y - drawOffset.y * stars[i].pF, kBitmapUnflipped);
-        }
-    }
-
-
-    pd->graphics->setDrawOffset(drawOffset.x, drawOffset.y);
-
-    //ship.angle += radians(clamp(angleInput, -maxAngleSpeed * dt, maxAngleSpeed * dt));
     //ship.angle = radians(pd->system->getCrankAngle());    
     ship.update(dt);
     
     // brute-force CCD against level geometry
-    sContacts.clear();
+    PDCPP_PROFILE_BEGIN("ccd");
+    ContactList contacts;
+    contacts.reserve(16);
     vec2 c0 = previousShip.pos;
     vec2 c1 = ship.pos;
     for (int j = 0; j < polygons.size(); ++j)
@@ -970,35 +1010,28 @@ void test(float t)
                 ctt.p = contact;
                 ctt.s0 = s0;
                 ctt.s1 = s1;
-                sContacts.push_back(ctt);
+                contacts.push_back(ctt);
             }
         }
     }
 
     // search the nearest new position
-    if (sContacts.size())
+    if (contacts.size())
     {
         float bestDist2 = FLT_MAX;
         Contact* bestContact = nullptr;
-        for (size_t i = 0; i < sContacts.size(); ++i)
+        for (size_t i = 0; i < contacts.size(); ++i)
         {
-            vec2 d = vec2(sContacts[i].newPos.x - c0.x, sContacts[i].newPos.y - c0.y);
+            vec2 d = vec2(contacts[i].newPos.x - c0.x, contacts[i].newPos.y - c0.y);
             float dist2 = dot(d, d);
             if (dist2 < bestDist2)
             {
                 bestDist2 = dist2;
-                bestContact = &sContacts[i];
+                bestContact = &contacts[i];
             }
         }
-        // Draw best contact
         if (bestContact)
         {
-            /*
-            drawCirle(bestContact->newPos.x, bestContact->newPos.y, shipRadius);
-            drawCross(bestContact->p.x, bestContact->p.y);
-            drawNormal(bestContact->p.x, bestContact->p.y, bestContact->n.x, bestContact->n.y, 15.0f, 1);
-            */
-
             ship.pos = bestContact->newPos + bestContact->n * 0.375f; // Push it a bit farther to avoid constant contact
             //ship.pos = bestContact->newPos;
             const float restitution = 0.5f;
@@ -1007,9 +1040,10 @@ void test(float t)
 
             SfxHissGraze(RandomFloat01(&RNG));
 
-            crashTime = t;
+            crashTime = simTime;
         }
     }
+    PDCPP_PROFILE_END();
 
 
 
@@ -1017,30 +1051,23 @@ void test(float t)
     // Compute extra thrust imbue by wall
     // For that we launch 3 raycast from ship center to its back
     // brute-force ray intersect on all segment
-    sRayIntersects.clear();
+    rayIntersects.clear();
+    thrustDirCount = 0;
     ship.extraForce = { 0.0f, 0.0f };
-    float debugFF = 0;
+    debugFF = 0;
     if (engineOn)
     {
-        vec2 thrustDir[] = {
-            rotateAxis(normalize({-4.0f, 0.0f}), ship.angle),
-            rotateAxis(normalize({-4.0f, -4.0f}), ship.angle),
-            rotateAxis(normalize({-4.0f, -2.0f}), ship.angle),
-            rotateAxis(normalize({-4.0f, 2.0f}), ship.angle),
-            rotateAxis(normalize({-4.0f, 4.0f}), ship.angle)
-        };
+        PDCPP_PROFILE_SCOPE("thrust rays");
+        thrustDir[0] = rotateAxis(normalize({-4.0f, 0.0f}), ship.angle);
+        thrustDir[1] = rotateAxis(normalize({-4.0f, -4.0f}), ship.angle);
+        thrustDir[2] = rotateAxis(normalize({-4.0f, -2.0f}), ship.angle);
+        thrustDir[3] = rotateAxis(normalize({-4.0f, 2.0f}), ship.angle);
+        thrustDir[4] = rotateAxis(normalize({-4.0f, 4.0f}), ship.angle);
+        thrustDirCount = ARRAY_SIZE(thrustDir);
 
         vec2 lookDir = rotateAxis({ 1.0f, 0.0f }, ship.angle);
         vec2 originRay = ship.pos /* - lookDir * shipRadius*/;
-
-        // Debug extra thrust rays
-        if (debugDraw)
-        {
-            for (int k = 0; k < ARRAY_SIZE(thrustDir); ++k)
-            {
-                drawArrow(originRay, originRay + thrustDir[k] * thrustLength, 1);
-            }
-        }
+        thrustOrigin = originRay;
 
         for (int j = 0; j < polygons.size(); ++j)
         {
@@ -1058,22 +1085,17 @@ void test(float t)
                         outI);
                     if (intersect)
                     {
-                        sRayIntersects.push_back(outI);
+                        rayIntersects.push_back(outI);
                     }
                 }
             }
         }
 
         float maxForceMag = 0.0f;
-        for (int i = 0; i < sRayIntersects.size(); ++i)
+        for (int i = 0; i < rayIntersects.size(); ++i)
         {
-            if (debugDraw)
-            {
-                drawCross(sRayIntersects[i].x, sRayIntersects[i].y);
-            }
-
             // Apply extra force
-            vec2 toShip = originRay - sRayIntersects[i];
+            vec2 toShip = originRay - rayIntersects[i];
             //float forceMag = mapRange(length(toShip), 0.0f, thrustLength, 1.0f, 0.0f);
             //ship.extraForce += toShip * forceMag * forceMax;
 
@@ -1090,8 +1112,70 @@ void test(float t)
             SfxSlideHiss(maxForceMag / 3.0f);
         }
     }
+}
+
+void physicsRender(float alpha)
+{
+    PlaydateAPI* pd = _G.pd;
+
+    // Pushed during a frame without a step: kept for the next one
+    latchInput();
+    ++renderFrame;
+
+    if (!sReady)
+    {
+        const char* loading = "Loading...";
+        pd->graphics->drawText(loading, strlen(loading), kASCIIEncoding, 170, 100);
+        if (!sAssets.Done())
+        {
+            sAssets.DrawProgress(100, 120, 200, 12);
+        }
+        return;
+    }
 
+    // Between the last two steps, the angle by the shortest arc
+    Ship drawShip = ship;
+    drawShip.pos = lerp(previousShip.pos, ship.pos, alpha);
+    float angleStep = remainderf(ship.angle - previousShip.angle, radians(360.0f));
+    drawShip.angle = ship.angle - angleStep * (1.0f - alpha);
 
+    vec2 drawOffset = { -drawShip.pos.x + 200, -drawShip.pos.y + 120 };
+    pd->graphics->setDrawOffset(drawOffset.x, drawOffset.y);
+    
+    PDCPP_PROFILE_BEGIN("parallax");
+
+    // Populate background with parallax planets
+    for (int i = 0; i < planets.size(); ++i)
+    {
+        //pd->graphics->setDrawOffset(drawOffset.x* planets[i].pF, drawOffset.y* planets[i].pF);
+        pd->graphics->drawBitmap(planets[i].bitmap, planets[i].x - drawOffset.x * planets[i].pF, planets[i].y - drawOffset.y * planets[i].pF, kBitmapUnflipped);
+    }
+
+    // Populate foreground with parallax particles
+    if (enableParticles)
+    {
+        for (int i = 0; i < stars.size(); ++i)
+        {
+            pd->graphics->drawBitmap(stars[i].bitmap, stars[i].x - drawOffset.x * stars[i].pF, stars[i].y - drawOffset.y * stars[i].pF, kBitmapUnflipped);
+        }
+    }
+    PDCPP_PROFILE_END();
+
+
+    pd->graphics->setDrawOffset(drawOffset.x, drawOffset.y);
+
+    // Debug extra thrust rays, as of the last step
+    if (debugDraw)
+    {
+        for (int k = 0; k < thrustDirCount; ++k)
+        {
+            drawArrow(thrustOrigin, thrustOrigin + thrustDir[k] * thrustLength, 1);
+        }
+        for (int i = 0; i < rayIntersects.size(); ++i)
+        {
+            drawCross(rayIntersects[i].x, rayIntersects[i].y);
+        }
+    }
 
   
     for (int i = 0; i < polygons.size(); ++i)
@@ -1102,28 +1186,25 @@ void test(float t)
 
     //pd->graphics->drawRect(0, 0, 400, 240, kColorBlack);
     if (!debugDraw)
-        ship.draw(ship.pos);
+        drawShip.draw(drawShip.pos);
 
     // Speed vector
     if (debugDraw)
     {
         // Bound volume
-        drawCirle(ship.pos.x, ship.pos.y, shipRadius, 1);
+        drawCirle(drawShip.pos.x, drawShip.pos.y, shipRadius, 1);
 
-        drawArrow(ship.pos, ship.pos + ship.vel * 0.5f); // scale down velocity vector debug
+        drawArrow(drawShip.pos, drawShip.pos + ship.vel * 0.5f); // scale down velocity vector debug
     }
 
 
     pd->graphics->setDrawOffset(0, 0);
 
-    char tmp[64] = { '\0' };
     if (debugDraw)
     {
-        sprintf(tmp, "%.f thr=%.f ethr=%.f ff=%.3f v=%.f", targetAngle, ship.thrust, length(ship.extraForce), debugFF, length(ship.vel));
-        pd->graphics->drawText(tmp, strlen(tmp), kASCIIEncoding, 0, 0);
+        PDCPP_LOG_DEBUG("angle=%.f thrust=%.f extra=%.f ff=%.3f v=%.f", targetAngle, ship.thrust, length(ship.extraForce), debugFF, length(ship.vel));
+        char tmp[64];
+        int tmpLength = pdcpp::Format(tmp, "%.f thr=%.f ethr=%.f ff=%.3f v=%.f", targetAngle, ship.thrust, length(ship.extraForce), debugFF, length(ship.vel));
+        pd->graphics->drawText(tmp, tmpLength, kASCIIEncoding, 0, 0);
     }
-
-
-    previousTime = t;
 }
-
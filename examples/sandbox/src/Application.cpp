@@ -3,6 +3,7 @@
 #include "Sandbox.h"
 
 #include <pd_api.h>
+#include <pdcpp/pdprofile.h>
 #include <math.h>
 #include <assert.h>
 
@@ -48,7 +49,7 @@ void Application::Update()
     testPicoSvg(GlobalTime);
     
     pd->graphics->setFont(Font);
-    pd->system->drawFPS(0, 240-14);
+    PDCPP_PROFILE_HUD(pd, 0, 240-14);
 
     ++FrameCount;
 }
\ No newline at end of file
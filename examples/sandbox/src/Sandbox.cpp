@@ -1,8 +1,9 @@
 #include "Sandbox.h"
 #include "Globals.h"
 #include "SimpleMath.h"
-#include "SvgLoader.h"
+#include "level0.h"
 
+#include <pdcpp/pdformat.h>
 #include <pd_api.h>
 #include <assert.h>
 #include <vector>
@@ -54,7 +55,7 @@ const uint8_t bayerDither04[] = {
     0xff,0xff,0xff,0xff,0xff,0xff,0xff,0xff
 };
 
-const uint8_t dexterPinstripe[] = {
+constexpr uint8_t dexterPinstripe[] = {
     0x24,
     0x48,
     0x90,
@@ -82,7 +83,7 @@ const uint8_t dexterPinstripeMedium[] = {
 };
 
 // Shift on the left and down
-void shiftSprite8x8(const uint8_t src[8], uint8_t dst[8], int shiftX, int shiftY)
+constexpr void shiftSprite8x8(const uint8_t src[8], uint8_t dst[8], int shiftX, int shiftY)
 {
     for (int y = 0; y < 8; ++y)
     {
@@ -147,7 +148,7 @@ struct FixedPattern8x8_Deprecated
     }
 
     // Return the pattern adapted at the position in order to obtain a fixed pattern
-    LCDColor fixedPattern(int x, int y)
+    LCDColor fixedPattern(int x, int y) const
     {
         LCDColor pattern;
         int sX = -x & 0x7;
@@ -166,31 +167,29 @@ struct FixedPattern8x8_Deprecated
 
 // Fixed pattern take 1024 Bytes !
 // 64 combinations of the origibal 16-bytes mask
+// constexpr: built by the compiler, the table is in .rodata
 struct FixedPattern8x8
 {
-    FixedPattern8x8(const uint8_t PatterData[16])
+    constexpr FixedPattern8x8(const uint8_t PatterData[16])
     {
         for (int i = 0; i < 64; ++i)
         {
             int x = i & 0x7;    // i%8
             int y = i >> 3;     // i/8
 
-            
-            uint8_t Shifted[16];
-            shiftSprite8x8(PatterData, Shifted, x, y);
-            shiftSprite8x8(PatterData+8, Shifted+8, x, y);
-            memcpy(Patterns + i * 16, Shifted, 16);          
+            shiftSprite8x8(PatterData, Patterns + i * 16, x, y);
+            shiftSprite8x8(PatterData + 8, Patterns + i * 16 + 8, x, y);
         }
     }
 
-    LCDColor fixedPatternByIndex(int Index)
+    LCDColor fixedPatternByIndex(int Index) const
     {
         assert(Index < 64);
         return LCDColor(&Patterns[Index*16]);
     }
 
     // Return the pattern adapted at the position in order to obtain a fixed pattern
-    LCDColor fixedPattern(int x, int y)
+    LCDColor fixedPattern(int x, int y) const
     {
         LCDColor pattern;
         int sX = -x & 0x7;
@@ -202,9 +201,11 @@ struct FixedPattern8x8
         return LCDColor(&Patterns[sY * 16 * 8 + sX * 16]);
     }
 
-    uint8_t Patterns[16 * 64];
+    uint8_t Patterns[16 * 64] = {};
 };
 
+static constexpr FixedPattern8x8 sFixedDexterPinstripe(dexterPinstripe);
+
 // Same as FixedPattern8x8 but recompute the mask each time,
 // Care each call modify a static variable
 LCDColor shiftPatternWithMask(const uint8_t Pattern[16], int x, int y)
@@ -295,7 +296,7 @@ void testShiftPattern(float Time)
 {
     PlaydateAPI* pd = _G.pd;
 
-    static FixedPattern8x8 fixedPattern(dexterPinstripe);
+    const FixedPattern8x8& fixedPattern = sFixedDexterPinstripe;
     static bool IsInit = false;
     if (!IsInit)
     {
@@ -317,7 +318,6 @@ void testDrawing(float Time)
     PlaydateAPI* pd = _G.pd;
     pd->graphics->setDrawOffset(0, 0);
 
-    static FixedPattern8x8 fixedPattern(dexterPinstripe);
     static bool IsInit = false;
     static LCDBitmap* bmp = nullptr;
     static LCDBitmap* bmPattern = makeDiagonalPattern();
@@ -365,9 +365,9 @@ void testDrawing(float Time)
     pd->graphics->fillRect(200, 100, 50, 50, patternColor);
 
 
-    char tmpStr[256] = { '\0' };
-    snprintf(tmpStr, 256, "Shift=%d", shiftPatternIndex);
-    pd->graphics->drawText(tmpStr, strlen(tmpStr), kASCIIEncoding, 250, 100 - 14);
+    char tmpStr[16];
+    int tmpLength = pdcpp::Format(tmpStr, "Shift=%d", shiftPatternIndex);
+    pd->graphics->drawText(tmpStr, tmpLength, kASCIIEncoding, 250, 100 - 14);
     pd->graphics->setColorToPattern(&patternColor, bmpPatternBayer, 0, shiftPatternIndex);
     pd->graphics->fillRect(250, 100, 50, 50, patternColor);
 
@@ -397,7 +397,7 @@ void testDrawing(float Time)
     const uint8_t* patternTable[] = { bayerDither04, dexterPinstripe, dexterPinstripe };
     int patternIndex = int(Time/4) % 3;
 
-    //LCDColor fixedPatternColor = fixedPattern.fixedPattern(x, y);
+    //LCDColor fixedPatternColor = sFixedDexterPinstripe.fixedPattern(x, y);
     LCDColor fixedPatternColor = shiftPattern(patternTable[patternIndex], x, y);
     pd->graphics->fillRect(x, y, 50, 50, fixedPatternColor);
 
@@ -519,24 +519,17 @@ void testPicoSvg(float Time)
 {
     PlaydateAPI* pd = _G.pd;
 
-    static bool sIsInit = false;
-    static std::vector<std::vector<vec2>> polygons;
-    if (!sIsInit)
-    {
-        sIsInit = true;
-        polygons = svgParsePath("level0.svg");
-    }
-
     float speed = 10.0;
     int offset = cosf(Time * speed) * 100.0f;
     pd->graphics->setDrawOffset(offset, 0);
     pd->graphics->setLineCapStyle(kLineCapStyleRound);
-    for (size_t p = 0; p < polygons.size(); ++p)
+    for (int p = 0; p < embedded::level0.Count; ++p)
     {
-        for (size_t i = 0; i < polygons[p].size() - 1; ++i)
+        EmbeddedPolyline polygon = embedded::level0[p];
+        for (int i = 0; i < polygon.Count - 1; ++i)
         {
-            const vec2& p0 = polygons[p][i];
-            const vec2& p1 = polygons[p][i+1];
+            const vec2& p0 = polygon.Points[i];
+            const vec2& p1 = polygon.Points[i+1];
             pd->graphics->drawLine(p0.x, p0.y, p1.x, p1.y, 3, kColorBlack);
         }
     }
@@ -3,6 +3,7 @@
 #include "Shadertoy.h"
 
 #include <pdcpp/pdnewlib.h>
+#include <pdcpp/pdprofile.h>
 #include <math.h>
 #include <assert.h>
 
@@ -50,7 +51,7 @@ void Application::Update()
     Shadertoy->Render(GlobalTime);
 
     pd->graphics->setFont(Font);
-    pd->system->drawFPS(0, 0);
+    PDCPP_PROFILE_HUD(pd, 0, 0);
 
     ++FrameCount;
 }
\ No newline at end of file
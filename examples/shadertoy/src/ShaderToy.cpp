@@ -1,9 +1,10 @@
 #include "Shadertoy.h"
 #include "Globals.h"
 #include "SimpleMath.h"
-#include "ImageLoader.h"
+#include "BlueNoise.h"
 
 #include <pdcpp/pdnewlib.h>
+#include <pdcpp/pdprofile.h>
 #include <malloc.h>
 #include <memory.h>
 
@@ -12,7 +13,9 @@
 #define SCREEN_Y	240
 #define SCREEN_STRIDE_BYTES 52
 
-static uint8_t* s_blue_noise = nullptr;
+// Compiled in (add_playdate_embedded_assets(), CMakeLists.txt)
+static_assert(embedded::BlueNoise.Width == SCREEN_X && embedded::BlueNoise.Height == SCREEN_Y, "BlueNoise.tga must be the size of the screen");
+static const uint8_t* const s_blue_noise = embedded::BlueNoise.Pixels;
 uint8_t g_screen_buffer[SCREEN_X * SCREEN_Y];
 
 /******************************************************************************/
@@ -38,6 +41,7 @@ void draw_dithered_scanline(const uint8_t* values, int y, int bias, uint8_t* fra
 /******************************************************************************/
 void draw_dithered_screen(uint8_t* framebuffer, int bias)
 {
+    PDCPP_PROFILE_SCOPE("dither");
     const uint8_t* src = g_screen_buffer;
     for (int y = 0; y < SCREEN_Y; ++y)
     {
@@ -82,21 +86,11 @@ void PrettyHipShader(vec4& fragColor, vec2 fragCoord, const vec2 iResolution, fl
 //******************************************************************************
 void ShaderToy::Initialize()
 {
-    int bn_w, bn_h;
-    s_blue_noise = read_tga_file_grayscale("images/BlueNoise.tga", &bn_w, &bn_h);
-    if (bn_w != SCREEN_X || bn_h != SCREEN_Y) {
-        free(s_blue_noise);
-        s_blue_noise = NULL;
-    }
 }
 
 //******************************************************************************
 void ShaderToy::Finalize()
 {
-    if (s_blue_noise) {
-        free(s_blue_noise);
-        s_blue_noise = NULL;
-    }
 }
 
 //******************************************************************************
@@ -106,6 +100,7 @@ void ShaderToy::Render(float Time)
 
     int Effect = int(fmodf(Time, 15.0f) / 5.0f);
 
+    PDCPP_PROFILE_BEGIN("shader");
     for (int y = 0; y < SCREEN_Y; ++y)
     {
         for (int x = 0; x < SCREEN_X; ++x)
@@ -144,6 +139,7 @@ void ShaderToy::Render(float Time)
             }            
         }
     }
+    PDCPP_PROFILE_END();
 
     // Apply dither and copy on playdate framebuffer
     draw_dithered_screen(FrameBuffer, 0);
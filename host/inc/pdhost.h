@@ -0,0 +1,26 @@
+#ifndef __PDHOST_H
+#define __PDHOST_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "pd_api.h"
+
+// Headless host build (-DPDCPP_HOST_BUILD=ON)
+// The examples are linked as native executables against a stand-in PlaydateAPI
+// (host/src): 400x240 1bpp framebuffer, files from the Source/ and data
+// directories, scripted buttons and crank, virtual clock, no audio output.
+// Run `<game> --help` for the command line options.
+
+// Frames run since launch
+uint32_t pdhost_frame(void);
+
+// Write the last displayed frame as a binary PBM image. Returns 0 on success.
+int pdhost_write_pbm(const char* path);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,278 @@
+#include "host.h"
+
+#include <dirent.h>
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+// File API over the host file system. The source directory plays the pdx
+// (read only), the data directory the game's data folder.
+
+static char s_error[512];
+
+static const char* file_geterr(void)
+{
+	return s_error[0] ? s_error : NULL;
+}
+
+static int fail(const char* what, const char* path)
+{
+	snprintf(s_error, sizeof(s_error), "%s %s: %s", what, path, strerror(errno));
+	return -1;
+}
+
+static void join(char* out, size_t size, const char* dir, const char* path)
+{
+	while (*path == '/') ++path;
+	snprintf(out, size, "%s/%s", dir, path);
+}
+
+FILE* host_open_source(const char* path, const char* suffix)
+{
+	char full[1024];
+	join(full, sizeof(full), host_options.sourceDir, path);
+	FILE* file = fopen(full, "rb");
+	if (file || suffix == NULL)
+	{
+		return file;
+	}
+
+	// Compiled assets are referenced without extension or with the compiled one
+	// (.pdi, .pdt...), the host reads the sources instead
+	char* name = strrchr(full, '/');
+	char* extension = strrchr(name ? name : full, '.');
+	if (extension) *extension = 0;
+	size_t len = strlen(full);
+	snprintf(full + len, sizeof(full) - len, "%s", suffix);
+	return fopen(full, "rb");
+}
+
+static SDFile* file_open(const char* name, FileOptions mode)
+{
+	char full[1024];
+	FILE* file = NULL;
+	if (mode & (kFileWrite | kFileAppend))
+	{
+		join(full, sizeof(full), host_options.dataDir, name);
+		file = fopen(full, (mode & kFileAppend) ? "ab" : "wb");
+	}
+	else
+	{
+		// With both flags the data folder wins, like on device
+		if (mode & kFileReadData)
+		{
+			join(full, sizeof(full), host_options.dataDir, name);
+			file = fopen(full, "rb");
+		}
+		if (file == NULL && (mode & kFileRead))
+		{
+			join(full, sizeof(full), host_options.sourceDir, name);
+			file = fopen(full, "rb");
+		}
+	}
+
+	if (file == NULL)
+	{
+		fail("can't open", name);
+	}
+	return (SDFile*)file;
+}
+
+static int file_close(SDFile* file)
+{
+	return fclose((FILE*)file) == 0 ? 0 : fail("can't close", "file");
+}
+
+static int file_read(SDFile* file, void* buf, unsigned int len)
+{
+	size_t count = fread(buf, 1, len, (FILE*)file);
+	if (count < len && ferror((FILE*)file))
+	{
+		return fail("can't read", "file");
+	}
+	return (int)count;
+}
+
+static int file_write(SDFile* file, const void* buf, unsigned int len)
+{
+	size_t count = fwrite(buf, 1, len, (FILE*)file);
+	return count < len ? fail("can't write", "file") : (int)count;
+}
+
+static int file_flush(SDFile* file)
+{
+	return fflush((FILE*)file) == 0 ? 0 : fail("can't flush", "file");
+}
+
+static int file_tell(SDFile* file)
+{
+	long position = ftell((FILE*)file);
+	return position < 0 ? fail("can't tell", "file") : (int)position;
+}
+
+static int file_seek(SDFile* file, int pos, int whence)
+{
+	return fseek((FILE*)file, pos, whence) == 0 ? 0 : fail("can't seek", "file");
+}
+
+// Finds a path in the data directory first, then in the source directory
+static int resolve(const char* path, char* full, size_t size, struct stat* info)
+{
+	join(full, size, host_options.dataDir, path);
+	if (stat(full, info) == 0)
+	{
+		return 0;
+	}
+	join(full, size, host_options.sourceDir, path);
+	return stat(full, info);
+}
+
+static int file_stat(const char* path, FileStat* out)
+{
+	char full[1024];
+	struct stat info;
+	if (resolve(path, full, sizeof(full), &info))
+	{
+		return fail("can't stat", path);
+	}
+
+	struct tm date;
+	localtime_r(&info.st_mtime, &date);
+	out->isdir = S_ISDIR(info.st_mode);
+	out->size = (unsigned int)info.st_size;
+	out->m_year = date.tm_year + 1900;
+	out->m_month = date.tm_mon + 1;
+	out->m_day = date.tm_mday;
+	out->m_hour = date.tm_hour;
+	out->m_minute = date.tm_min;
+	out->m_second = date.tm_sec;
+	return 0;
+}
+
+static int list_directory(const char* dir, const char* skipDir, const char* path,
+	void (*callback)(const char* path, void* userdata), void* userdata, int showhidden)
+{
+	char full[1024];
+	join(full, sizeof(full), dir, path);
+	DIR* handle = opendir(full);
+	if (handle == NULL)
+	{
+		return -1;
+	}
+
+	struct dirent* entry;
+	while ((entry = readdir(handle)))
+	{
+		if (strcmp(entry->d_name, ".") == 0 || strcmp(entry->d_name, "..") == 0 || (!showhidden && entry->d_name[0] == '.'))
+		{
+			continue;
+		}
+
+		char child[1280];
+		struct stat info;
+		if (skipDir)
+		{
+			// Already listed from the other directory
+			join(child, sizeof(child), skipDir, path);
+			size_t len = strlen(child);
+			snprintf(child + len, sizeof(child) - len, "/%s", entry->d_name);
+			if (stat(child, &info) == 0)
+			{
+				continue;
+			}
+		}
+
+		snprintf(child, sizeof(child), "%s/%s", full, entry->d_name);
+		char name[512];
+		int isDir = stat(child, &info) == 0 && S_ISDIR(info.st_mode);
+		snprintf(name, sizeof(name), isDir ? "%s/" : "%s", entry->d_name);
+		callback(name, userdata);
+	}
+	closedir(handle);
+	return 0;
+}
+
+static int file_listfiles(const char* path, void (*callback)(const char* path, void* userdata), void* userdata, int showhidden)
+{
+	int data = list_directory(host_options.dataDir, NULL, path, callback, userdata, showhidden);
+	int source = list_directory(host_options.sourceDir, host_options.dataDir, path, callback, userdata, showhidden);
+	return data == 0 || source == 0 ? 0 : fail("can't list", path);
+}
+
+static int file_mkdir(const char* path)
+{
+	char full[1024];
+	join(full, sizeof(full), host_options.dataDir, path);
+
+	// Creates the intermediate directories too
+	for (char* slash = strchr(full + strlen(host_options.dataDir) + 1, '/'); slash; slash = strchr(slash + 1, '/'))
+	{
+		*slash = 0;
+		mkdir(full, 0755);
+		*slash = '/';
+	}
+	return mkdir(full, 0755) == 0 || errno == EEXIST ? 0 : fail("can't create", path);
+}
+
+static int remove_tree(const char* full)
+{
+	DIR* handle = opendir(full);
+	if (handle)
+	{
+		struct dirent* entry;
+		while ((entry = readdir(handle)))
+		{
+			if (strcmp(entry->d_name, ".") == 0 || strcmp(entry->d_name, "..") == 0)
+			{
+				continue;
+			}
+			char child[1280];
+			snprintf(child, sizeof(child), "%s/%s", full, entry->d_name);
+			remove_tree(child);
+		}
+		closedir(handle);
+	}
+	return remove(full);
+}
+
+static int file_unlink(const char* name, int recursive)
+{
+	char full[1024];
+	join(full, sizeof(full), host_options.dataDir, name);
+	int result = recursive ? remove_tree(full) : remove(full);
+	return result == 0 ? 0 : fail("can't delete", name);
+}
+
+static int file_rename(const char* from, const char* to)
+{
+	char fullFrom[1024];
+	char fullTo[1024];
+	join(fullFrom, sizeof(fullFrom), host_options.dataDir, from);
+	join(fullTo, sizeof(fullTo), host_options.dataDir, to);
+	return rename(fullFrom, fullTo) == 0 ? 0 : fail("can't rename", from);
+}
+
+void host_file_init(struct playdate_file* file)
+{
+	host_fill_unimplemented(file, sizeof(*file));
+
+	HOST_SET(file, geterr, file_geterr);
+	HOST_SET(file, listfiles, file_listfiles);
+	HOST_SET(file, stat, file_stat);
+	HOST_SET(file, mkdir, file_mkdir);
+	HOST_SET(file, unlink, file_unlink);
+	HOST_SET(file, rename, file_rename);
+	HOST_SET(file, open, file_open);
+	HOST_SET(file, close, file_close);
+	HOST_SET(file, read, file_read);
+	HOST_SET(file, write, file_write);
+	HOST_SET(file, flush, file_flush);
+	HOST_SET(file, tell, file_tell);
+	HOST_SET(file, seek, file_seek);
+
+	// The game expects its data folder to exist
+	mkdir(host_options.dataDir, 0755);
+}
@@ -0,0 +1,1299 @@
+#include "host.h"
+
+#include <dirent.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Software implementation of the 1bpp graphics API. Bit set = white, like the
+// Playdate framebuffer. Everything is drawn pixel by pixel: correct enough to
+// run and inspect the game, not meant to be as fast as the device.
+
+struct LCDBitmap
+{
+	int width;
+	int height;
+	int rowbytes;
+	uint8_t* data;
+	uint8_t* mask;  // NULL when opaque
+};
+
+typedef struct
+{
+	uint32_t codepoint;
+	uint16_t cell;
+	uint8_t advance;
+} font_glyph_t;
+
+struct LCDFont
+{
+	int height;
+	int tracking;
+	LCDBitmap* table;  // NULL for the system fonts, which the host doesn't have
+	int cellWidth;
+	int cellHeight;
+	int columns;
+	int glyphCount;
+	font_glyph_t glyphs[256];
+};
+
+typedef struct
+{
+	LCDBitmap* target;
+	LCDBitmapDrawMode mode;
+	int dx;
+	int dy;
+	int clipX0, clipY0, clipX1, clipY1;  // target coordinates, exclusive end
+	LCDLineCapStyle cap;
+	LCDFont* font;
+	int tracking;
+	int leading;
+	LCDBitmap* stencil;
+	int stencilTile;
+} context_t;
+
+#define CONTEXT_DEPTH 16
+
+static uint8_t s_frameData[LCD_ROWSIZE * LCD_ROWS];
+static uint8_t s_displayData[LCD_ROWSIZE * LCD_ROWS];
+static LCDBitmap s_frame = { LCD_COLUMNS, LCD_ROWS, LCD_ROWSIZE, s_frameData, NULL };
+static LCDBitmap s_display = { LCD_COLUMNS, LCD_ROWS, LCD_ROWSIZE, s_displayData, NULL };
+static context_t s_contexts[CONTEXT_DEPTH];
+static int s_depth = 0;
+static LCDSolidColor s_background = kColorWhite;
+
+static float s_refreshRate = 30.0f;
+static int s_inverted = 0;
+static unsigned int s_scale = 1;
+
+// setColorToPattern results live as long as the run, identical patterns are shared
+#define PATTERN_CACHE_SIZE 256
+static uint8_t s_patterns[PATTERN_CACHE_SIZE][16];
+static int s_patternCount = 0;
+
+#define CTX (&s_contexts[s_depth])
+
+//------------------------------------------------------------------------------
+// Pixels
+
+static inline int bitmap_get(const LCDBitmap* bitmap, int x, int y)
+{
+	return (bitmap->data[y * bitmap->rowbytes + (x >> 3)] >> (7 - (x & 7))) & 1;
+}
+
+static inline int bitmap_opaque(const LCDBitmap* bitmap, int x, int y)
+{
+	return bitmap->mask == NULL || ((bitmap->mask[y * bitmap->rowbytes + (x >> 3)] >> (7 - (x & 7))) & 1);
+}
+
+static inline void bitmap_set(LCDBitmap* bitmap, int x, int y, int white)
+{
+	uint8_t* byte = &bitmap->data[y * bitmap->rowbytes + (x >> 3)];
+	uint8_t bit = (uint8_t)(0x80 >> (x & 7));
+	*byte = white ? (uint8_t)(*byte | bit) : (uint8_t)(*byte & ~bit);
+	if (bitmap->mask)
+	{
+		bitmap->mask[y * bitmap->rowbytes + (x >> 3)] |= bit;
+	}
+}
+
+static inline void bitmap_clear(LCDBitmap* bitmap, int x, int y)
+{
+	if (bitmap->mask)
+	{
+		bitmap->mask[y * bitmap->rowbytes + (x >> 3)] &= (uint8_t)~(0x80 >> (x & 7));
+	}
+}
+
+static LCDBitmap* target(void)
+{
+	return CTX->target ? CTX->target : &s_frame;
+}
+
+static inline int stencil_allows(int x, int y)
+{
+	const LCDBitmap* stencil = CTX->stencil;
+	if (stencil == NULL)
+	{
+		return 1;
+	}
+	if (CTX->stencilTile)
+	{
+		x %= stencil->width;
+		y %= stencil->height;
+	}
+	else if (x >= stencil->width || y >= stencil->height)
+	{
+		return 0;
+	}
+	return bitmap_get(stencil, x, y);
+}
+
+// Paint a pixel in drawing coordinates with a solid color or a pattern
+static void plot(int x, int y, LCDColor color)
+{
+	x += CTX->dx;
+	y += CTX->dy;
+	if (x < CTX->clipX0 || y < CTX->clipY0 || x >= CTX->clipX1 || y >= CTX->clipY1 || !stencil_allows(x, y))
+	{
+		return;
+	}
+
+	LCDBitmap* bitmap = target();
+	switch (color)
+	{
+	case kColorBlack: bitmap_set(bitmap, x, y, 0); break;
+	case kColorWhite: bitmap_set(bitmap, x, y, 1); break;
+	case kColorClear: bitmap_clear(bitmap, x, y); break;
+	case kColorXOR: bitmap_set(bitmap, x, y, !bitmap_get(bitmap, x, y)); break;
+	default:
+	{
+		// Patterns are aligned on the target, not on the shape
+		const uint8_t* pattern = (const uint8_t*)color;
+		int bit = 7 - (x & 7);
+		if ((pattern[8 + (y & 7)] >> bit) & 1)
+		{
+			bitmap_set(bitmap, x, y, (pattern[y & 7] >> bit) & 1);
+		}
+		else
+		{
+			bitmap_clear(bitmap, x, y);
+		}
+	}
+	}
+}
+
+static void span(int x0, int x1, int y, LCDColor color)
+{
+	for (int x = x0; x < x1; ++x)
+	{
+		plot(x, y, color);
+	}
+}
+
+//------------------------------------------------------------------------------
+// Shapes
+
+static void gfx_fillRect(int x, int y, int width, int height, LCDColor color)
+{
+	if (width < 0) { x += width; width = -width; }
+	if (height < 0) { y += height; height = -height; }
+	for (int row = y; row < y + height; ++row)
+	{
+		span(x, x + width, row, color);
+	}
+}
+
+static void gfx_drawRect(int x, int y, int width, int height, LCDColor color)
+{
+	gfx_fillRect(x, y, width, 1, color);
+	gfx_fillRect(x, y + height - 1, width, 1, color);
+	gfx_fillRect(x, y + 1, 1, height - 2, color);
+	gfx_fillRect(x + width - 1, y + 1, 1, height - 2, color);
+}
+
+static int compare_float(const void* a, const void* b)
+{
+	float fa = *(const float*)a, fb = *(const float*)b;
+	return (fa > fb) - (fa < fb);
+}
+
+static void fill_polygon(int count, const float* coords, LCDColor color, LCDPolygonFillRule rule)
+{
+	if (count < 3)
+	{
+		return;
+	}
+
+	float minY = coords[1], maxY = coords[1];
+	for (int i = 1; i < count; ++i)
+	{
+		if (coords[i * 2 + 1] < minY) minY = coords[i * 2 + 1];
+		if (coords[i * 2 + 1] > maxY) maxY = coords[i * 2 + 1];
+	}
+
+	// Crossings store x and the edge direction in the sign of a second slot
+	float* crossings = malloc(sizeof(float) * 2 * (size_t)count);
+	if (crossings == NULL)
+	{
+		return;
+	}
+
+	for (int y = (int)floorf(minY); y <= (int)ceilf(maxY); ++y)
+	{
+		float sy = (float)y + 0.5f;
+		int found = 0;
+		for (int i = 0; i < count; ++i)
+		{
+			float x0 = coords[i * 2], y0 = coords[i * 2 + 1];
+			float x1 = coords[((i + 1) % count) * 2], y1 = coords[((i + 1) % count) * 2 + 1];
+			if ((y0 <= sy && y1 > sy) || (y1 <= sy && y0 > sy))
+			{
+				crossings[found * 2] = x0 + (sy - y0) * (x1 - x0) / (y1 - y0);
+				crossings[found * 2 + 1] = y1 > y0 ? 1.0f : -1.0f;
+				++found;
+			}
+		}
+		qsort(crossings, (size_t)found, sizeof(float) * 2, compare_float);
+
+		int winding = 0;
+		for (int i = 0; i + 1 < found; ++i)
+		{
+			winding += (int)crossings[i * 2 + 1];
+			int inside = rule == kPolygonFillEvenOdd ? ((i & 1) == 0) : (winding != 0);
+			if (inside)
+			{
+				span((int)ceilf(crossings[i * 2] - 0.5f), (int)ceilf(crossings[(i + 1) * 2] - 0.5f), y, color);
+			}
+		}
+	}
+	free(crossings);
+}
+
+static void gfx_fillPolygon(int nPoints, int* coords, LCDColor color, LCDPolygonFillRule fillRule)
+{
+	float* points = malloc(sizeof(float) * 2 * (size_t)nPoints);
+	if (points == NULL)
+	{
+		return;
+	}
+	for (int i = 0; i < nPoints * 2; ++i)
+	{
+		points[i] = (float)coords[i];
+	}
+	fill_polygon(nPoints, points, color, fillRule);
+	free(points);
+}
+
+static void gfx_fillTriangle(int x1, int y1, int x2, int y2, int x3, int y3, LCDColor color)
+{
+	float points[] = { (float)x1, (float)y1, (float)x2, (float)y2, (float)x3, (float)y3 };
+	fill_polygon(3, points, color, kPolygonFillNonZero);
+}
+
+// Playdate angles: degrees, 0 at the top, clockwise
+static int angle_inside(float dx, float dy, float startAngle, float endAngle)
+{
+	if (startAngle == endAngle)
+	{
+		return 1;
+	}
+	float angle = atan2f(dx, -dy) * (180.0f / (float)M_PI);
+	if (angle < 0.0f) angle += 360.0f;
+	float start = fmodf(startAngle, 360.0f);
+	float end = fmodf(endAngle, 360.0f);
+	if (start < 0.0f) start += 360.0f;
+	if (end < 0.0f) end += 360.0f;
+	return start <= end ? (angle >= start && angle <= end) : (angle >= start || angle <= end);
+}
+
+static void ellipse(int x, int y, int width, int height, int lineWidth, float startAngle, float endAngle, LCDColor color)
+{
+	float rx = (float)width * 0.5f, ry = (float)height * 0.5f;
+	float cx = (float)x + rx, cy = (float)y + ry;
+	float irx = rx - (float)lineWidth, iry = ry - (float)lineWidth;
+	for (int py = y; py < y + height; ++py)
+	{
+		for (int px = x; px < x + width; ++px)
+		{
+			float dx = (float)px + 0.5f - cx, dy = (float)py + 0.5f - cy;
+			if ((dx * dx) / (rx * rx) + (dy * dy) / (ry * ry) > 1.0f)
+			{
+				continue;
+			}
+			if (lineWidth > 0 && irx > 0.0f && iry > 0.0f && (dx * dx) / (irx * irx) + (dy * dy) / (iry * iry) < 1.0f)
+			{
+				continue;
+			}
+			if (angle_inside(dx, dy, startAngle, endAngle))
+			{
+				plot(px, py, color);
+			}
+		}
+	}
+}
+
+static void gfx_drawEllipse(int x, int y, int width, int height, int lineWidth, float startAngle, float endAngle, LCDColor color)
+{
+	ellipse(x, y, width, height, lineWidth > 0 ? lineWidth : 1, startAngle, endAngle, color);
+}
+
+static void gfx_fillEllipse(int x, int y, int width, int height, float startAngle, float endAngle, LCDColor color)
+{
+	ellipse(x, y, width, height, 0, startAngle, endAngle, color);
+}
+
+static int inside_round_rect(int px, int py, int x, int y, int width, int height, int radius)
+{
+	if (px < x || py < y || px >= x + width || py >= y + height)
+	{
+		return 0;
+	}
+	int dx = px < x + radius ? x + radius - px : (px >= x + width - radius ? px - (x + width - radius - 1) : 0);
+	int dy = py < y + radius ? y + radius - py : (py >= y + height - radius ? py - (y + height - radius - 1) : 0);
+	return dx * dx + dy * dy <= radius * radius;
+}
+
+static void gfx_fillRoundRect(int x, int y, int width, int height, int radius, LCDColor color)
+{
+	for (int py = y; py < y + height; ++py)
+	{
+		for (int px = x; px < x + width; ++px)
+		{
+			if (inside_round_rect(px, py, x, y, width, height, radius)) plot(px, py, color);
+		}
+	}
+}
+
+static void gfx_drawRoundRect(int x, int y, int width, int height, int radius, int lineWidth, LCDColor color)
+{
+	int inner = radius > lineWidth ? radius - lineWidth : 0;
+	for (int py = y; py < y + height; ++py)
+	{
+		for (int px = x; px < x + width; ++px)
+		{
+			if (inside_round_rect(px, py, x, y, width, height, radius)
+				&& !inside_round_rect(px, py, x + lineWidth, y + lineWidth, width - 2 * lineWidth, height - 2 * lineWidth, inner))
+			{
+				plot(px, py, color);
+			}
+		}
+	}
+}
+
+static void gfx_drawLine(int x1, int y1, int x2, int y2, int width, LCDColor color)
+{
+	if (width <= 1)
+	{
+		// Bresenham
+		int dx = abs(x2 - x1), sx = x1 < x2 ? 1 : -1;
+		int dy = -abs(y2 - y1), sy = y1 < y2 ? 1 : -1;
+		int err = dx + dy;
+		for (;;)
+		{
+			plot(x1, y1, color);
+			if (x1 == x2 && y1 == y2) break;
+			int e2 = 2 * err;
+			if (e2 >= dy) { err += dy; x1 += sx; }
+			if (e2 <= dx) { err += dx; y1 += sy; }
+		}
+		return;
+	}
+
+	float fx1 = (float)x1 + 0.5f, fy1 = (float)y1 + 0.5f;
+	float fx2 = (float)x2 + 0.5f, fy2 = (float)y2 + 0.5f;
+	float len = sqrtf((fx2 - fx1) * (fx2 - fx1) + (fy2 - fy1) * (fy2 - fy1));
+	float half = (float)width * 0.5f;
+	float ux = len > 0.0f ? (fx2 - fx1) / len : 1.0f;
+	float uy = len > 0.0f ? (fy2 - fy1) / len : 0.0f;
+	if (CTX->cap == kLineCapStyleSquare)
+	{
+		fx1 -= ux * half; fy1 -= uy * half;
+		fx2 += ux * half; fy2 += uy * half;
+	}
+
+	float nx = -uy * half, ny = ux * half;
+	float quad[] = { fx1 + nx, fy1 + ny, fx2 + nx, fy2 + ny, fx2 - nx, fy2 - ny, fx1 - nx, fy1 - ny };
+	fill_polygon(4, quad, color, kPolygonFillNonZero);
+
+	if (CTX->cap == kLineCapStyleRound)
+	{
+		ellipse(x1 - width / 2, y1 - width / 2, width, width, 0, 0.0f, 0.0f, color);
+		ellipse(x2 - width / 2, y2 - width / 2, width, width, 0, 0.0f, 0.0f, color);
+	}
+}
+
+static void gfx_setPixel(int x, int y, LCDColor color)
+{
+	plot(x, y, color);
+}
+
+static void gfx_clear(LCDColor color)
+{
+	// Whole target, whatever the clip rect and offset
+	context_t saved = *CTX;
+	LCDBitmap* bitmap = target();
+	CTX->dx = CTX->dy = 0;
+	CTX->clipX0 = CTX->clipY0 = 0;
+	CTX->clipX1 = bitmap->width;
+	CTX->clipY1 = bitmap->height;
+	CTX->stencil = NULL;
+	gfx_fillRect(0, 0, bitmap->width, bitmap->height, color);
+	*CTX = saved;
+}
+
+//------------------------------------------------------------------------------
+// Bitmaps
+
+static void draw_pixel(int x, int y, int white)
+{
+	int dst = 0;
+	LCDBitmap* bitmap = target();
+	int tx = x + CTX->dx, ty = y + CTX->dy;
+	if (tx >= 0 && ty >= 0 && tx < bitmap->width && ty < bitmap->height)
+	{
+		dst = bitmap_get(bitmap, tx, ty);
+	}
+
+	switch (CTX->mode)
+	{
+	case kDrawModeCopy: plot(x, y, white ? kColorWhite : kColorBlack); break;
+	case kDrawModeWhiteTransparent: if (!white) plot(x, y, kColorBlack); break;
+	case kDrawModeBlackTransparent: if (white) plot(x, y, kColorWhite); break;
+	case kDrawModeFillWhite: plot(x, y, kColorWhite); break;
+	case kDrawModeFillBlack: plot(x, y, kColorBlack); break;
+	case kDrawModeXOR: plot(x, y, (dst ^ white) ? kColorWhite : kColorBlack); break;
+	case kDrawModeNXOR: plot(x, y, (dst ^ white) ? kColorBlack : kColorWhite); break;
+	case kDrawModeInverted: plot(x, y, white ? kColorBlack : kColorWhite); break;
+	}
+}
+
+static void draw_region(const LCDBitmap* bitmap, int sx, int sy, int width, int height, int x, int y, LCDBitmapFlip flip)
+{
+	for (int row = 0; row < height; ++row)
+	{
+		for (int col = 0; col < width; ++col)
+		{
+			int bx = sx + ((flip == kBitmapFlippedX || flip == kBitmapFlippedXY) ? width - 1 - col : col);
+			int by = sy + ((flip == kBitmapFlippedY || flip == kBitmapFlippedXY) ? height - 1 - row : row);
+			if (bitmap_opaque(bitmap, bx, by))
+			{
+				draw_pixel(x + col, y + row, bitmap_get(bitmap, bx, by));
+			}
+		}
+	}
+}
+
+static void gfx_drawBitmap(LCDBitmap* bitmap, int x, int y, LCDBitmapFlip flip)
+{
+	draw_region(bitmap, 0, 0, bitmap->width, bitmap->height, x, y, flip);
+}
+
+static void gfx_tileBitmap(LCDBitmap* bitmap, int x, int y, int width, int height, LCDBitmapFlip flip)
+{
+	for (int ty = 0; ty < height; ty += bitmap->height)
+	{
+		for (int tx = 0; tx < width; tx += bitmap->width)
+		{
+			int w = width - tx < bitmap->width ? width - tx : bitmap->width;
+			int h = height - ty < bitmap->height ? height - ty : bitmap->height;
+			draw_region(bitmap, 0, 0, w, h, x + tx, y + ty, flip);
+		}
+	}
+}
+
+static void gfx_drawScaledBitmap(LCDBitmap* bitmap, int x, int y, float xscale, float yscale)
+{
+	int width = (int)fabsf((float)bitmap->width * xscale);
+	int height = (int)fabsf((float)bitmap->height * yscale);
+	for (int row = 0; row < height; ++row)
+	{
+		for (int col = 0; col < width; ++col)
+		{
+			int bx = (int)((float)col / fabsf(xscale));
+			int by = (int)((float)row / fabsf(yscale));
+			if (xscale < 0.0f) bx = bitmap->width - 1 - bx;
+			if (yscale < 0.0f) by = bitmap->height - 1 - by;
+			if (bx < bitmap->width && by < bitmap->height && bitmap_opaque(bitmap, bx, by))
+			{
+				draw_pixel(x + col, y + row, bitmap_get(bitmap, bx, by));
+			}
+		}
+	}
+}
+
+static void gfx_drawRotatedBitmap(LCDBitmap* bitmap, int x, int y, float rotation, float centerx, float centery, float xscale, float yscale)
+{
+	// Inverse mapping of every pixel of the rotated bounding box
+	float radians = rotation * ((float)M_PI / 180.0f);
+	float c = cosf(radians), s = sinf(radians);
+	float w = (float)bitmap->width * fabsf(xscale), h = (float)bitmap->height * fabsf(yscale);
+	int extent = (int)ceilf(sqrtf(w * w + h * h));
+	for (int py = y - extent; py <= y + extent; ++py)
+	{
+		for (int px = x - extent; px <= x + extent; ++px)
+		{
+			float dx = (float)px + 0.5f - (float)x, dy = (float)py + 0.5f - (float)y;
+			float u = (c * dx + s * dy) / xscale + centerx * (float)bitmap->width;
+			float v = (-s * dx + c * dy) / yscale + centery * (float)bitmap->height;
+			int bx = (int)floorf(u), by = (int)floorf(v);
+			if (bx >= 0 && by >= 0 && bx < bitmap->width && by < bitmap->height && bitmap_opaque(bitmap, bx, by))
+			{
+				draw_pixel(px, py, bitmap_get(bitmap, bx, by));
+			}
+		}
+	}
+}
+
+static LCDBitmap* bitmap_alloc(int width, int height, int withMask)
+{
+	LCDBitmap* bitmap = calloc(1, sizeof(LCDBitmap));
+	if (bitmap == NULL)
+	{
+		return NULL;
+	}
+	bitmap->width = width;
+	bitmap->height = height;
+	bitmap->rowbytes = ((width + 31) / 32) * 4;
+	bitmap->data = calloc((size_t)(bitmap->rowbytes * height), 1);
+	bitmap->mask = withMask ? calloc((size_t)(bitmap->rowbytes * height), 1) : NULL;
+	if (bitmap->data == NULL || (withMask && bitmap->mask == NULL))
+	{
+		free(bitmap->data);
+		free(bitmap->mask);
+		free(bitmap);
+		return NULL;
+	}
+	return bitmap;
+}
+
+static void gfx_clearBitmap(LCDBitmap* bitmap, LCDColor color)
+{
+	context_t* ctx = &s_contexts[s_depth];
+	context_t saved = *ctx;
+	ctx->target = bitmap;
+	ctx->dx = ctx->dy = 0;
+	ctx->clipX0 = ctx->clipY0 = 0;
+	ctx->clipX1 = bitmap->width;
+	ctx->clipY1 = bitmap->height;
+	ctx->stencil = NULL;
+	gfx_fillRect(0, 0, bitmap->width, bitmap->height, color);
+	*ctx = saved;
+}
+
+static LCDBitmap* gfx_newBitmap(int width, int height, LCDColor bgcolor)
+{
+	LCDBitmap* bitmap = bitmap_alloc(width, height, bgcolor == kColorClear);
+	if (bitmap && bgcolor != kColorClear)
+	{
+		gfx_clearBitmap(bitmap, bgcolor);
+	}
+	return bitmap;
+}
+
+static void gfx_freeBitmap(LCDBitmap* bitmap)
+{
+	if (bitmap && bitmap != &s_frame && bitmap != &s_display)
+	{
+		free(bitmap->data);
+		free(bitmap->mask);
+		free(bitmap);
+	}
+}
+
+static LCDBitmap* gfx_copyBitmap(LCDBitmap* bitmap)
+{
+	LCDBitmap* copy = bitmap_alloc(bitmap->width, bitmap->height, bitmap->mask != NULL);
+	if (copy)
+	{
+		memcpy(copy->data, bitmap->data, (size_t)(bitmap->rowbytes * bitmap->height));
+		if (bitmap->mask) memcpy(copy->mask, bitmap->mask, (size_t)(bitmap->rowbytes * bitmap->height));
+	}
+	return copy;
+}
+
+static void gfx_getBitmapData(LCDBitmap* bitmap, int* width, int* height, int* rowbytes, uint8_t** mask, uint8_t** data)
+{
+	if (width) *width = bitmap->width;
+	if (height) *height = bitmap->height;
+	if (rowbytes) *rowbytes = bitmap->rowbytes;
+	if (mask) *mask = bitmap->mask;
+	if (data) *data = bitmap->data;
+}
+
+static LCDSolidColor gfx_getBitmapPixel(LCDBitmap* bitmap, int x, int y)
+{
+	if (x < 0 || y < 0 || x >= bitmap->width || y >= bitmap->height || !bitmap_opaque(bitmap, x, y))
+	{
+		return kColorClear;
+	}
+	return bitmap_get(bitmap, x, y) ? kColorWhite : kColorBlack;
+}
+
+static uint8_t* read_whole(FILE* file, size_t* size)
+{
+	fseek(file, 0, SEEK_END);
+	long length = ftell(file);
+	fseek(file, 0, SEEK_SET);
+	uint8_t* data = length > 0 ? malloc((size_t)length) : NULL;
+	if (data && fread(data, 1, (size_t)length, file) != (size_t)length)
+	{
+		free(data);
+		data = NULL;
+	}
+	fclose(file);
+	*size = (size_t)length;
+	return data;
+}
+
+// The pdx holds compiled .pdi images, the host reads the PNG sources
+static LCDBitmap* load_png(const char* path, const char** outerr)
+{
+	FILE* file = host_open_source(path, ".png");
+	if (file == NULL)
+	{
+		if (outerr) *outerr = "file not found (the host build reads .png images from the source directory)";
+		return NULL;
+	}
+
+	size_t size = 0;
+	uint8_t* data = read_whole(file, &size);
+	int width = 0, height = 0;
+	uint8_t* pixels = data ? host_png_decode(data, size, &width, &height) : NULL;
+	free(data);
+	if (pixels == NULL)
+	{
+		if (outerr) *outerr = "unsupported or corrupted PNG";
+		return NULL;
+	}
+
+	int transparent = 0;
+	for (int i = 0; i < width * height; ++i)
+	{
+		if (pixels[i * 2 + 1] < 128) { transparent = 1; break; }
+	}
+
+	LCDBitmap* bitmap = bitmap_alloc(width, height, transparent);
+	if (bitmap)
+	{
+		for (int y = 0; y < height; ++y)
+		{
+			for (int x = 0; x < width; ++x)
+			{
+				const uint8_t* pixel = &pixels[(y * width + x) * 2];
+				if (pixel[1] >= 128)
+				{
+					bitmap_set(bitmap, x, y, pixel[0] >= 128);
+				}
+			}
+		}
+	}
+	free(pixels);
+	return bitmap;
+}
+
+static LCDBitmap* gfx_loadBitmap(const char* path, const char** outerr)
+{
+	if (outerr) *outerr = NULL;
+	return load_png(path, outerr);
+}
+
+static void gfx_setColorToPattern(LCDColor* color, LCDBitmap* bitmap, int x, int y)
+{
+	uint8_t pattern[16];
+	for (int row = 0; row < 8; ++row)
+	{
+		uint8_t bits = 0, mask = 0;
+		for (int col = 0; col < 8; ++col)
+		{
+			int bx = (x + col) % bitmap->width, by = (y + row) % bitmap->height;
+			bits = (uint8_t)(bits << 1 | bitmap_get(bitmap, bx, by));
+			mask = (uint8_t)(mask << 1 | bitmap_opaque(bitmap, bx, by));
+		}
+		pattern[row] = bits;
+		pattern[row + 8] = mask;
+	}
+
+	for (int i = 0; i < s_patternCount; ++i)
+	{
+		if (memcmp(s_patterns[i], pattern, sizeof(pattern)) == 0)
+		{
+			*color = (LCDColor)s_patterns[i];
+			return;
+		}
+	}
+	if (s_patternCount == PATTERN_CACHE_SIZE)
+	{
+		fprintf(stderr, "host: more than %d distinct patterns, recycling\n", PATTERN_CACHE_SIZE);
+		s_patternCount = 0;
+	}
+	memcpy(s_patterns[s_patternCount], pattern, sizeof(pattern));
+	*color = (LCDColor)s_patterns[s_patternCount++];
+}
+
+//------------------------------------------------------------------------------
+// Fonts
+// Reads the .fnt source and its `<name>-table-<w>-<h>.png` glyph table.
+
+static uint32_t next_codepoint(const uint8_t** text, PDStringEncoding encoding)
+{
+	const uint8_t* p = *text;
+	uint32_t c = *p++;
+	if (encoding == kUTF8Encoding && c >= 0x80)
+	{
+		int extra = c >= 0xF0 ? 3 : (c >= 0xE0 ? 2 : 1);
+		c &= 0x3F >> extra;
+		while (extra-- && (*p & 0xC0) == 0x80)
+		{
+			c = (c << 6) | (*p++ & 0x3F);
+		}
+	}
+	else if (encoding == k16BitLEEncoding)
+	{
+		c |= (uint32_t)*p++ << 8;
+	}
+	*text = p;
+	return c;
+}
+
+static const font_glyph_t* font_glyph(const LCDFont* font, uint32_t codepoint)
+{
+	for (int i = 0; i < font->glyphCount; ++i)
+	{
+		if (font->glyphs[i].codepoint == codepoint) return &font->glyphs[i];
+	}
+	return NULL;
+}
+
+static int find_font_table(const char* fntPath, char* tablePath, size_t size, int* cellWidth, int* cellHeight)
+{
+	const char* slash = strrchr(fntPath, '/');
+	size_t dirLength = slash ? (size_t)(slash - fntPath) : 0;
+	const char* base = slash ? slash + 1 : fntPath;
+	size_t baseLength = strlen(base) - 4;  // without .fnt
+
+	char dirPath[1024];
+	snprintf(dirPath, sizeof(dirPath), "%.*s", (int)(dirLength ? dirLength : 1), dirLength ? fntPath : ".");
+	DIR* dir = opendir(dirPath);
+	if (dir == NULL)
+	{
+		return -1;
+	}
+
+	int found = -1;
+	struct dirent* entry;
+	while ((entry = readdir(dir)))
+	{
+		if (strncmp(entry->d_name, base, baseLength) == 0
+			&& sscanf(entry->d_name + baseLength, "-table-%d-%d.png", cellWidth, cellHeight) == 2)
+		{
+			snprintf(tablePath, size, "%s/%s", dirPath, entry->d_name);
+			found = 0;
+			break;
+		}
+	}
+	closedir(dir);
+	return found;
+}
+
+static LCDFont* gfx_loadFont(const char* path, const char** outErr)
+{
+	if (outErr) *outErr = NULL;
+
+	LCDFont* font = calloc(1, sizeof(LCDFont));
+	if (font == NULL)
+	{
+		return NULL;
+	}
+
+	// No system fonts on the host: text drawn with them is just not rendered
+	if (strncmp(path, "/System/", 8) == 0)
+	{
+		font->height = 16;
+		return font;
+	}
+
+	// font/name.pft -> <source>/font/name.fnt
+	char name[1024];
+	snprintf(name, sizeof(name), "%s", path);
+	char* extension = strrchr(name, '.');
+	if (extension && strchr(extension, '/') == NULL) *extension = 0;
+
+	char fntPath[1100];
+	snprintf(fntPath, sizeof(fntPath), "%s/%s.fnt", host_options.sourceDir, name);
+	FILE* file = fopen(fntPath, "r");
+	char tablePath[1200];
+	if (file == NULL || find_font_table(fntPath, tablePath, sizeof(tablePath), &font->cellWidth, &font->cellHeight))
+	{
+		if (file) fclose(file);
+		free(font);
+		if (outErr) *outErr = "font not found (the host build reads .fnt sources and their -table-W-H.png)";
+		return NULL;
+	}
+
+	char line[256];
+	while (fgets(line, sizeof(line), file))
+	{
+		if (strncmp(line, "tracking=", 9) == 0)
+		{
+			font->tracking = atoi(line + 9);
+			continue;
+		}
+		if (line[0] == '-' && line[1] == '-')
+		{
+			continue;
+		}
+
+		char* tab = strchr(line, '\t');
+		if (tab == NULL || tab == line)
+		{
+			continue;
+		}
+		*tab = 0;
+		const uint8_t* token = (const uint8_t*)line;
+		uint32_t codepoint = strcmp(line, "space") == 0 ? ' ' : next_codepoint(&token, kUTF8Encoding);
+		if (strcmp(line, "space") != 0 && *token)
+		{
+			continue;  // kerning pair
+		}
+		if (font->glyphCount < (int)(sizeof(font->glyphs) / sizeof(font->glyphs[0])))
+		{
+			font_glyph_t* glyph = &font->glyphs[font->glyphCount];
+			glyph->codepoint = codepoint;
+			glyph->cell = (uint16_t)font->glyphCount;
+			glyph->advance = (uint8_t)atoi(tab + 1);
+			++font->glyphCount;
+		}
+	}
+	fclose(file);
+
+	// The table path is already rooted in the source directory
+	FILE* table = fopen(tablePath, "rb");
+	size_t size = 0;
+	uint8_t* data = table ? read_whole(table, &size) : NULL;
+	int width = 0, height = 0;
+	uint8_t* pixels = data ? host_png_decode(data, size, &width, &height) : NULL;
+	free(data);
+	font->table = pixels ? bitmap_alloc(width, height, 1) : NULL;
+	if (font->table == NULL)
+	{
+		free(pixels);
+		free(font);
+		if (outErr) *outErr = "can't decode the font table";
+		return NULL;
+	}
+	for (int y = 0; y < height; ++y)
+	{
+		for (int x = 0; x < width; ++x)
+		{
+			const uint8_t* pixel = &pixels[(y * width + x) * 2];
+			if (pixel[1] >= 128) bitmap_set(font->table, x, y, pixel[0] >= 128);
+		}
+	}
+	free(pixels);
+
+	font->columns = width / font->cellWidth;
+	font->height = font->cellHeight;
+	return font;
+}
+
+static LCDFont* current_font(void)
+{
+	return CTX->font;
+}
+
+static int text_width(LCDFont* font, const void* text, size_t len, PDStringEncoding encoding, int tracking)
+{
+	if (font == NULL)
+	{
+		return 0;
+	}
+	const uint8_t* p = text;
+	int width = 0, lineWidth = 0;
+	for (size_t i = 0; i < len && *p; ++i)
+	{
+		uint32_t c = next_codepoint(&p, encoding);
+		if (c == '\n')
+		{
+			lineWidth = 0;
+			continue;
+		}
+		const font_glyph_t* glyph = font_glyph(font, c);
+		lineWidth += (glyph ? glyph->advance : font->cellWidth) + tracking;
+		if (lineWidth > width) width = lineWidth;
+	}
+	return width > 0 ? width - tracking : 0;
+}
+
+static int draw_text(const void* text, size_t len, PDStringEncoding encoding, int x, int y)
+{
+	LCDFont* font = current_font();
+	if (font == NULL)
+	{
+		return 0;
+	}
+
+	const uint8_t* p = text;
+	int penX = x, width = 0;
+	for (size_t i = 0; i < len && *p; ++i)
+	{
+		uint32_t c = next_codepoint(&p, encoding);
+		if (c == '\n')
+		{
+			penX = x;
+			y += font->height + CTX->leading;
+			continue;
+		}
+		const font_glyph_t* glyph = font_glyph(font, c);
+		if (glyph && font->table)
+		{
+			int cx = (glyph->cell % font->columns) * font->cellWidth;
+			int cy = (glyph->cell / font->columns) * font->cellHeight;
+			draw_region(font->table, cx, cy, font->cellWidth, font->cellHeight, penX, y, kBitmapUnflipped);
+		}
+		penX += (glyph ? glyph->advance : font->cellWidth) + CTX->tracking + font->tracking;
+		if (penX - x > width) width = penX - x;
+	}
+	return width;
+}
+
+static int gfx_drawText(const void* text, size_t len, PDStringEncoding encoding, int x, int y)
+{
+	return draw_text(text, len, encoding, x, y);
+}
+
+static void gfx_drawTextInRect(const void* text, size_t len, PDStringEncoding encoding, int x, int y, int width, int height, PDTextWrappingMode wrap, PDTextAlignment align)
+{
+	LCDFont* font = current_font();
+	if (font == NULL)
+	{
+		return;
+	}
+
+	// Clip to the rectangle while drawing
+	context_t saved = *CTX;
+	int x0 = x + CTX->dx, y0 = y + CTX->dy;
+	if (x0 > CTX->clipX0) CTX->clipX0 = x0;
+	if (y0 > CTX->clipY0) CTX->clipY0 = y0;
+	if (x0 + width < CTX->clipX1) CTX->clipX1 = x0 + width;
+	if (y0 + height < CTX->clipY1) CTX->clipY1 = y0 + height;
+
+	const uint8_t* p = text;
+	const uint8_t* end = p;
+	for (size_t i = 0; i < len && *end; ++i) next_codepoint(&end, encoding);
+
+	int lineY = y;
+	while (p < end && lineY < y + height)
+	{
+		// Longest run of characters that fits, backing off to the last space in word mode
+		const uint8_t* lineEnd = p;
+		const uint8_t* lastSpace = NULL;
+		int lineWidth = 0;
+		while (lineEnd < end)
+		{
+			const uint8_t* next = lineEnd;
+			uint32_t c = next_codepoint(&next, encoding);
+			if (c == '\n') break;
+			const font_glyph_t* glyph = font_glyph(font, c);
+			int advance = (glyph ? glyph->advance : font->cellWidth) + CTX->tracking + font->tracking;
+			if (wrap != kWrapClip && lineWidth + advance > width && lineEnd > p) break;
+			if (c == ' ') lastSpace = lineEnd;
+			lineWidth += advance;
+			lineEnd = next;
+		}
+		if (wrap == kWrapWord && lastSpace && lineEnd < end && *lineEnd != '\n')
+		{
+			lineEnd = lastSpace;
+		}
+
+		size_t count = 0;
+		for (const uint8_t* q = p; q < lineEnd; next_codepoint(&q, encoding)) ++count;
+		int drawWidth = text_width(font, p, count, encoding, CTX->tracking + font->tracking);
+		int lineX = align == kAlignTextCenter ? x + (width - drawWidth) / 2 : (align == kAlignTextRight ? x + width - drawWidth : x);
+		draw_text(p, count, encoding, lineX, lineY);
+
+		p = lineEnd;
+		if (p < end)
+		{
+			next_codepoint(&p, encoding);  // newline or the space we wrapped at
+		}
+		lineY += font->height + CTX->leading;
+	}
+	*CTX = saved;
+}
+
+static int gfx_getTextWidth(LCDFont* font, const void* text, size_t len, PDStringEncoding encoding, int tracking)
+{
+	return text_width(font, text, len, encoding, tracking + (font ? font->tracking : 0));
+}
+
+static uint8_t gfx_getFontHeight(LCDFont* font)
+{
+	return (uint8_t)(font ? font->height : 0);
+}
+
+void host_graphics_draw_fps(const char* text, int len, int x, int y)
+{
+	// Like the device: black on white, whatever the current context
+	context_t saved = *CTX;
+	CTX->target = NULL;
+	CTX->dx = CTX->dy = 0;
+	CTX->clipX0 = CTX->clipY0 = 0;
+	CTX->clipX1 = LCD_COLUMNS;
+	CTX->clipY1 = LCD_ROWS;
+	CTX->mode = kDrawModeCopy;
+	CTX->stencil = NULL;
+	LCDFont* font = current_font();
+	if (font)
+	{
+		gfx_fillRect(x, y, gfx_getTextWidth(font, text, (size_t)len, kASCIIEncoding, 0) + 2, font->height + 2, kColorWhite);
+		draw_text(text, (size_t)len, kASCIIEncoding, x + 1, y + 1);
+	}
+	*CTX = saved;
+}
+
+//------------------------------------------------------------------------------
+// Context
+
+static void reset_clip(context_t* ctx)
+{
+	LCDBitmap* bitmap = ctx->target ? ctx->target : &s_frame;
+	ctx->clipX0 = ctx->clipY0 = 0;
+	ctx->clipX1 = bitmap->width;
+	ctx->clipY1 = bitmap->height;
+}
+
+static void gfx_pushContext(LCDBitmap* bitmap)
+{
+	if (s_depth + 1 == CONTEXT_DEPTH)
+	{
+		fprintf(stderr, "host: pushContext nested too deep\n");
+		return;
+	}
+	s_contexts[s_depth + 1] = s_contexts[s_depth];
+	++s_depth;
+	CTX->target = bitmap;
+	CTX->dx = CTX->dy = 0;
+	CTX->stencil = NULL;
+	reset_clip(CTX);
+}
+
+static void gfx_popContext(void)
+{
+	if (s_depth > 0) --s_depth;
+}
+
+static LCDBitmapDrawMode gfx_setDrawMode(LCDBitmapDrawMode mode)
+{
+	LCDBitmapDrawMode previous = CTX->mode;
+	CTX->mode = mode;
+	return previous;
+}
+
+static void gfx_setDrawOffset(int dx, int dy)
+{
+	CTX->dx = dx;
+	CTX->dy = dy;
+}
+
+static void gfx_setScreenClipRect(int x, int y, int width, int height)
+{
+	reset_clip(CTX);
+	if (x > CTX->clipX0) CTX->clipX0 = x;
+	if (y > CTX->clipY0) CTX->clipY0 = y;
+	if (x + width < CTX->clipX1) CTX->clipX1 = x + width;
+	if (y + height < CTX->clipY1) CTX->clipY1 = y + height;
+}
+
+static void gfx_setClipRect(int x, int y, int width, int height)
+{
+	gfx_setScreenClipRect(x + CTX->dx, y + CTX->dy, width, height);
+}
+
+static void gfx_clearClipRect(void)
+{
+	reset_clip(CTX);
+}
+
+static void gfx_setLineCapStyle(LCDLineCapStyle style)
+{
+	CTX->cap = style;
+}
+
+static void gfx_setFont(LCDFont* font)
+{
+	CTX->font = font;
+}
+
+static void gfx_setTextTracking(int tracking)
+{
+	CTX->tracking = tracking;
+}
+
+static int gfx_getTextTracking(void)
+{
+	return CTX->tracking;
+}
+
+static void gfx_setTextLeading(int leading)
+{
+	CTX->leading = leading;
+}
+
+static void gfx_setStencilImage(LCDBitmap* stencil, int tile)
+{
+	CTX->stencil = stencil;
+	CTX->stencilTile = tile;
+}
+
+static void gfx_setStencil(LCDBitmap* stencil)
+{
+	gfx_setStencilImage(stencil, 0);
+}
+
+static void gfx_setBackgroundColor(LCDSolidColor color)
+{
+	s_background = color;
+}
+
+//------------------------------------------------------------------------------
+// Frame buffer and display
+
+static uint8_t* gfx_getFrame(void)
+{
+	return s_frameData;
+}
+
+static uint8_t* gfx_getDisplayFrame(void)
+{
+	return s_displayData;
+}
+
+static LCDBitmap* gfx_getDisplayBufferBitmap(void)
+{
+	return &s_display;
+}
+
+static LCDBitmap* gfx_copyFrameBufferBitmap(void)
+{
+	return gfx_copyBitmap(&s_frame);
+}
+
+static LCDBitmap* gfx_getDebugBitmap(void)
+{
+	return NULL;
+}
+
+static void gfx_markUpdatedRows(int start, int end)
+{
+}
+
+static void gfx_display(void)
+{
+	host_graphics_present();
+}
+
+void host_graphics_present(void)
+{
+	memcpy(s_displayData, s_frameData, sizeof(s_displayData));
+}
+
+void host_graphics_begin_frame(void)
+{
+	// The device resets the drawing state before every update
+	s_depth = 0;
+	CTX->dx = CTX->dy = 0;
+	CTX->stencil = NULL;
+	reset_clip(CTX);
+}
+
+int pdhost_write_pbm(const char* path)
+{
+	FILE* file = fopen(path, "wb");
+	if (file == NULL)
+	{
+		return -1;
+	}
+
+	// PBM: 1 = black, rows padded to a byte
+	fprintf(file, "P4\n%d %d\n", LCD_COLUMNS, LCD_ROWS);
+	uint8_t row[LCD_COLUMNS / 8];
+	for (int y = 0; y < LCD_ROWS; ++y)
+	{
+		for (int i = 0; i < LCD_COLUMNS / 8; ++i)
+		{
+			uint8_t bits = s_displayData[y * LCD_ROWSIZE + i];
+			row[i] = s_inverted ? bits : (uint8_t)~bits;
+		}
+		fwrite(row, 1, sizeof(row), file);
+	}
+	return fclose(file) == 0 ? 0 : -1;
+}
+
+static int display_getWidth(void) { return LCD_COLUMNS / (int)s_scale; }
+static int display_getHeight(void) { return LCD_ROWS / (int)s_scale; }
+static void display_setRefreshRate(float rate) { s_refreshRate = rate; }
+static void display_setInverted(int flag) { s_inverted = flag; }
+static void display_setScale(unsigned int scale) { s_scale = scale == 2 || scale == 4 || scale == 8 ? scale : 1; }
+static void display_ignore(void) {}
+
+float host_refresh_rate(void)
+{
+	return s_refreshRate;
+}
+
+void host_graphics_shutdown(void)
+{
+	s_patternCount = 0;
+}
+
+void host_graphics_init(struct playdate_graphics* gfx, struct playdate_display* display)
+{
+	memset(s_frameData, 0xFF, sizeof(s_frameData));
+	memset(s_displayData, 0xFF, sizeof(s_displayData));
+	memset(s_contexts, 0, sizeof(s_contexts));
+	reset_clip(CTX);
+
+	host_fill_unimplemented(gfx, sizeof(*gfx));
+	gfx->video = NULL;
+	HOST_SET(gfx, clear, gfx_clear);
+	HOST_SET(gfx, setBackgroundColor, gfx_setBackgroundColor);
+	HOST_SET(gfx, setStencil, gfx_setStencil);
+	HOST_SET(gfx, setDrawMode, gfx_setDrawMode);
+	HOST_SET(gfx, setDrawOffset, gfx_setDrawOffset);
+	HOST_SET(gfx, setClipRect, gfx_setClipRect);
+	HOST_SET(gfx, clearClipRect, gfx_clearClipRect);
+	HOST_SET(gfx, setLineCapStyle, gfx_setLineCapStyle);
+	HOST_SET(gfx, setFont, gfx_setFont);
+	HOST_SET(gfx, setTextTracking, gfx_setTextTracking);
+	HOST_SET(gfx, pushContext, gfx_pushContext);
+	HOST_SET(gfx, popContext, gfx_popContext);
+	HOST_SET(gfx, drawBitmap, gfx_drawBitmap);
+	HOST_SET(gfx, tileBitmap, gfx_tileBitmap);
+	HOST_SET(gfx, drawLine, gfx_drawLine);
+	HOST_SET(gfx, fillTriangle, gfx_fillTriangle);
+	HOST_SET(gfx, drawRect, gfx_drawRect);
+	HOST_SET(gfx, fillRect, gfx_fillRect);
+	HOST_SET(gfx, drawEllipse, gfx_drawEllipse);
+	HOST_SET(gfx, fillEllipse, gfx_fillEllipse);
+	HOST_SET(gfx, drawScaledBitmap, gfx_drawScaledBitmap);
+	HOST_SET(gfx, drawText, gfx_drawText);
+	HOST_SET(gfx, newBitmap, gfx_newBitmap);
+	HOST_SET(gfx, freeBitmap, gfx_freeBitmap);
+	HOST_SET(gfx, loadBitmap, gfx_loadBitmap);
+	HOST_SET(gfx, copyBitmap, gfx_copyBitmap);
+	HOST_SET(gfx, getBitmapData, gfx_getBitmapData);
+	HOST_SET(gfx, clearBitmap, gfx_clearBitmap);
+	HOST_SET(gfx, loadFont, gfx_loadFont);
+	HOST_SET(gfx, getTextWidth, gfx_getTextWidth);
+	HOST_SET(gfx, getFrame, gfx_getFrame);
+	HOST_SET(gfx, getDisplayFrame, gfx_getDisplayFrame);
+	HOST_SET(gfx, getDebugBitmap, gfx_getDebugBitmap);
+	HOST_SET(gfx, copyFrameBufferBitmap, gfx_copyFrameBufferBitmap);
+	HOST_SET(gfx, markUpdatedRows, gfx_markUpdatedRows);
+	HOST_SET(gfx, display, gfx_display);
+	HOST_SET(gfx, setColorToPattern, gfx_setColorToPattern);
+	HOST_SET(gfx, setScreenClipRect, gfx_setScreenClipRect);
+	HOST_SET(gfx, fillPolygon, gfx_fillPolygon);
+	HOST_SET(gfx, getFontHeight, gfx_getFontHeight);
+	HOST_SET(gfx, getDisplayBufferBitmap, gfx_getDisplayBufferBitmap);
+	HOST_SET(gfx, drawRotatedBitmap, gfx_drawRotatedBitmap);
+	HOST_SET(gfx, setTextLeading, gfx_setTextLeading);
+	HOST_SET(gfx, setStencilImage, gfx_setStencilImage);
+	HOST_SET(gfx, getTextTracking, gfx_getTextTracking);
+	HOST_SET(gfx, setPixel, gfx_setPixel);
+	HOST_SET(gfx, getBitmapPixel, gfx_getBitmapPixel);
+	HOST_SET(gfx, drawTextInRect, gfx_drawTextInRect);
+	HOST_SET(gfx, drawRoundRect, gfx_drawRoundRect);
+	HOST_SET(gfx, fillRoundRect, gfx_fillRoundRect);
+
+	host_fill_unimplemented(display, sizeof(*display));
+	HOST_SET(display, getWidth, display_getWidth);
+	HOST_SET(display, getHeight, display_getHeight);
+	HOST_SET(display, setRefreshRate, display_setRefreshRate);
+	HOST_SET(display, setInverted, display_setInverted);
+	HOST_SET(display, setScale, display_setScale);
+	HOST_SET(display, setMosaic, display_ignore);
+	HOST_SET(display, setFlipped, display_ignore);
+	HOST_SET(display, setOffset, display_ignore);
+}
@@ -0,0 +1,60 @@
+#ifndef __HOST_H
+#define __HOST_H
+
+#include "pd_api.h"
+#include "pdhost.h"
+
+#include <stdint.h>
+#include <stdio.h>
+
+// Assigns a host function to an API member. The cast keeps the stand-in
+// compiling against SDK versions whose return types differ slightly.
+#define HOST_SET(api, member, fn) ((api)->member = (__typeof__((api)->member))(fn))
+
+typedef struct
+{
+	const char* sourceDir;    // pdx content, read only
+	const char* dataDir;      // game data folder, read/write
+	const char* inputPath;    // input script
+	const char* dumpDir;      // PBM frame dumps
+	int dumpEvery;
+	int frames;
+	int realtime;             // host clock instead of the virtual one
+	int quiet;                // drop logToConsole output
+} host_options_t;
+
+extern host_options_t host_options;
+
+// Fill every slot of an API table with a trap, before setting the members
+// the stand-in implements.
+void host_fill_unimplemented(void* api, size_t size);
+
+// system.c
+void host_system_init(struct playdate_sys* sys);
+PDCallbackFunction* host_update_callback(void** userdata);
+void host_clock_begin_frame(void);
+void host_clock_end_frame(float refreshRate);
+double host_clock_seconds(void);
+int host_input_load(const char* path);
+int host_input_begin_frame(uint32_t frame);  // 0 when the script asks to quit
+
+// graphics.c
+void host_graphics_init(struct playdate_graphics* gfx, struct playdate_display* display);
+void host_graphics_begin_frame(void);
+void host_graphics_present(void);
+float host_refresh_rate(void);
+void host_graphics_draw_fps(const char* text, int len, int x, int y);
+void host_graphics_shutdown(void);
+
+// file.c
+void host_file_init(struct playdate_file* file);
+FILE* host_open_source(const char* path, const char* suffix);
+
+// sound.c
+void host_sound_init(const struct playdate_sound** sound);
+
+// png.c
+// Decodes a non-interlaced PNG to 8 bits gray + 8 bits alpha per pixel (malloc'ed)
+uint8_t* host_png_decode(const uint8_t* data, size_t size, int* width, int* height);
+
+#endif
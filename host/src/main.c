@@ -0,0 +1,175 @@
+#include "host.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+typedef int (PDEventHandler)(PlaydateAPI* playdate, PDSystemEvent event, uint32_t arg);
+extern PDEventHandler eventHandlerShim;
+
+host_options_t host_options = {
+	.sourceDir = "Source",
+	.dataDir = "Data",
+	.dumpEvery = 1,
+	.frames = 600,
+};
+
+static struct playdate_sys s_system;
+static struct playdate_file s_file;
+static struct playdate_graphics s_graphics;
+static struct playdate_display s_display;
+static struct playdate_sprite s_sprite;
+static struct playdate_lua s_lua;
+static struct playdate_json s_json;
+static struct playdate_scoreboards s_scoreboards;
+static PlaydateAPI s_api;
+static uint32_t s_frame = 0;
+
+static void trap_unimplemented(void)
+{
+	fprintf(stderr, "host: PlaydateAPI function not available in the host build (called from %p)\n", __builtin_return_address(0));
+	abort();
+}
+
+void host_fill_unimplemented(void* api, size_t size)
+{
+	void (**slots)(void) = (void (**)(void))api;
+	for (size_t i = 0; i < size / sizeof(*slots); ++i)
+	{
+		slots[i] = trap_unimplemented;
+	}
+}
+
+uint32_t pdhost_frame(void)
+{
+	return s_frame;
+}
+
+static double host_seconds(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+static void usage(const char* exe)
+{
+	printf("usage: %s [options]\n"
+		"  --frames N        frames to run (default 600, 0 runs until the input script quits)\n"
+		"  --source DIR      pdx content directory (default Source)\n"
+		"  --data DIR        game data directory (default Data)\n"
+		"  --input FILE      input script, one `<frame> <command> [args]` per line:\n"
+		"                      down|up <a b up down left right...>, crank <degrees>,\n"
+		"                      crank_speed <degrees per frame>, dock, undock, quit\n"
+		"  --dump DIR        write displayed frames to DIR/frame_NNNNN.pbm\n"
+		"  --dump-every N    only dump one frame out of N (default 1)\n"
+		"  --realtime        time comes from the host clock instead of advancing\n"
+		"                    one refresh period per frame\n"
+		"  --quiet           don't print logToConsole output\n", exe);
+}
+
+static int parse_options(int argc, char** argv)
+{
+	for (int i = 1; i < argc; ++i)
+	{
+		const char* arg = argv[i];
+		const char* value = i + 1 < argc ? argv[i + 1] : NULL;
+		if (strcmp(arg, "--realtime") == 0) host_options.realtime = 1;
+		else if (strcmp(arg, "--quiet") == 0) host_options.quiet = 1;
+		else if (strcmp(arg, "--help") == 0 || strcmp(arg, "-h") == 0) { usage(argv[0]); exit(0); }
+		else if (value == NULL) { fprintf(stderr, "host: missing value for %s\n", arg); return -1; }
+		else if (strcmp(arg, "--frames") == 0) { host_options.frames = atoi(value); ++i; }
+		else if (strcmp(arg, "--source") == 0) { host_options.sourceDir = value; ++i; }
+		else if (strcmp(arg, "--data") == 0) { host_options.dataDir = value; ++i; }
+		else if (strcmp(arg, "--input") == 0) { host_options.inputPath = value; ++i; }
+		else if (strcmp(arg, "--dump") == 0) { host_options.dumpDir = value; ++i; }
+		else if (strcmp(arg, "--dump-every") == 0) { host_options.dumpEvery = atoi(value) > 0 ? atoi(value) : 1; ++i; }
+		else { fprintf(stderr, "host: unknown option %s\n", arg); return -1; }
+	}
+	return 0;
+}
+
+int main(int argc, char** argv)
+{
+	if (parse_options(argc, argv))
+	{
+		usage(argv[0]);
+		return 2;
+	}
+	if (host_options.inputPath && host_input_load(host_options.inputPath))
+	{
+		fprintf(stderr, "host: can't read the input script %s\n", host_options.inputPath);
+		return 2;
+	}
+
+	host_system_init(&s_system);
+	host_file_init(&s_file);
+	host_graphics_init(&s_graphics, &s_display);
+	s_api.system = &s_system;
+	s_api.file = &s_file;
+	s_api.graphics = &s_graphics;
+	s_api.display = &s_display;
+	host_sound_init(&s_api.sound);
+
+	// Not emulated: any call ends the run with a message
+	host_fill_unimplemented(&s_sprite, sizeof(s_sprite));
+	host_fill_unimplemented(&s_lua, sizeof(s_lua));
+	host_fill_unimplemented(&s_json, sizeof(s_json));
+	host_fill_unimplemented(&s_scoreboards, sizeof(s_scoreboards));
+	s_api.sprite = &s_sprite;
+	s_api.lua = &s_lua;
+	s_api.json = &s_json;
+	s_api.scoreboards = &s_scoreboards;
+
+	eventHandlerShim(&s_api, kEventInit, 0);
+
+	void* userdata = NULL;
+	PDCallbackFunction* update = host_update_callback(&userdata);
+	if (update == NULL)
+	{
+		fprintf(stderr, "host: no update callback set during kEventInit\n");
+		return 1;
+	}
+
+	double updateSeconds = 0.0;
+	double worstSeconds = 0.0;
+	while (host_options.frames == 0 || (int)s_frame < host_options.frames)
+	{
+		if (!host_input_begin_frame(s_frame))
+		{
+			break;
+		}
+		host_clock_begin_frame();
+		host_graphics_begin_frame();
+
+		double start = host_seconds();
+		int changed = update(userdata);
+		double seconds = host_seconds() - start;
+		updateSeconds += seconds;
+		if (seconds > worstSeconds) worstSeconds = seconds;
+
+		if (changed)
+		{
+			host_graphics_present();
+			if (host_options.dumpDir && s_frame % (uint32_t)host_options.dumpEvery == 0)
+			{
+				char path[1024];
+				snprintf(path, sizeof(path), "%s/frame_%05u.pbm", host_options.dumpDir, s_frame);
+				if (pdhost_write_pbm(path))
+				{
+					fprintf(stderr, "host: can't write %s\n", path);
+				}
+			}
+		}
+
+		host_clock_end_frame(host_refresh_rate());
+		++s_frame;
+	}
+
+	eventHandlerShim(&s_api, kEventTerminate, 0);
+	host_graphics_shutdown();
+
+	fprintf(stderr, "host: %u frames, update %.3f ms avg, %.3f ms worst\n", s_frame,
+		s_frame ? updateSeconds * 1000.0 / s_frame : 0.0, worstSeconds * 1000.0);
+	return 0;
+}
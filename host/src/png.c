@@ -0,0 +1,497 @@
+#include "host.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+// Minimal PNG reader for the host build: zlib inflate (stored, fixed and
+// dynamic Huffman blocks), the five row filters, every color type at any
+// bit depth up to 8. No interlacing, no 16-bit channels, no CRC checks.
+
+//------------------------------------------------------------------------------
+// Inflate
+
+typedef struct
+{
+	const uint8_t* data;
+	size_t size;
+	size_t pos;
+	uint32_t bits;
+	int count;
+	int error;
+} bit_reader_t;
+
+typedef struct
+{
+	uint16_t counts[16];
+	uint16_t symbols[288];
+} huffman_t;
+
+typedef struct
+{
+	uint8_t* data;
+	size_t size;
+	size_t capacity;
+} output_t;
+
+static uint32_t read_bits(bit_reader_t* in, int count)
+{
+	while (in->count < count)
+	{
+		if (in->pos >= in->size)
+		{
+			in->error = 1;
+			return 0;
+		}
+		in->bits |= (uint32_t)in->data[in->pos++] << in->count;
+		in->count += 8;
+	}
+	uint32_t value = in->bits & ((1u << count) - 1);
+	in->bits >>= count;
+	in->count -= count;
+	return value;
+}
+
+static int build_huffman(huffman_t* table, const uint8_t* lengths, int count)
+{
+	uint16_t offsets[16];
+	memset(table->counts, 0, sizeof(table->counts));
+	for (int i = 0; i < count; ++i)
+	{
+		++table->counts[lengths[i]];
+	}
+	table->counts[0] = 0;
+
+	offsets[1] = 0;
+	for (int i = 1; i < 15; ++i)
+	{
+		offsets[i + 1] = (uint16_t)(offsets[i] + table->counts[i]);
+	}
+	for (int i = 0; i < count; ++i)
+	{
+		if (lengths[i])
+		{
+			table->symbols[offsets[lengths[i]]++] = (uint16_t)i;
+		}
+	}
+	return 0;
+}
+
+// Canonical decoding, one bit at a time: slow but small
+static int decode_symbol(bit_reader_t* in, const huffman_t* table)
+{
+	int code = 0, first = 0, index = 0;
+	for (int length = 1; length < 16; ++length)
+	{
+		code |= (int)read_bits(in, 1);
+		int count = table->counts[length];
+		if (code - count < first)
+		{
+			return table->symbols[index + (code - first)];
+		}
+		index += count;
+		first += count;
+		first <<= 1;
+		code <<= 1;
+	}
+	in->error = 1;
+	return -1;
+}
+
+static int output_byte(output_t* out, uint8_t byte)
+{
+	if (out->size == out->capacity)
+	{
+		size_t capacity = out->capacity ? out->capacity * 2 : 65536;
+		uint8_t* data = realloc(out->data, capacity);
+		if (data == NULL)
+		{
+			return -1;
+		}
+		out->data = data;
+		out->capacity = capacity;
+	}
+	out->data[out->size++] = byte;
+	return 0;
+}
+
+static const uint16_t kLengthBase[] = { 3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31, 35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258 };
+static const uint8_t kLengthExtra[] = { 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0 };
+static const uint16_t kDistanceBase[] = { 1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193, 257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577 };
+static const uint8_t kDistanceExtra[] = { 0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13 };
+
+static int inflate_block(bit_reader_t* in, output_t* out, const huffman_t* lengths, const huffman_t* distances)
+{
+	for (;;)
+	{
+		int symbol = decode_symbol(in, lengths);
+		if (in->error || symbol < 0)
+		{
+			return -1;
+		}
+		if (symbol < 256)
+		{
+			if (output_byte(out, (uint8_t)symbol)) return -1;
+			continue;
+		}
+		if (symbol == 256)
+		{
+			return 0;
+		}
+
+		symbol -= 257;
+		if (symbol >= 29)
+		{
+			return -1;
+		}
+		size_t length = kLengthBase[symbol] + read_bits(in, kLengthExtra[symbol]);
+		int distanceSymbol = decode_symbol(in, distances);
+		if (distanceSymbol < 0 || distanceSymbol >= 30)
+		{
+			return -1;
+		}
+		size_t distance = kDistanceBase[distanceSymbol] + read_bits(in, kDistanceExtra[distanceSymbol]);
+		if (in->error || distance > out->size)
+		{
+			return -1;
+		}
+		while (length--)
+		{
+			if (output_byte(out, out->data[out->size - distance])) return -1;
+		}
+	}
+}
+
+static int inflate_dynamic(bit_reader_t* in, output_t* out)
+{
+	static const uint8_t kOrder[19] = { 16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15 };
+
+	int literalCount = (int)read_bits(in, 5) + 257;
+	int distanceCount = (int)read_bits(in, 5) + 1;
+	int codeCount = (int)read_bits(in, 4) + 4;
+
+	uint8_t lengths[320] = { 0 };
+	for (int i = 0; i < codeCount; ++i)
+	{
+		lengths[kOrder[i]] = (uint8_t)read_bits(in, 3);
+	}
+	huffman_t codes;
+	build_huffman(&codes, lengths, 19);
+
+	memset(lengths, 0, sizeof(lengths));
+	int index = 0;
+	while (index < literalCount + distanceCount)
+	{
+		int symbol = decode_symbol(in, &codes);
+		if (in->error || symbol < 0)
+		{
+			return -1;
+		}
+		if (symbol < 16)
+		{
+			lengths[index++] = (uint8_t)symbol;
+			continue;
+		}
+
+		uint8_t value = 0;
+		int repeat;
+		if (symbol == 16)
+		{
+			if (index == 0) return -1;
+			value = lengths[index - 1];
+			repeat = 3 + (int)read_bits(in, 2);
+		}
+		else if (symbol == 17)
+		{
+			repeat = 3 + (int)read_bits(in, 3);
+		}
+		else
+		{
+			repeat = 11 + (int)read_bits(in, 7);
+		}
+		if (index + repeat > literalCount + distanceCount)
+		{
+			return -1;
+		}
+		while (repeat--)
+		{
+			lengths[index++] = value;
+		}
+	}
+
+	huffman_t literals, distances;
+	build_huffman(&literals, lengths, literalCount);
+	build_huffman(&distances, lengths + literalCount, distanceCount);
+	return inflate_block(in, out, &literals, &distances);
+}
+
+static int inflate_fixed(bit_reader_t* in, output_t* out)
+{
+	static huffman_t literals, distances;
+	static int built = 0;
+	if (!built)
+	{
+		uint8_t lengths[288];
+		for (int i = 0; i < 144; ++i) lengths[i] = 8;
+		for (int i = 144; i < 256; ++i) lengths[i] = 9;
+		for (int i = 256; i < 280; ++i) lengths[i] = 7;
+		for (int i = 280; i < 288; ++i) lengths[i] = 8;
+		build_huffman(&literals, lengths, 288);
+		for (int i = 0; i < 30; ++i) lengths[i] = 5;
+		build_huffman(&distances, lengths, 30);
+		built = 1;
+	}
+	return inflate_block(in, out, &literals, &distances);
+}
+
+static int inflate_stored(bit_reader_t* in, output_t* out)
+{
+	// Stored blocks start on a byte boundary
+	in->bits = 0;
+	in->count = 0;
+	if (in->pos + 4 > in->size)
+	{
+		return -1;
+	}
+	uint16_t length = (uint16_t)(in->data[in->pos] | (in->data[in->pos + 1] << 8));
+	in->pos += 4;
+	if (in->pos + length > in->size)
+	{
+		return -1;
+	}
+	for (uint16_t i = 0; i < length; ++i)
+	{
+		if (output_byte(out, in->data[in->pos++])) return -1;
+	}
+	return 0;
+}
+
+// zlib stream (2 bytes header, deflate data, adler32 ignored)
+static uint8_t* zlib_inflate(const uint8_t* data, size_t size, size_t* outSize)
+{
+	if (size < 2 || (data[0] & 0x0f) != 8 || (data[1] & 0x20))
+	{
+		return NULL;
+	}
+
+	bit_reader_t in = { data, size, 2, 0, 0, 0 };
+	output_t out = { NULL, 0, 0 };
+	int last = 0;
+	while (!last)
+	{
+		last = (int)read_bits(&in, 1);
+		int type = (int)read_bits(&in, 2);
+		int result = -1;
+		switch (type)
+		{
+		case 0: result = inflate_stored(&in, &out); break;
+		case 1: result = inflate_fixed(&in, &out); break;
+		case 2: result = inflate_dynamic(&in, &out); break;
+		default: break;
+		}
+		if (result || in.error)
+		{
+			free(out.data);
+			return NULL;
+		}
+	}
+	*outSize = out.size;
+	return out.data;
+}
+
+//------------------------------------------------------------------------------
+// PNG
+
+static uint32_t read_u32(const uint8_t* data)
+{
+	return ((uint32_t)data[0] << 24) | ((uint32_t)data[1] << 16) | ((uint32_t)data[2] << 8) | data[3];
+}
+
+static uint8_t paeth(uint8_t a, uint8_t b, uint8_t c)
+{
+	int p = (int)a + (int)b - (int)c;
+	int pa = abs(p - (int)a), pb = abs(p - (int)b), pc = abs(p - (int)c);
+	if (pa <= pb && pa <= pc) return a;
+	return pb <= pc ? b : c;
+}
+
+static int unfilter(uint8_t* data, size_t size, int height, size_t stride, int bytesPerPixel)
+{
+	if (size < (stride + 1) * (size_t)height)
+	{
+		return -1;
+	}
+
+	uint8_t* previous = NULL;
+	for (int y = 0; y < height; ++y)
+	{
+		uint8_t filter = data[y * (stride + 1)];
+		uint8_t* row = &data[y * (stride + 1) + 1];
+		for (size_t x = 0; x < stride; ++x)
+		{
+			uint8_t a = x >= (size_t)bytesPerPixel ? row[x - bytesPerPixel] : 0;
+			uint8_t b = previous ? previous[x] : 0;
+			uint8_t c = previous && x >= (size_t)bytesPerPixel ? previous[x - bytesPerPixel] : 0;
+			switch (filter)
+			{
+			case 0: break;
+			case 1: row[x] = (uint8_t)(row[x] + a); break;
+			case 2: row[x] = (uint8_t)(row[x] + b); break;
+			case 3: row[x] = (uint8_t)(row[x] + ((a + b) >> 1)); break;
+			case 4: row[x] = (uint8_t)(row[x] + paeth(a, b, c)); break;
+			default: return -1;
+			}
+		}
+		previous = row;
+	}
+	return 0;
+}
+
+static uint8_t sample(const uint8_t* row, int x, int depth)
+{
+	if (depth == 8)
+	{
+		return row[x];
+	}
+	int perByte = 8 / depth;
+	int shift = 8 - depth * (x % perByte + 1);
+	return (uint8_t)((row[x / perByte] >> shift) & ((1 << depth) - 1));
+}
+
+static uint8_t luminance(uint8_t r, uint8_t g, uint8_t b)
+{
+	return (uint8_t)((r * 299 + g * 587 + b * 114) / 1000);
+}
+
+uint8_t* host_png_decode(const uint8_t* data, size_t size, int* width, int* height)
+{
+	static const uint8_t kSignature[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1a, '\n' };
+	if (size < 8 || memcmp(data, kSignature, 8) != 0)
+	{
+		return NULL;
+	}
+
+	int w = 0, h = 0, depth = 0, colorType = 0, interlace = 0;
+	uint8_t palette[256][4];
+	int paletteSize = 0;
+	int transparentGray = -1;
+	memset(palette, 255, sizeof(palette));
+
+	// Concatenate the IDAT chunks
+	uint8_t* compressed = NULL;
+	size_t compressedSize = 0;
+	size_t pos = 8;
+	while (pos + 8 <= size)
+	{
+		uint32_t length = read_u32(&data[pos]);
+		const uint8_t* type = &data[pos + 4];
+		const uint8_t* chunk = &data[pos + 8];
+		if (pos + 12 + (size_t)length > size)
+		{
+			break;
+		}
+
+		if (memcmp(type, "IHDR", 4) == 0 && length >= 13)
+		{
+			w = (int)read_u32(chunk);
+			h = (int)read_u32(chunk + 4);
+			depth = chunk[8];
+			colorType = chunk[9];
+			interlace = chunk[12];
+		}
+		else if (memcmp(type, "PLTE", 4) == 0)
+		{
+			paletteSize = (int)(length / 3);
+			for (int i = 0; i < paletteSize && i < 256; ++i)
+			{
+				palette[i][0] = chunk[i * 3];
+				palette[i][1] = chunk[i * 3 + 1];
+				palette[i][2] = chunk[i * 3 + 2];
+			}
+		}
+		else if (memcmp(type, "tRNS", 4) == 0)
+		{
+			if (colorType == 3)
+			{
+				for (uint32_t i = 0; i < length && i < 256; ++i) palette[i][3] = chunk[i];
+			}
+			else if (colorType == 0 && length >= 2)
+			{
+				transparentGray = (chunk[0] << 8) | chunk[1];
+			}
+		}
+		else if (memcmp(type, "IDAT", 4) == 0)
+		{
+			uint8_t* grown = realloc(compressed, compressedSize + length);
+			if (grown == NULL)
+			{
+				free(compressed);
+				return NULL;
+			}
+			compressed = grown;
+			memcpy(compressed + compressedSize, chunk, length);
+			compressedSize += length;
+		}
+		else if (memcmp(type, "IEND", 4) == 0)
+		{
+			break;
+		}
+		pos += 12 + (size_t)length;
+	}
+
+	static const int kChannels[7] = { 1, 0, 3, 1, 2, 0, 4 };
+	if (compressed == NULL || w <= 0 || h <= 0 || interlace || depth > 8 || colorType > 6 || kChannels[colorType] == 0)
+	{
+		free(compressed);
+		return NULL;
+	}
+
+	size_t rawSize = 0;
+	uint8_t* raw = zlib_inflate(compressed, compressedSize, &rawSize);
+	free(compressed);
+
+	int channels = kChannels[colorType];
+	size_t stride = ((size_t)w * (size_t)channels * (size_t)depth + 7) / 8;
+	int bytesPerPixel = (channels * depth + 7) / 8;
+	uint8_t* pixels = raw && unfilter(raw, rawSize, h, stride, bytesPerPixel) == 0 ? malloc((size_t)w * (size_t)h * 2) : NULL;
+	if (pixels == NULL)
+	{
+		free(raw);
+		return NULL;
+	}
+
+	// Sub-byte gray is scaled to the full 0..255 range
+	int scale = 255 / ((1 << depth) - 1);
+	for (int y = 0; y < h; ++y)
+	{
+		const uint8_t* row = &raw[(size_t)y * (stride + 1) + 1];
+		for (int x = 0; x < w; ++x)
+		{
+			uint8_t* out = &pixels[((size_t)y * (size_t)w + (size_t)x) * 2];
+			switch (colorType)
+			{
+			case 0:
+			{
+				uint8_t value = sample(row, x, depth);
+				out[0] = (uint8_t)(value * scale);
+				out[1] = value == transparentGray ? 0 : 255;
+				break;
+			}
+			case 2: out[0] = luminance(row[x * 3], row[x * 3 + 1], row[x * 3 + 2]); out[1] = 255; break;
+			case 3:
+			{
+				const uint8_t* color = palette[sample(row, x, depth)];
+				out[0] = luminance(color[0], color[1], color[2]);
+				out[1] = color[3];
+				break;
+			}
+			case 4: out[0] = row[x * 2]; out[1] = row[x * 2 + 1]; break;
+			case 6: out[0] = luminance(row[x * 4], row[x * 4 + 1], row[x * 4 + 2]); out[1] = row[x * 4 + 3]; break;
+			}
+		}
+	}
+	free(raw);
+
+	*width = w;
+	*height = h;
+	return pixels;
+}
@@ -0,0 +1,142 @@
+#include "host.h"
+
+#include <stdlib.h>
+
+// Silent sound API: every call succeeds and does nothing. Constructors hand out
+// distinct dummy objects so the game's bookkeeping (NULL checks, maps keyed by
+// pointer) keeps working; they are never freed, the run is short lived.
+
+static struct playdate_sound s_sound;
+static struct playdate_sound_channel s_channel;
+static struct playdate_sound_fileplayer s_fileplayer;
+static struct playdate_sound_sample s_sample;
+static struct playdate_sound_sampleplayer s_sampleplayer;
+static struct playdate_sound_synth s_synth;
+static struct playdate_sound_sequence s_sequence;
+static struct playdate_sound_effect s_effect;
+static struct playdate_sound_effect_twopolefilter s_twopolefilter;
+static struct playdate_sound_effect_onepolefilter s_onepolefilter;
+static struct playdate_sound_effect_bitcrusher s_bitcrusher;
+static struct playdate_sound_effect_ringmodulator s_ringmodulator;
+static struct playdate_sound_effect_delayline s_delayline;
+static struct playdate_sound_effect_overdrive s_overdrive;
+static struct playdate_sound_lfo s_lfo;
+static struct playdate_sound_envelope s_envelope;
+static struct playdate_sound_source s_source;
+static struct playdate_control_signal s_controlsignal;
+static struct playdate_sound_track s_track;
+static struct playdate_sound_instrument s_instrument;
+static struct playdate_sound_signal s_signal;
+
+static SoundChannel* s_defaultChannel;
+
+static uintptr_t sound_ignore(void)
+{
+	return 0;
+}
+
+static void* sound_new(void)
+{
+	// Big enough for games peeking at the first fields, which they shouldn't
+	return calloc(1, 64);
+}
+
+static uint32_t sound_getCurrentTime(void)
+{
+	return (uint32_t)(host_clock_seconds() * 44100.0);
+}
+
+static SoundChannel* sound_getDefaultChannel(void)
+{
+	return s_defaultChannel;
+}
+
+static void fill(void* api, size_t size)
+{
+	void (**slots)(void) = (void (**)(void))api;
+	for (size_t i = 0; i < size / sizeof(*slots); ++i)
+	{
+		slots[i] = (void (*)(void))sound_ignore;
+	}
+}
+
+void host_sound_init(const struct playdate_sound** sound)
+{
+	fill(&s_sound, sizeof(s_sound));
+	fill(&s_channel, sizeof(s_channel));
+	fill(&s_fileplayer, sizeof(s_fileplayer));
+	fill(&s_sample, sizeof(s_sample));
+	fill(&s_sampleplayer, sizeof(s_sampleplayer));
+	fill(&s_synth, sizeof(s_synth));
+	fill(&s_sequence, sizeof(s_sequence));
+	fill(&s_effect, sizeof(s_effect));
+	fill(&s_twopolefilter, sizeof(s_twopolefilter));
+	fill(&s_onepolefilter, sizeof(s_onepolefilter));
+	fill(&s_bitcrusher, sizeof(s_bitcrusher));
+	fill(&s_ringmodulator, sizeof(s_ringmodulator));
+	fill(&s_delayline, sizeof(s_delayline));
+	fill(&s_overdrive, sizeof(s_overdrive));
+	fill(&s_lfo, sizeof(s_lfo));
+	fill(&s_envelope, sizeof(s_envelope));
+	fill(&s_source, sizeof(s_source));
+	fill(&s_controlsignal, sizeof(s_controlsignal));
+	fill(&s_track, sizeof(s_track));
+	fill(&s_instrument, sizeof(s_instrument));
+	fill(&s_signal, sizeof(s_signal));
+
+	// Tables pointing to tables: set after the fill, which overwrote them
+	s_sound.channel = &s_channel;
+	s_sound.fileplayer = &s_fileplayer;
+	s_sound.sample = &s_sample;
+	s_sound.sampleplayer = &s_sampleplayer;
+	s_sound.synth = &s_synth;
+	s_sound.sequence = &s_sequence;
+	s_sound.effect = &s_effect;
+	s_sound.lfo = &s_lfo;
+	s_sound.envelope = &s_envelope;
+	s_sound.source = &s_source;
+	s_sound.controlsignal = &s_controlsignal;
+	s_sound.track = &s_track;
+	s_sound.instrument = &s_instrument;
+	s_sound.signal = &s_signal;
+	s_effect.twopolefilter = &s_twopolefilter;
+	s_effect.onepolefilter = &s_onepolefilter;
+	s_effect.bitcrusher = &s_bitcrusher;
+	s_effect.ringmodulator = &s_ringmodulator;
+	s_effect.delayline = &s_delayline;
+	s_effect.overdrive = &s_overdrive;
+
+	// Everything returning an object the game holds on to
+	s_defaultChannel = sound_new();
+	HOST_SET(&s_sound, getCurrentTime, sound_getCurrentTime);
+	HOST_SET(&s_sound, getDefaultChannel, sound_getDefaultChannel);
+	HOST_SET(&s_sound, addSource, sound_new);
+	HOST_SET(&s_channel, newChannel, sound_new);
+	HOST_SET(&s_fileplayer, newPlayer, sound_new);
+	HOST_SET(&s_sample, newSampleBuffer, sound_new);
+	HOST_SET(&s_sample, load, sound_new);
+	HOST_SET(&s_sample, newSampleFromData, sound_new);
+	HOST_SET(&s_sampleplayer, newPlayer, sound_new);
+	HOST_SET(&s_synth, newSynth, sound_new);
+	HOST_SET(&s_synth, copy, sound_new);
+	HOST_SET(&s_synth, getEnvelope, sound_new);
+	HOST_SET(&s_sequence, newSequence, sound_new);
+	HOST_SET(&s_sequence, addTrack, sound_new);
+	HOST_SET(&s_effect, newEffect, sound_new);
+	HOST_SET(&s_twopolefilter, newFilter, sound_new);
+	HOST_SET(&s_onepolefilter, newFilter, sound_new);
+	HOST_SET(&s_bitcrusher, newBitCrusher, sound_new);
+	HOST_SET(&s_ringmodulator, newRingmod, sound_new);
+	HOST_SET(&s_delayline, newDelayLine, sound_new);
+	HOST_SET(&s_delayline, addTap, sound_new);
+	HOST_SET(&s_overdrive, newOverdrive, sound_new);
+	HOST_SET(&s_lfo, newLFO, sound_new);
+	HOST_SET(&s_envelope, newEnvelope, sound_new);
+	HOST_SET(&s_controlsignal, newSignal, sound_new);
+	HOST_SET(&s_track, newTrack, sound_new);
+	HOST_SET(&s_track, getSignalForController, sound_new);
+	HOST_SET(&s_instrument, newInstrument, sound_new);
+	HOST_SET(&s_signal, newSignal, sound_new);
+
+	*sound = &s_sound;
+}
@@ -0,0 +1,385 @@
+#include "host.h"
+
+#include <math.h>
+#include <stdarg.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <time.h>
+
+//------------------------------------------------------------------------------
+// Clock
+// Virtual by default: every frame advances by one refresh period, so runs are
+// deterministic whatever the host speed. --realtime uses the host clock.
+
+static double s_now = 0.0;          // seconds since launch
+static double s_elapsedStart = 0.0;
+static double s_realStart = -1.0;
+static double s_lastFrameTime = 0.0;
+static float s_fps = 0.0f;
+
+static double real_seconds(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	double now = (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+	if (s_realStart < 0.0) s_realStart = now;
+	return now - s_realStart;
+}
+
+static double now_seconds(void)
+{
+	return host_options.realtime ? real_seconds() : s_now;
+}
+
+double host_clock_seconds(void)
+{
+	return now_seconds();
+}
+
+void host_clock_begin_frame(void)
+{
+	double now = now_seconds();
+	if (now > s_lastFrameTime)
+	{
+		s_fps = (float)(1.0 / (now - s_lastFrameTime));
+	}
+	s_lastFrameTime = now;
+}
+
+void host_clock_end_frame(float refreshRate)
+{
+	// Refresh rate 0 means "as fast as possible": count it as the 50 Hz of the LCD
+	s_now += 1.0 / (refreshRate > 0.0f ? (double)refreshRate : 50.0);
+}
+
+static unsigned int sys_getCurrentTimeMilliseconds(void)
+{
+	// Rounded: the sum of 20 ms frames lands just below a millisecond at times
+	return (unsigned int)llround(now_seconds() * 1000.0);
+}
+
+static unsigned int sys_getSecondsSinceEpoch(unsigned int* milliseconds)
+{
+	// Fixed start date so virtual runs are reproducible: 2024-01-01 00:00 in the
+	// Playdate epoch (seconds since 2000-01-01)
+	double seconds = 757382400.0 + now_seconds();
+	if (milliseconds)
+	{
+		*milliseconds = (unsigned int)(fmod(seconds, 1.0) * 1000.0);
+	}
+	return (unsigned int)seconds;
+}
+
+static float sys_getElapsedTime(void)
+{
+	return (float)(now_seconds() - s_elapsedStart);
+}
+
+static void sys_resetElapsedTime(void)
+{
+	s_elapsedStart = now_seconds();
+}
+
+//------------------------------------------------------------------------------
+// Scripted input
+
+typedef enum
+{
+	INPUT_DOWN,
+	INPUT_UP,
+	INPUT_CRANK,
+	INPUT_CRANK_SPEED,
+	INPUT_DOCK,
+	INPUT_UNDOCK,
+	INPUT_QUIT
+} input_command_t;
+
+typedef struct
+{
+	uint32_t frame;
+	input_command_t command;
+	PDButtons buttons;
+	float value;
+} input_event_t;
+
+static input_event_t* s_events = NULL;
+static int s_eventCount = 0;
+static int s_nextEvent = 0;
+
+static PDButtons s_current = 0;
+static PDButtons s_previous = 0;
+static float s_crankAngle = 0.0f;
+static float s_crankChange = 0.0f;
+static float s_crankSpeed = 0.0f;
+static float s_crankReported = 0.0f;
+static int s_crankDocked = 1;
+
+static PDButtons parse_button(const char* name)
+{
+	static const struct { const char* name; PDButtons button; } names[] = {
+		{ "left", kButtonLeft }, { "right", kButtonRight }, { "up", kButtonUp },
+		{ "down", kButtonDown }, { "b", kButtonB }, { "a", kButtonA },
+	};
+	for (size_t i = 0; i < sizeof(names) / sizeof(names[0]); ++i)
+	{
+		if (strcasecmp(name, names[i].name) == 0) return names[i].button;
+	}
+	return 0;
+}
+
+int host_input_load(const char* path)
+{
+	FILE* file = fopen(path, "r");
+	if (file == NULL)
+	{
+		return -1;
+	}
+
+	char line[256];
+	int lineNumber = 0;
+	while (fgets(line, sizeof(line), file))
+	{
+		++lineNumber;
+		char* comment = strchr(line, '#');
+		if (comment) *comment = 0;
+
+		char* token = strtok(line, " \t\r\n");
+		if (token == NULL)
+		{
+			continue;
+		}
+
+		input_event_t event = { (uint32_t)strtoul(token, NULL, 10), INPUT_QUIT, 0, 0.0f };
+		const char* command = strtok(NULL, " \t\r\n");
+		if (command == NULL)
+		{
+			fprintf(stderr, "host: %s:%d: missing command\n", path, lineNumber);
+			continue;
+		}
+
+		if (strcmp(command, "down") == 0 || strcmp(command, "up") == 0)
+		{
+			event.command = command[0] == 'd' ? INPUT_DOWN : INPUT_UP;
+			while ((token = strtok(NULL, " \t\r\n")))
+			{
+				PDButtons button = parse_button(token);
+				if (button == 0) fprintf(stderr, "host: %s:%d: unknown button %s\n", path, lineNumber, token);
+				event.buttons |= button;
+			}
+		}
+		else if (strcmp(command, "crank") == 0 || strcmp(command, "crank_speed") == 0)
+		{
+			event.command = command[5] ? INPUT_CRANK_SPEED : INPUT_CRANK;
+			token = strtok(NULL, " \t\r\n");
+			event.value = token ? strtof(token, NULL) : 0.0f;
+		}
+		else if (strcmp(command, "dock") == 0) event.command = INPUT_DOCK;
+		else if (strcmp(command, "undock") == 0) event.command = INPUT_UNDOCK;
+		else if (strcmp(command, "quit") == 0) event.command = INPUT_QUIT;
+		else
+		{
+			fprintf(stderr, "host: %s:%d: unknown command %s\n", path, lineNumber, command);
+			continue;
+		}
+
+		input_event_t* events = realloc(s_events, sizeof(*events) * (size_t)(s_eventCount + 1));
+		if (events == NULL)
+		{
+			fclose(file);
+			return -1;
+		}
+		s_events = events;
+		s_events[s_eventCount++] = event;
+	}
+	fclose(file);
+	return 0;
+}
+
+static float wrap_angle(float angle)
+{
+	angle = fmodf(angle, 360.0f);
+	return angle < 0.0f ? angle + 360.0f : angle;
+}
+
+int host_input_begin_frame(uint32_t frame)
+{
+	s_previous = s_current;
+	float previousAngle = s_crankAngle;
+
+	// Events are applied in file order, frames are expected to be increasing
+	int quit = 0;
+	while (s_nextEvent < s_eventCount && s_events[s_nextEvent].frame <= frame)
+	{
+		const input_event_t* event = &s_events[s_nextEvent++];
+		switch (event->command)
+		{
+		case INPUT_DOWN: s_current |= event->buttons; break;
+		case INPUT_UP: s_current &= ~event->buttons; break;
+		case INPUT_CRANK: s_crankAngle = wrap_angle(event->value); s_crankDocked = 0; break;
+		case INPUT_CRANK_SPEED: s_crankSpeed = event->value; s_crankDocked = 0; break;
+		case INPUT_DOCK: s_crankDocked = 1; s_crankSpeed = 0.0f; break;
+		case INPUT_UNDOCK: s_crankDocked = 0; break;
+		case INPUT_QUIT: quit = 1; break;
+		}
+	}
+
+	if (!s_crankDocked)
+	{
+		s_crankAngle = wrap_angle(s_crankAngle + s_crankSpeed);
+	}
+	float change = s_crankAngle - previousAngle;
+	if (change > 180.0f) change -= 360.0f;
+	if (change < -180.0f) change += 360.0f;
+	s_crankChange += change;
+	return !quit;
+}
+
+static void sys_getButtonState(PDButtons* current, PDButtons* pushed, PDButtons* released)
+{
+	if (current) *current = s_current;
+	if (pushed) *pushed = s_current & ~s_previous;
+	if (released) *released = s_previous & ~s_current;
+}
+
+static float sys_getCrankAngle(void)
+{
+	return s_crankAngle;
+}
+
+static float sys_getCrankChange(void)
+{
+	// Change since the last call, like on device
+	float change = s_crankChange - s_crankReported;
+	s_crankReported = s_crankChange;
+	return change;
+}
+
+static int sys_isCrankDocked(void)
+{
+	return s_crankDocked;
+}
+
+static void sys_getAccelerometer(float* x, float* y, float* z)
+{
+	// Lying flat on a table
+	if (x) *x = 0.0f;
+	if (y) *y = 0.0f;
+	if (z) *z = 1.0f;
+}
+
+//------------------------------------------------------------------------------
+// Console, memory, callbacks
+
+static PDCallbackFunction* s_update = NULL;
+static void* s_updateUserdata = NULL;
+
+static void sys_logToConsole(const char* fmt, ...)
+{
+	if (host_options.quiet)
+	{
+		return;
+	}
+	va_list args;
+	va_start(args, fmt);
+	vprintf(fmt, args);
+	va_end(args);
+	putchar('\n');
+}
+
+static void sys_error(const char* fmt, ...)
+{
+	// The device stops the game on error, so does the host run
+	va_list args;
+	va_start(args, fmt);
+	fputs("error: ", stderr);
+	vfprintf(stderr, fmt, args);
+	va_end(args);
+	fputc('\n', stderr);
+	fflush(stdout);
+	exit(1);
+}
+
+static int sys_formatString(char** ret, const char* fmt, ...)
+{
+	va_list args;
+	va_start(args, fmt);
+	int len = vsnprintf(NULL, 0, fmt, args);
+	va_end(args);
+
+	*ret = malloc((size_t)len + 1);
+	if (*ret == NULL)
+	{
+		return -1;
+	}
+	va_start(args, fmt);
+	vsnprintf(*ret, (size_t)len + 1, fmt, args);
+	va_end(args);
+	return len;
+}
+
+static void* sys_realloc(void* ptr, size_t size)
+{
+	if (size == 0)
+	{
+		free(ptr);
+		return NULL;
+	}
+	return realloc(ptr, size);
+}
+
+static void sys_setUpdateCallback(PDCallbackFunction* update, void* userdata)
+{
+	s_update = update;
+	s_updateUserdata = userdata;
+}
+
+PDCallbackFunction* host_update_callback(void** userdata)
+{
+	*userdata = s_updateUserdata;
+	return s_update;
+}
+
+static void sys_drawFPS(int x, int y)
+{
+	char text[8];
+	int len = snprintf(text, sizeof(text), "%d", (int)(s_fps + 0.5f));
+	host_graphics_draw_fps(text, len, x, y);
+}
+
+static int sys_returnZero(void) { return 0; }
+static int sys_returnOne(void) { return 1; }
+static void sys_ignore(void) {}
+static float sys_getBatteryPercentage(void) { return 100.0f; }
+static float sys_getBatteryVoltage(void) { return 4.2f; }
+
+void host_system_init(struct playdate_sys* sys)
+{
+	host_fill_unimplemented(sys, sizeof(*sys));
+
+	HOST_SET(sys, realloc, sys_realloc);
+	HOST_SET(sys, formatString, sys_formatString);
+	HOST_SET(sys, logToConsole, sys_logToConsole);
+	HOST_SET(sys, error, sys_error);
+	HOST_SET(sys, getLanguage, sys_returnZero);
+	HOST_SET(sys, getCurrentTimeMilliseconds, sys_getCurrentTimeMilliseconds);
+	HOST_SET(sys, getSecondsSinceEpoch, sys_getSecondsSinceEpoch);
+	HOST_SET(sys, drawFPS, sys_drawFPS);
+	HOST_SET(sys, setUpdateCallback, sys_setUpdateCallback);
+	HOST_SET(sys, getButtonState, sys_getButtonState);
+	HOST_SET(sys, setPeripheralsEnabled, sys_ignore);
+	HOST_SET(sys, getAccelerometer, sys_getAccelerometer);
+	HOST_SET(sys, getCrankChange, sys_getCrankChange);
+	HOST_SET(sys, getCrankAngle, sys_getCrankAngle);
+	HOST_SET(sys, isCrankDocked, sys_isCrankDocked);
+	HOST_SET(sys, setCrankSoundsDisabled, sys_returnZero);
+	HOST_SET(sys, getFlipped, sys_returnZero);
+	HOST_SET(sys, setAutoLockDisabled, sys_ignore);
+	HOST_SET(sys, getReduceFlashing, sys_returnZero);
+	HOST_SET(sys, getElapsedTime, sys_getElapsedTime);
+	HOST_SET(sys, resetElapsedTime, sys_resetElapsedTime);
+	HOST_SET(sys, getBatteryPercentage, sys_getBatteryPercentage);
+	HOST_SET(sys, getBatteryVoltage, sys_getBatteryVoltage);
+	HOST_SET(sys, getTimezoneOffset, sys_returnZero);
+	HOST_SET(sys, shouldDisplay24HourTime, sys_returnOne);
+}
@@ -0,0 +1,53 @@
+#ifndef __PDALLOC_H
+#define __PDALLOC_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Signature of the Playdate system allocator: realloc(NULL, n) allocates,
+// realloc(p, 0) frees.
+typedef void* (*pdcpp_realloc_t)(void* ptr, size_t size);
+
+// Allocator hook (src/setup.c)
+// Every malloc/realloc/free (and so every new/delete) goes through the active
+// allocator. It is the system allocator until someone installs another one.
+// Returns the previously installed allocator. Passing NULL restores the system one.
+pdcpp_realloc_t pdcpp_set_allocator(pdcpp_realloc_t allocator);
+// The Playdate system allocator (valid once kEventInit has been received)
+pdcpp_realloc_t pdcpp_system_allocator(void);
+
+// Segregated size-class pool allocator (src/pdalloc.c)
+// Small blocks (<= PDCPP_POOL_MAX_BLOCK) are served in O(1) from fixed size
+// classes carved out of 4 KB pages of one contiguous region. Empty pages go back
+// to the region so they can be reused by any class, which bounds fragmentation.
+// Large blocks, and small ones once the region is exhausted, use the system allocator.
+#define PDCPP_POOL_PAGE_SIZE 4096
+#define PDCPP_POOL_MAX_BLOCK 1024
+
+typedef struct
+{
+	uint32_t pagesTotal;      // pages in the region
+	uint32_t pagesUsed;       // pages currently assigned to a size class
+	uint32_t blocksLive;      // live pool blocks
+	uint32_t fallbackAllocs;  // small allocations that went to the system allocator
+} pdcpp_pool_stats_t;
+
+// Reserve a region of `poolBytes` from the system allocator and install the pool
+// as the active allocator. Blocks allocated before are still freed correctly.
+// Returns 0 on success, -1 if the region could not be allocated.
+int pdcpp_pool_install(size_t poolBytes);
+// realloc-style entry point, usable directly with pdcpp_set_allocator()
+void* pdcpp_pool_realloc(void* ptr, size_t size);
+// Non-zero if `ptr` lives in the pool region
+int pdcpp_pool_owns(const void* ptr);
+void pdcpp_pool_get_stats(pdcpp_pool_stats_t* stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,152 @@
+#ifndef __PDAPI_H
+#define __PDAPI_H
+
+// Cached PlaydateAPI dispatch and owning handles (header only, C++)
+// `_G.pd->graphics->drawLine(...)` is three dependent loads before the call,
+// redone after every call since the tables could have changed behind the
+// compiler's back. pdcpp::Api holds copies of the function tables, filled once
+// by pdcpp::InitializeApi() at kEventInit (playdate_cpp_app.hcpp does it):
+//   pdcpp::Api.graphics.drawLine(x0, y0, x1, y1, 1, kColorBlack);
+// is one load from a fixed address. A loop can also keep the function pointer
+// in a local, it stays valid for the whole run.
+
+#include "pd_api.h"
+#include "pdcpp/pdprofile.h"
+
+namespace pdcpp
+{
+    struct CachedApi
+    {
+        PlaydateAPI* pd = nullptr;
+        playdate_sys system{};
+        playdate_file file{};
+        playdate_graphics graphics{};
+        playdate_display display{};
+        playdate_sound sound{};
+        playdate_sound_channel channel{};
+        playdate_sound_synth synth{};
+        playdate_sound_lfo lfo{};
+        playdate_sound_signal signal{};
+        playdate_sound_effect effect{};
+        playdate_sound_effect_twopolefilter twopolefilter{};
+        playdate_sound_effect_overdrive overdrive{};
+    };
+
+    inline CachedApi Api;
+
+    inline void InitializeApi(PlaydateAPI* pd)
+    {
+        Api.pd = pd;
+        Api.system = *pd->system;
+        Api.file = *pd->file;
+        Api.graphics = *pd->graphics;
+        Api.display = *pd->display;
+        Api.sound = *pd->sound;
+        Api.channel = *pd->sound->channel;
+        Api.synth = *pd->sound->synth;
+        Api.lfo = *pd->sound->lfo;
+        Api.signal = *pd->sound->signal;
+        Api.effect = *pd->sound->effect;
+        Api.twopolefilter = *pd->sound->effect->twopolefilter;
+        Api.overdrive = *pd->sound->effect->overdrive;
+    }
+
+    // Owns an SDK object and frees it with Free when reset or destroyed.
+    // Converts to the raw pointer, so it can be passed to the C API as is.
+    template <typename T, typename Free>
+    class Handle
+    {
+    public:
+        Handle() = default;
+        explicit Handle(T* object) : Object(object) {}
+        Handle(Handle&& other) noexcept : Object(other.Release()) {}
+        ~Handle() { Reset(); }
+
+        Handle& operator=(Handle&& other) noexcept
+        {
+            if (this != &other)
+            {
+                Reset(other.Release());
+            }
+            return *this;
+        }
+
+        Handle(const Handle&) = delete;
+        Handle& operator=(const Handle&) = delete;
+
+        T* Get() const { return Object; }
+        operator T*() const { return Object; }
+
+        T* Release()
+        {
+            T* object = Object;
+            Object = nullptr;
+            return object;
+        }
+
+        void Reset(T* object = nullptr)
+        {
+            if (Object)
+            {
+                Free{}(Object);
+            }
+            Object = object;
+        }
+
+    private:
+        T* Object = nullptr;
+    };
+
+    struct FreeBitmap { void operator()(LCDBitmap* bitmap) const { Api.graphics.freeBitmap(bitmap); } };
+    struct CloseFile { void operator()(SDFile* file) const { Api.file.close(file); } };
+    struct FreeSynth { void operator()(PDSynth* synth) const { Api.synth.freeSynth(synth); } };
+    struct FreeLFO { void operator()(PDSynthLFO* lfo) const { Api.lfo.freeLFO(lfo); } };
+    struct FreeTwoPoleFilter { void operator()(TwoPoleFilter* filter) const { Api.twopolefilter.freeFilter(filter); } };
+    struct FreeOverdrive { void operator()(Overdrive* overdrive) const { Api.overdrive.freeOverdrive(overdrive); } };
+
+    // Channels are taken out of the mixer before being freed. Remove the
+    // sources and effects of a channel (channel.removeSource/removeEffect)
+    // before resetting it, and free them after it.
+    struct FreeChannel
+    {
+        void operator()(SoundChannel* channel) const
+        {
+            Api.sound.removeChannel(channel);
+            Api.channel.freeChannel(channel);
+        }
+    };
+
+    using Bitmap = Handle<LCDBitmap, FreeBitmap>;
+    using File = Handle<SDFile, CloseFile>;
+    using Synth = Handle<PDSynth, FreeSynth>;
+    using LFO = Handle<PDSynthLFO, FreeLFO>;
+    using Filter = Handle<TwoPoleFilter, FreeTwoPoleFilter>;
+    using OverdriveEffect = Handle<Overdrive, FreeOverdrive>;
+    using Channel = Handle<SoundChannel, FreeChannel>;
+
+    inline Bitmap LoadBitmap(const char* path, const char** outErr = nullptr)
+    {
+        PDCPP_PROFILE_SCOPE_TEXT("load bitmap", path);
+        const char* err = nullptr;
+        return Bitmap(Api.graphics.loadBitmap(path, outErr ? outErr : &err));
+    }
+
+    inline File OpenFile(const char* path, FileOptions mode) { return File(Api.file.open(path, mode)); }
+    inline Synth NewSynth() { return Synth(Api.synth.newSynth()); }
+    inline LFO NewLFO(LFOType type) { return LFO(Api.lfo.newLFO(type)); }
+    inline Filter NewTwoPoleFilter() { return Filter(Api.twopolefilter.newFilter()); }
+    inline OverdriveEffect NewOverdrive() { return OverdriveEffect(Api.overdrive.newOverdrive()); }
+
+    // New channel, already added to the mixer
+    inline Channel NewChannel()
+    {
+        Channel channel(Api.channel.newChannel());
+        if (channel)
+        {
+            Api.sound.addChannel(channel);
+        }
+        return channel;
+    }
+}
+
+#endif
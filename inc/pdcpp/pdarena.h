@@ -0,0 +1,110 @@
+#ifndef __PDARENA_H
+#define __PDARENA_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Per-frame linear arena (src/pdarena.c)
+// A bump-pointer region for scratch data that only lives for one frame.
+// playdate_cpp_app.hcpp resets it at the end of every update callback, so
+// nothing allocated from it may be kept across frames.
+// playdate_cpp_app.hcpp reserves PDCPP_FRAME_ARENA_SIZE bytes at launch.
+// With -DPDCPP_FRAME_ARENA_SIZE=0 there is no arena, pdcpp_arena_alloc()
+// returns NULL and FrameAllocator uses the heap.
+
+#ifndef PDCPP_FRAME_ARENA_SIZE
+#define PDCPP_FRAME_ARENA_SIZE (64 * 1024)
+#endif
+
+// Reserve the region from the system allocator. Returns 0 on success.
+int pdcpp_arena_init(size_t bytes);
+void pdcpp_arena_shutdown(void);
+
+// Returns NULL when the arena is full (or not initialized)
+void* pdcpp_arena_alloc(size_t size, size_t align);
+int pdcpp_arena_owns(const void* ptr);
+
+// Nested scopes: everything allocated after pdcpp_arena_mark() is released
+// by pdcpp_arena_release(mark).
+size_t pdcpp_arena_mark(void);
+void pdcpp_arena_release(size_t mark);
+
+// End of frame: release everything
+void pdcpp_arena_reset(void);
+
+typedef struct
+{
+	uint32_t capacity;
+	uint32_t used;       // bytes in use right now
+	uint32_t peak;       // highest use since init, to size the arena
+	uint32_t overflows;  // allocations that didn't fit
+} pdcpp_arena_stats_t;
+
+void pdcpp_arena_get_stats(pdcpp_arena_stats_t* stats);
+
+#ifdef __cplusplus
+}
+
+#include <stdlib.h>
+
+namespace pdcpp
+{
+    // Releases everything allocated from the frame arena during its lifetime.
+    // Scopes nest; objects allocated inside must not outlive the scope.
+    class ArenaScope
+    {
+    public:
+        ArenaScope() : Mark(pdcpp_arena_mark()) {}
+        ~ArenaScope() { pdcpp_arena_release(Mark); }
+
+        ArenaScope(const ArenaScope&) = delete;
+        ArenaScope& operator=(const ArenaScope&) = delete;
+
+    private:
+        size_t Mark;
+    };
+
+    // STL allocator on top of the frame arena, e.g.
+    //   std::vector<Contact, pdcpp::FrameAllocator<Contact>> contacts;
+    // Falls back to the heap when the arena is full, deallocate() is a no-op
+    // for arena memory.
+    template <typename T>
+    struct FrameAllocator
+    {
+        using value_type = T;
+
+        FrameAllocator() noexcept = default;
+        template <typename U>
+        FrameAllocator(const FrameAllocator<U>&) noexcept {}
+
+        T* allocate(size_t n)
+        {
+            void* p = pdcpp_arena_alloc(n * sizeof(T), alignof(T));
+            if (p == nullptr)
+            {
+                p = malloc(n * sizeof(T));
+            }
+            return static_cast<T*>(p);
+        }
+
+        void deallocate(T* p, size_t) noexcept
+        {
+            if (!pdcpp_arena_owns(p))
+            {
+                free(p);
+            }
+        }
+
+        template <typename U>
+        bool operator==(const FrameAllocator<U>&) const noexcept { return true; }
+        template <typename U>
+        bool operator!=(const FrameAllocator<U>&) const noexcept { return false; }
+    };
+}
+#endif
+
+#endif
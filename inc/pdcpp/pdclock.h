@@ -0,0 +1,30 @@
+#ifndef __PDCLOCK_H
+#define __PDCLOCK_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "pd_api.h"
+
+// Microsecond clock for the profiling tools (src/pdclock.c)
+// On device it counts CPU cycles with the Cortex-M7 DWT counter, calibrated
+// against the millisecond clock by pdcpp_clock_init(). The simulator and the
+// host build use the OS monotonic clock. getElapsedTime() is left to the game.
+// Main loop only: the conversion keeps state between calls, and the device
+// counter has to be read at least every ~20 s to not lose a wrap.
+
+// Enables the cycle counter and measures its rate (~10 ms on device, once).
+void pdcpp_clock_init(PlaydateAPI* pd);
+// Microseconds since pdcpp_clock_init, wraps after ~71 minutes: use differences
+uint32_t pdcpp_clock_us(void);
+// Raw cycle counter on device (microseconds elsewhere), for very short spans
+uint32_t pdcpp_clock_cycles(void);
+// Rate of pdcpp_clock_cycles(), 1 off device
+uint32_t pdcpp_clock_cycles_per_us(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,783 @@
+#ifndef __PDCONTAINERS_H
+#define __PDCONTAINERS_H
+
+// Fixed-capacity containers for hot paths (header only, C++)
+// StaticVector, SmallVector, RingBuffer and FlatMap keep their elements
+// inline, so a frame can use them without touching the heap and their memory
+// use is known at compile time. What happens when one is full is chosen with
+// an Overflow policy.
+
+#include <assert.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#include <functional>
+#include <initializer_list>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace pdcpp
+{
+    enum class Overflow
+    {
+        Assert,     // assert in debug builds, drop the element otherwise
+        Drop,       // refuse the new element, the insert returns false/nullptr
+        Overwrite,  // RingBuffer only: replace the oldest element
+        Heap        // move everything to a heap block twice as large
+    };
+
+    namespace detail
+    {
+        template <typename T, size_t N>
+        struct InlineStorage
+        {
+            T* Data() { return std::launder(reinterpret_cast<T*>(Bytes)); }
+            const T* Data() const { return std::launder(reinterpret_cast<const T*>(Bytes)); }
+
+            alignas(T) unsigned char Bytes[sizeof(T) * N];
+        };
+
+        inline bool Overflowed(Overflow policy)
+        {
+            (void)policy;
+            assert(policy != Overflow::Assert && "pdcpp container is full");
+            return false;
+        }
+
+        template <typename T>
+        void DestroyRange(T* first, T* last)
+        {
+            if constexpr (!std::is_trivially_destructible_v<T>)
+            {
+                for (; first != last; ++first)
+                {
+                    first->~T();
+                }
+            }
+        }
+
+        // Moves [first, last) to uninitialized memory and destroys the sources
+        template <typename T>
+        void Relocate(T* first, T* last, T* out)
+        {
+            for (; first != last; ++first, ++out)
+            {
+                new (out) T(std::move(*first));
+                first->~T();
+            }
+        }
+    }
+
+    //--------------------------------------------------------------------------
+    // Vector with room for N elements and no heap fallback, e.g.
+    //   pdcpp::StaticVector<vec2, 32, pdcpp::Overflow::Drop> hits;
+    // Same interface as std::vector for what it supports, except push_back
+    // returns false and emplace_back nullptr when the element was dropped.
+    template <typename T, size_t N, Overflow Policy = Overflow::Assert>
+    class StaticVector
+    {
+        static_assert(Policy == Overflow::Assert || Policy == Overflow::Drop,
+            "StaticVector asserts or drops, SmallVector falls back to the heap");
+
+    public:
+        using value_type = T;
+        using size_type = size_t;
+        using iterator = T*;
+        using const_iterator = const T*;
+
+        StaticVector() = default;
+
+        StaticVector(std::initializer_list<T> values)
+        {
+            for (const T& value : values)
+            {
+                push_back(value);
+            }
+        }
+
+        StaticVector(const StaticVector& other)
+        {
+            for (const T& value : other)
+            {
+                new (&Storage.Data()[Size++]) T(value);
+            }
+        }
+
+        StaticVector(StaticVector&& other) noexcept(std::is_nothrow_move_constructible_v<T>)
+        {
+            for (T& value : other)
+            {
+                new (&Storage.Data()[Size++]) T(std::move(value));
+            }
+            other.clear();
+        }
+
+        StaticVector& operator=(const StaticVector& other)
+        {
+            if (this != &other)
+            {
+                clear();
+                for (const T& value : other)
+                {
+                    new (&Storage.Data()[Size++]) T(value);
+                }
+            }
+            return *this;
+        }
+
+        StaticVector& operator=(StaticVector&& other) noexcept(std::is_nothrow_move_constructible_v<T>)
+        {
+            if (this != &other)
+            {
+                clear();
+                for (T& value : other)
+                {
+                    new (&Storage.Data()[Size++]) T(std::move(value));
+                }
+                other.clear();
+            }
+            return *this;
+        }
+
+        ~StaticVector() { clear(); }
+
+        size_t size() const { return Size; }
+        static constexpr size_t capacity() { return N; }
+        bool empty() const { return Size == 0; }
+        bool full() const { return Size == N; }
+
+        T* data() { return Storage.Data(); }
+        const T* data() const { return Storage.Data(); }
+        iterator begin() { return data(); }
+        iterator end() { return data() + Size; }
+        const_iterator begin() const { return data(); }
+        const_iterator end() const { return data() + Size; }
+
+        T& operator[](size_t i) { assert(i < Size); return data()[i]; }
+        const T& operator[](size_t i) const { assert(i < Size); return data()[i]; }
+        T& front() { return (*this)[0]; }
+        T& back() { return (*this)[Size - 1]; }
+
+        template <typename... Args>
+        T* emplace_back(Args&&... args)
+        {
+            if (Size == N)
+            {
+                detail::Overflowed(Policy);
+                return nullptr;
+            }
+            return new (&data()[Size++]) T(std::forward<Args>(args)...);
+        }
+
+        bool push_back(const T& value) { return emplace_back(value) != nullptr; }
+        bool push_back(T&& value) { return emplace_back(std::move(value)) != nullptr; }
+
+        void pop_back()
+        {
+            assert(Size > 0);
+            data()[--Size].~T();
+        }
+
+        void clear()
+        {
+            detail::DestroyRange(begin(), end());
+            Size = 0;
+        }
+
+        // Grows with default constructed elements, up to the capacity
+        void resize(size_t count)
+        {
+            while (Size > count) pop_back();
+            while (Size < count && emplace_back()) {}
+        }
+
+        // Keeps the order of the remaining elements
+        iterator erase(iterator position)
+        {
+            for (iterator it = position; it + 1 != end(); ++it)
+            {
+                *it = std::move(*(it + 1));
+            }
+            pop_back();
+            return position;
+        }
+
+        // O(1): the last element takes the place of the erased one
+        void erase_unordered(iterator position)
+        {
+            if (position + 1 != end())
+            {
+                *position = std::move(back());
+            }
+            pop_back();
+        }
+
+    private:
+        size_t Size = 0;
+        detail::InlineStorage<T, N> Storage;
+    };
+
+    //--------------------------------------------------------------------------
+    // Vector keeping its first N elements inline, and moving to the heap
+    // (malloc, doubling) past that. Sized right, a hot path never allocates;
+    // a rare spike still works. With Overflow::Assert or Overflow::Drop it
+    // never leaves the inline storage and behaves as a StaticVector when full.
+    template <typename T, size_t N, Overflow Policy = Overflow::Heap>
+    class SmallVector
+    {
+        static_assert(N > 0, "SmallVector needs some inline room");
+        static_assert(Policy != Overflow::Overwrite, "SmallVector can't choose what to overwrite");
+
+    public:
+        using value_type = T;
+        using size_type = size_t;
+        using iterator = T*;
+        using const_iterator = const T*;
+
+        SmallVector() = default;
+
+        SmallVector(std::initializer_list<T> values)
+        {
+            reserve(values.size());
+            for (const T& value : values)
+            {
+                push_back(value);
+            }
+        }
+
+        SmallVector(const SmallVector& other)
+        {
+            reserve(other.size());
+            for (const T& value : other)
+            {
+                push_back(value);
+            }
+        }
+
+        SmallVector(SmallVector&& other) noexcept(std::is_nothrow_move_constructible_v<T>)
+        {
+            TakeFrom(other);
+        }
+
+        SmallVector& operator=(const SmallVector& other)
+        {
+            if (this != &other)
+            {
+                clear();
+                reserve(other.size());
+                for (const T& value : other)
+                {
+                    push_back(value);
+                }
+            }
+            return *this;
+        }
+
+        SmallVector& operator=(SmallVector&& other) noexcept(std::is_nothrow_move_constructible_v<T>)
+        {
+            if (this != &other)
+            {
+                Release();
+                TakeFrom(other);
+            }
+            return *this;
+        }
+
+        ~SmallVector() { Release(); }
+
+        size_t size() const { return Size; }
+        size_t capacity() const { return Capacity; }
+        bool empty() const { return Size == 0; }
+        // True once the elements moved to the heap
+        bool uses_heap() const { return Data != Storage.Data(); }
+
+        T* data() { return Data; }
+        const T* data() const { return Data; }
+        iterator begin() { return Data; }
+        iterator end() { return Data + Size; }
+        const_iterator begin() const { return Data; }
+        const_iterator end() const { return Data + Size; }
+
+        T& operator[](size_t i) { assert(i < Size); return Data[i]; }
+        const T& operator[](size_t i) const { assert(i < Size); return Data[i]; }
+        T& front() { return (*this)[0]; }
+        T& back() { return (*this)[Size - 1]; }
+
+        // Returns false if the heap block couldn't be allocated, or without
+        // Overflow::Heap if count is over N
+        bool reserve(size_t count)
+        {
+            if (count <= Capacity)
+            {
+                return true;
+            }
+            if constexpr (Policy != Overflow::Heap)
+            {
+                return false;
+            }
+            T* block = static_cast<T*>(malloc(count * sizeof(T)));
+            if (block == nullptr)
+            {
+                return false;
+            }
+            MoveTo(block, count);
+            return true;
+        }
+
+        template <typename... Args>
+        T* emplace_back(Args&&... args)
+        {
+            if (Size < Capacity)
+            {
+                return new (&Data[Size++]) T(std::forward<Args>(args)...);
+            }
+            if constexpr (Policy != Overflow::Heap)
+            {
+                detail::Overflowed(Policy);
+                return nullptr;
+            }
+            else
+            {
+                // The new element is built before the others move, as with
+                // std::vector: an argument may refer to one of them
+                T* block = static_cast<T*>(malloc(Capacity * 2 * sizeof(T)));
+                if (block == nullptr)
+                {
+                    return nullptr;
+                }
+                T* element = new (&block[Size]) T(std::forward<Args>(args)...);
+                MoveTo(block, Capacity * 2);
+                ++Size;
+                return element;
+            }
+        }
+
+        bool push_back(const T& value) { return emplace_back(value) != nullptr; }
+        bool push_back(T&& value) { return emplace_back(std::move(value)) != nullptr; }
+
+        void pop_back()
+        {
+            assert(Size > 0);
+            Data[--Size].~T();
+        }
+
+        // Keeps the heap block if there is one, see shrink_to_fit
+        void clear()
+        {
+            detail::DestroyRange(begin(), end());
+            Size = 0;
+        }
+
+        // Back to the inline storage when the elements fit
+        void shrink_to_fit()
+        {
+            if (uses_heap() && Size <= N)
+            {
+                T* block = Data;
+                detail::Relocate(block, block + Size, Storage.Data());
+                free(block);
+                Data = Storage.Data();
+                Capacity = N;
+            }
+        }
+
+        void resize(size_t count)
+        {
+            while (Size > count) pop_back();
+            while (Size < count && emplace_back()) {}
+        }
+
+        iterator erase(iterator position)
+        {
+            for (iterator it = position; it + 1 != end(); ++it)
+            {
+                *it = std::move(*(it + 1));
+            }
+            pop_back();
+            return position;
+        }
+
+        void erase_unordered(iterator position)
+        {
+            if (position + 1 != end())
+            {
+                *position = std::move(back());
+            }
+            pop_back();
+        }
+
+    private:
+        void Release()
+        {
+            clear();
+            if (uses_heap())
+            {
+                free(Data);
+            }
+            Data = Storage.Data();
+            Capacity = N;
+        }
+
+        // Relocates the elements into a heap block of `count` elements
+        void MoveTo(T* block, size_t count)
+        {
+            detail::Relocate(begin(), end(), block);
+            if (uses_heap())
+            {
+                free(Data);
+            }
+            Data = block;
+            Capacity = count;
+        }
+
+        void TakeFrom(SmallVector& other)
+        {
+            if (other.uses_heap())
+            {
+                // Steal the block
+                Data = other.Data;
+                Size = other.Size;
+                Capacity = other.Capacity;
+                other.Data = other.Storage.Data();
+                other.Size = 0;
+                other.Capacity = N;
+            }
+            else
+            {
+                for (T& value : other)
+                {
+                    new (&Data[Size++]) T(std::move(value));
+                }
+                other.clear();
+            }
+        }
+
+        detail::InlineStorage<T, N> Storage;
+        T* Data = Storage.Data();
+        size_t Size = 0;
+        size_t Capacity = N;
+    };
+
+    //--------------------------------------------------------------------------
+    // FIFO of at most N elements. Index 0 is the oldest. With
+    // Overflow::Overwrite it keeps the N most recent elements (history,
+    // smoothing windows...).
+    template <typename T, size_t N, Overflow Policy = Overflow::Assert>
+    class RingBuffer
+    {
+        static_assert(Policy != Overflow::Heap, "RingBuffer has a fixed capacity");
+
+    public:
+        using value_type = T;
+        using size_type = size_t;
+
+        RingBuffer() = default;
+        RingBuffer(const RingBuffer&) = delete;
+        RingBuffer& operator=(const RingBuffer&) = delete;
+        ~RingBuffer() { clear(); }
+
+        size_t size() const { return Size; }
+        static constexpr size_t capacity() { return N; }
+        bool empty() const { return Size == 0; }
+        bool full() const { return Size == N; }
+
+        T& operator[](size_t i) { assert(i < Size); return Storage.Data()[Wrap(Head + i)]; }
+        const T& operator[](size_t i) const { assert(i < Size); return Storage.Data()[Wrap(Head + i)]; }
+        T& front() { return (*this)[0]; }
+        T& back() { return (*this)[Size - 1]; }
+
+        template <typename... Args>
+        T* emplace_back(Args&&... args)
+        {
+            if (Size == N)
+            {
+                if constexpr (Policy == Overflow::Overwrite)
+                {
+                    pop_front();
+                }
+                else
+                {
+                    detail::Overflowed(Policy);
+                    return nullptr;
+                }
+            }
+            return new (&Storage.Data()[Wrap(Head + Size++)]) T(std::forward<Args>(args)...);
+        }
+
+        bool push_back(const T& value) { return emplace_back(value) != nullptr; }
+        bool push_back(T&& value) { return emplace_back(std::move(value)) != nullptr; }
+
+        void pop_front()
+        {
+            assert(Size > 0);
+            Storage.Data()[Head].~T();
+            Head = Wrap(Head + 1);
+            --Size;
+        }
+
+        void clear()
+        {
+            while (Size)
+            {
+                pop_front();
+            }
+            Head = 0;
+        }
+
+    private:
+        // Power of two capacities turn this into a mask
+        static size_t Wrap(size_t i) { return i % N; }
+
+        size_t Head = 0;
+        size_t Size = 0;
+        detail::InlineStorage<T, N> Storage;
+    };
+
+    //--------------------------------------------------------------------------
+    // Hash map with open addressing (linear probing, backward shift deletion)
+    // over N inline slots, N a power of two. Lookups walk a contiguous array,
+    // no node allocation. Full at 3/4 of the slots; Overflow::Heap then doubles
+    // the table on the heap.
+    template <typename K>
+    struct FlatHash
+    {
+        size_t operator()(const K& key) const
+        {
+            // std::hash is the identity for integers: mix it for the low bits
+            uint32_t h = (uint32_t)std::hash<K>{}(key);
+            h ^= h >> 16;
+            h *= 0x85ebca6bu;
+            h ^= h >> 13;
+            h *= 0xc2b2ae35u;
+            h ^= h >> 16;
+            return h;
+        }
+    };
+
+    template <typename K, typename V, size_t N, Overflow Policy = Overflow::Assert, typename Hash = FlatHash<K>>
+    class FlatMap
+    {
+        static_assert(N >= 4 && (N & (N - 1)) == 0, "FlatMap needs a power of two slot count");
+        static_assert(Policy != Overflow::Overwrite, "FlatMap can't choose what to overwrite");
+
+    public:
+        struct Entry
+        {
+            K key;
+            V value;
+        };
+
+        template <typename E, typename M>
+        class Iterator
+        {
+        public:
+            Iterator(M* map, size_t slot) : Map(map), Slot(slot) { Skip(); }
+            E& operator*() const { return Map->Slots[Slot]; }
+            E* operator->() const { return &Map->Slots[Slot]; }
+            Iterator& operator++() { ++Slot; Skip(); return *this; }
+            bool operator==(const Iterator& other) const { return Slot == other.Slot; }
+            bool operator!=(const Iterator& other) const { return Slot != other.Slot; }
+
+        private:
+            void Skip() { while (Slot < Map->Capacity && !Map->Used[Slot]) ++Slot; }
+
+            M* Map;
+            size_t Slot;
+        };
+
+        using iterator = Iterator<Entry, FlatMap>;
+        using const_iterator = Iterator<const Entry, const FlatMap>;
+
+        FlatMap() = default;
+        FlatMap(const FlatMap&) = delete;
+        FlatMap& operator=(const FlatMap&) = delete;
+
+        ~FlatMap()
+        {
+            clear();
+            ReleaseHeap();
+        }
+
+        size_t size() const { return Size; }
+        size_t capacity() const { return Capacity; }
+        bool empty() const { return Size == 0; }
+
+        iterator begin() { return iterator(this, 0); }
+        iterator end() { return iterator(this, Capacity); }
+        const_iterator begin() const { return const_iterator(this, 0); }
+        const_iterator end() const { return const_iterator(this, Capacity); }
+
+        V* find(const K& key)
+        {
+            size_t slot = Lookup(key);
+            return slot < Capacity ? &Slots[slot].value : nullptr;
+        }
+
+        const V* find(const K& key) const { return const_cast<FlatMap*>(this)->find(key); }
+        bool contains(const K& key) const { return find(key) != nullptr; }
+
+        // Value of an existing key, or a new one built from args. nullptr when
+        // the map is full and the policy doesn't allow growing.
+        template <typename... Args>
+        V* try_emplace(const K& key, Args&&... args)
+        {
+            if (V* value = find(key))
+            {
+                return value;
+            }
+            if ((Size + 1) * 4 > Capacity * 3)
+            {
+                if constexpr (Policy == Overflow::Heap)
+                {
+                    if (!Grow())
+                    {
+                        return nullptr;
+                    }
+                }
+                else
+                {
+                    detail::Overflowed(Policy);
+                    return nullptr;
+                }
+            }
+
+            size_t slot = Home(key);
+            while (Used[slot])
+            {
+                slot = (slot + 1) & (Capacity - 1);
+            }
+            new (&Slots[slot]) Entry{ key, V(std::forward<Args>(args)...) };
+            Used[slot] = 1;
+            ++Size;
+            return &Slots[slot].value;
+        }
+
+        // Inserts or replaces
+        V* insert_or_assign(const K& key, V value)
+        {
+            V* slot = try_emplace(key);
+            if (slot)
+            {
+                *slot = std::move(value);
+            }
+            return slot;
+        }
+
+        bool erase(const K& key)
+        {
+            size_t hole = Lookup(key);
+            if (hole >= Capacity)
+            {
+                return false;
+            }
+            Slots[hole].~Entry();
+            Used[hole] = 0;
+            --Size;
+
+            // Shift back the following entries of the run that can move closer to home
+            const size_t mask = Capacity - 1;
+            for (size_t slot = (hole + 1) & mask; Used[slot]; slot = (slot + 1) & mask)
+            {
+                size_t home = Home(Slots[slot].key);
+                if (((slot - home) & mask) >= ((slot - hole) & mask))
+                {
+                    new (&Slots[hole]) Entry(std::move(Slots[slot]));
+                    Slots[slot].~Entry();
+                    Used[hole] = 1;
+                    Used[slot] = 0;
+                    hole = slot;
+                }
+            }
+            return true;
+        }
+
+        void clear()
+        {
+            for (size_t slot = 0; slot < Capacity; ++slot)
+            {
+                if (Used[slot])
+                {
+                    Slots[slot].~Entry();
+                    Used[slot] = 0;
+                }
+            }
+            Size = 0;
+        }
+
+    private:
+        size_t Home(const K& key) const { return Hash{}(key) & (Capacity - 1); }
+
+        size_t Lookup(const K& key) const
+        {
+            for (size_t slot = Home(key); Used[slot]; slot = (slot + 1) & (Capacity - 1))
+            {
+                if (Slots[slot].key == key)
+                {
+                    return slot;
+                }
+            }
+            return Capacity;
+        }
+
+        bool Grow()
+        {
+            size_t capacity = Capacity * 2;
+            Entry* slots = static_cast<Entry*>(malloc(capacity * sizeof(Entry)));
+            uint8_t* used = static_cast<uint8_t*>(calloc(capacity, 1));
+            if (slots == nullptr || used == nullptr)
+            {
+                free(slots);
+                free(used);
+                return false;
+            }
+
+            Entry* oldSlots = Slots;
+            uint8_t* oldUsed = Used;
+            size_t oldCapacity = Capacity;
+            Slots = slots;
+            Used = used;
+            Capacity = capacity;
+            for (size_t i = 0; i < oldCapacity; ++i)
+            {
+                if (oldUsed[i])
+                {
+                    size_t slot = Home(oldSlots[i].key);
+                    while (Used[slot])
+                    {
+                        slot = (slot + 1) & (Capacity - 1);
+                    }
+                    new (&Slots[slot]) Entry(std::move(oldSlots[i]));
+                    oldSlots[i].~Entry();
+                    Used[slot] = 1;
+                }
+            }
+
+            if (oldSlots != Storage.Data())
+            {
+                free(oldSlots);
+                free(oldUsed);
+            }
+            return true;
+        }
+
+        void ReleaseHeap()
+        {
+            if (Slots != Storage.Data())
+            {
+                free(Slots);
+                free(Used);
+            }
+        }
+
+        detail::InlineStorage<Entry, N> Storage;
+        uint8_t InlineUsed[N] = {};
+        Entry* Slots = Storage.Data();
+        uint8_t* Used = InlineUsed;
+        size_t Capacity = N;
+        size_t Size = 0;
+    };
+}
+
+#endif
@@ -0,0 +1,203 @@
+#ifndef __PDFORMAT_H
+#define __PDFORMAT_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+
+// Text formatting without the C library printf (src/pdformat.c)
+// newlib's printf is slow with floats and pulls its whole float conversion
+// into pdex.elf. These write into the caller's buffer, never allocate, and
+// convert floats with single precision arithmetic at a fixed number of
+// decimals: enough for debug text drawn every frame.
+//   char text[64];
+//   int length = pdcpp::Format(text, "v=%.1f hits=%d", speed, hits);
+//   pd->graphics->drawText(text, length, kASCIIEncoding, 0, 0);
+// In C++ the format is checked against the arguments at compile time.
+//
+// Conversions: %d %i %u %x %X %c %f %s %p and %%, with the flags - + space 0 #,
+// a width and a precision (digits for %d, decimals for %f, up to 9, 6 by
+// default, characters for %s). No %e or %g, no * for the width. Floats are
+// rounded as printf does but hold about 7 significant digits: the digits past
+// them differ from printf. Every function returns the length written, the
+// text is cut to fit and always terminated (size > 0).
+
+int pdcpp_format_uint(char* buffer, int size, uint32_t value);
+int pdcpp_format_int(char* buffer, int size, int32_t value);
+int pdcpp_format_float(char* buffer, int size, float value, int decimals);
+
+// One per conversion, in order, of the type it expects
+typedef union
+{
+	int32_t i;                  // %d %i %c
+	uint32_t u;                 // %u %x %X
+	float f;                    // %f
+	const char* s;              // %s
+	const void* p;              // %p
+} pdcpp_format_arg_t;
+
+// printf into buffer with the arguments of `args`, which aren't checked
+int pdcpp_format_args(char* buffer, int size, const char* format, const pdcpp_format_arg_t* args, int count);
+
+#ifdef __cplusplus
+}
+
+#include <type_traits>
+
+namespace pdcpp
+{
+    namespace detail
+    {
+        // Not constexpr: calling it stops the compilation of a bad format,
+        // the message is in the error
+        void FormatError(const char* message);
+
+        // What an argument is to a format: 'd' integer up to 32 bits, 'f'
+        // float, 's' string, 'p' pointer, 0 none of them
+        template <typename T>
+        constexpr char FormatKind()
+        {
+            if constexpr (std::is_floating_point_v<T>)
+            {
+                return 'f';
+            }
+            else if constexpr ((std::is_integral_v<T> || std::is_enum_v<T>) && sizeof(T) <= 4)
+            {
+                return 'd';
+            }
+            else if constexpr (std::is_same_v<std::remove_cv_t<std::remove_pointer_t<std::decay_t<T>>>, char>)
+            {
+                return 's';
+            }
+            else if constexpr (std::is_pointer_v<std::decay_t<T>> || std::is_null_pointer_v<T>)
+            {
+                return 'p';
+            }
+            else
+            {
+                return 0;
+            }
+        }
+
+        // Checks a format against the kinds of its arguments. `conversions`
+        // are the ones the caller handles.
+        consteval void CheckFormat(const char* format, const char* kinds, int count, const char* conversions)
+        {
+            int arg = 0;
+            for (const char* c = format; *c; ++c)
+            {
+                if (*c != '%')
+                {
+                    continue;
+                }
+                if (*++c == '%')
+                {
+                    continue;
+                }
+                while (*c == '-' || *c == '+' || *c == ' ' || *c == '#' || *c == '0') ++c;
+                while (*c >= '0' && *c <= '9') ++c;
+                if (*c == '.')
+                {
+                    ++c;
+                    while (*c >= '0' && *c <= '9') ++c;
+                }
+                while (*c == 'h' || *c == 'l') ++c;
+
+                bool handled = false;
+                for (const char* conversion = conversions; *conversion; ++conversion)
+                {
+                    handled = handled || (*c != 0 && *c == *conversion);
+                }
+                if (!handled)
+                {
+                    FormatError("unsupported conversion in the format");
+                    return;
+                }
+
+                char kind;
+                switch (*c)
+                {
+                case 'f': case 'F': case 'e': case 'E': case 'g': case 'G': case 'a': case 'A':
+                    kind = 'f';
+                    break;
+                case 's':
+                case 'p':
+                    kind = *c;
+                    break;
+                default:
+                    kind = 'd';
+                    break;
+                }
+                if (arg == count)
+                {
+                    FormatError("more conversions than arguments in the format");
+                    return;
+                }
+                // Any pointer for %p
+                if (kinds[arg] != kind && !(kind == 'p' && kinds[arg] == 's'))
+                {
+                    FormatError("argument of the wrong type for its conversion");
+                }
+                ++arg;
+            }
+            if (arg != count)
+            {
+                FormatError("more arguments than conversions in the format");
+            }
+        }
+
+        template <typename T>
+        inline pdcpp_format_arg_t FormatArg(T value)
+        {
+            pdcpp_format_arg_t arg;
+            if constexpr (std::is_floating_point_v<T>)
+            {
+                arg.f = static_cast<float>(value);
+            }
+            else if constexpr (FormatKind<T>() == 's')
+            {
+                arg.s = value;
+            }
+            else if constexpr (std::is_pointer_v<std::decay_t<T>> || std::is_null_pointer_v<T>)
+            {
+                arg.p = value;
+            }
+            else
+            {
+                arg.u = static_cast<uint32_t>(value);
+            }
+            return arg;
+        }
+    }
+
+    // A format string checked against the argument types
+    template <typename... Args>
+    struct FormatString
+    {
+        const char* Text;
+
+        consteval FormatString(const char* text) : Text(text)
+        {
+            constexpr char kinds[] = { detail::FormatKind<Args>()..., 0 };
+            detail::CheckFormat(text, kinds, sizeof...(Args), "diuxXcfFsp");
+        }
+    };
+
+    template <typename... Args>
+    inline int Format(char* buffer, int size, FormatString<std::type_identity_t<Args>...> format, Args... args)
+    {
+        const pdcpp_format_arg_t list[sizeof...(Args) + 1] = { detail::FormatArg(args)..., {} };
+        return pdcpp_format_args(buffer, size, format.Text, list, sizeof...(Args));
+    }
+
+    template <int Size, typename... Args>
+    inline int Format(char (&buffer)[Size], FormatString<std::type_identity_t<Args>...> format, Args... args)
+    {
+        return Format<Args...>(buffer, Size, format, args...);
+    }
+}
+#endif
+
+#endif
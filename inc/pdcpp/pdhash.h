@@ -0,0 +1,62 @@
+#ifndef __PDHASH_H
+#define __PDHASH_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+
+// String hashes (header only)
+// 32-bit FNV-1a: short, no table, good enough to key asset paths and log
+// formats. In C++ pdcpp::HashedString computes it at compile time for string
+// literals, so the game only carries the number (and the pointer).
+
+#define PDCPP_FNV1A_SEED 2166136261u
+#define PDCPP_FNV1A_PRIME 16777619u
+
+static inline uint32_t pdcpp_hash_string(const char* text)
+{
+	uint32_t hash = PDCPP_FNV1A_SEED;
+	while (*text)
+	{
+		hash = (hash ^ (uint8_t)*text++) * PDCPP_FNV1A_PRIME;
+	}
+	return hash;
+}
+
+#ifdef __cplusplus
+}
+
+namespace pdcpp
+{
+    constexpr uint32_t HashString(const char* text)
+    {
+        uint32_t hash = PDCPP_FNV1A_SEED;
+        while (*text)
+        {
+            hash = (hash ^ static_cast<uint8_t>(*text++)) * PDCPP_FNV1A_PRIME;
+        }
+        return hash;
+    }
+
+    // A string and its hash, computed by the compiler for a literal:
+    //   void Load(pdcpp::HashedString path);
+    //   Load("images/ship");
+    // A string only known at run time has to say so: HashedString::Runtime(path).
+    struct HashedString
+    {
+        const char* Text;
+        uint32_t Hash;
+
+        consteval HashedString(const char* text) : Text(text), Hash(HashString(text)) {}
+
+        static HashedString Runtime(const char* text) { return HashedString(text, pdcpp_hash_string(text)); }
+
+    private:
+        constexpr HashedString(const char* text, uint32_t hash) : Text(text), Hash(hash) {}
+    };
+}
+#endif
+
+#endif
@@ -0,0 +1,116 @@
+#ifndef __PDLAZY_H
+#define __PDLAZY_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "pd_api.h"
+
+// Lazy-init registry (src/pdlazy.c)
+// Heavy globals don't have to be built by the static initializers during
+// kEventInit: they can be built on first use, or queued and built a few at a
+// time during the first frames by pdcpp_lazy_step().
+
+// Time playdate_cpp_app.hcpp gives to queued nodes every frame
+#ifndef PDCPP_LAZY_FRAME_BUDGET_MS
+#define PDCPP_LAZY_FRAME_BUDGET_MS 4
+#endif
+
+typedef enum
+{
+	PDCPP_LAZY_IDLE,
+	PDCPP_LAZY_QUEUED,
+	PDCPP_LAZY_READY
+} pdcpp_lazy_state_t;
+
+// Intrusive node, usually embedded in the lazily built object (see pdcpp::Lazy).
+// Can be statically initialized: { NULL, NULL, init, destroy, PDCPP_LAZY_IDLE },
+// destroy may be NULL.
+typedef struct pdcpp_lazy_node
+{
+	struct pdcpp_lazy_node* next;
+	struct pdcpp_lazy_node* built;
+	void (*init)(struct pdcpp_lazy_node* node);
+	void (*destroy)(struct pdcpp_lazy_node* node);
+	pdcpp_lazy_state_t state;
+} pdcpp_lazy_node;
+
+// Queue the node to be built by pdcpp_lazy_step (does nothing if already queued or built)
+void pdcpp_lazy_schedule(pdcpp_lazy_node* node);
+// Build the node now if it isn't built yet
+void pdcpp_lazy_run(pdcpp_lazy_node* node);
+// Build queued nodes in order until `budgetMs` is spent (at least one per call).
+// Returns the number of nodes still queued.
+int pdcpp_lazy_step(PlaydateAPI* pd, unsigned int budgetMs);
+int pdcpp_lazy_pending(void);
+// Destroy the built nodes, last built first, and set them back to idle.
+// playdate_cpp_app.hcpp calls it on kEventTerminate, other apps that use
+// pdcpp::Lazy call it from their own eventHandler.
+void pdcpp_lazy_teardown(void);
+
+#ifdef __cplusplus
+}
+
+#include <new>
+
+namespace pdcpp
+{
+    // A global built on first use instead of at static initialization, e.g.
+    //   static pdcpp::Lazy<std::vector<Entry>> entries([]{ return std::vector<Entry>{ ... }; });
+    //   entries->size();
+    // The constructor is constexpr and the destructor trivial, so declaring one
+    // adds nothing to the init arrays and registers nothing with atexit: the
+    // object is destroyed by pdcpp_lazy_teardown().
+    // Call Schedule() to build it during the first frames instead.
+    template <typename T>
+    class Lazy : private pdcpp_lazy_node
+    {
+    public:
+        using Factory = T (*)();
+
+        constexpr explicit Lazy(Factory factory)
+        : pdcpp_lazy_node{nullptr, nullptr, &Build, &Destroy, PDCPP_LAZY_IDLE}
+        , Make(factory)
+        {
+        }
+
+        Lazy(const Lazy&) = delete;
+        Lazy& operator=(const Lazy&) = delete;
+
+        void Schedule() { pdcpp_lazy_schedule(this); }
+        bool IsReady() const { return state == PDCPP_LAZY_READY; }
+
+        T& Get()
+        {
+            if (!IsReady())
+            {
+                pdcpp_lazy_run(this);
+            }
+            return *Object();
+        }
+
+        T& operator*() { return Get(); }
+        T* operator->() { return &Get(); }
+
+    private:
+        static void Build(pdcpp_lazy_node* node)
+        {
+            Lazy* self = static_cast<Lazy*>(node);
+            new (self->Storage) T(self->Make());
+        }
+
+        static void Destroy(pdcpp_lazy_node* node)
+        {
+            static_cast<Lazy*>(node)->Object()->~T();
+        }
+
+        T* Object() { return std::launder(reinterpret_cast<T*>(Storage)); }
+
+        Factory Make;
+        alignas(T) unsigned char Storage[sizeof(T)] = {};
+    };
+}
+#endif
+
+#endif
@@ -0,0 +1,164 @@
+#ifndef __PDLOG_H
+#define __PDLOG_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "pd_api.h"
+#include "pdcpp/pdclock.h"
+
+// Binary log (src/pdlog.c)
+// PDCPP_LOG_INFO("level %d loaded in %.1f ms", index, ms) doesn't format
+// anything on device: it stores the FNV-1a hash of the format (pdhash.h,
+// computed by the compiler), the time and the raw arguments in a ring of
+// PDCPP_LOG_RECORDS fixed-size records, a handful of stores. The newest records
+// are written to log.pdlg in the data folder on kEventTerminate
+// (playdate_cpp_app.hcpp). The build scans the sources for the formats
+// (<application>_log_formats.txt), `pdlog print` formats the records on the
+// build machine:
+//   pdlog print build/examples/physics/Physics_log_formats.txt log.pdlg
+//
+// The format must be a string literal. Arguments are integers up to 32 bits,
+// floats and pointers, one record holds PDCPP_LOG_ARGS of them; the format is
+// checked against them at compile time. No %s: the strings aren't copied.
+// C++ only, the macros are at the end.
+//
+// Levels: the records below PDCPP_LOG_LEVEL (-DPDCPP_LOG_LEVEL=INFO by default)
+// compile to nothing. A file can set its own level by defining
+// PDCPP_LOG_MODULE_LEVEL before including this header:
+//   #define PDCPP_LOG_MODULE_LEVEL PDCPP_LOG_LEVEL_DEBUG
+// -DPDCPP_LOG_LEVEL=OFF removes the log and the ring altogether.
+
+#define PDCPP_LOG_LEVEL_TRACE 0
+#define PDCPP_LOG_LEVEL_DEBUG 1
+#define PDCPP_LOG_LEVEL_INFO 2
+#define PDCPP_LOG_LEVEL_WARN 3
+#define PDCPP_LOG_LEVEL_ERROR 4
+#define PDCPP_LOG_LEVEL_OFF 5
+
+#ifndef PDCPP_LOG_LEVEL
+#define PDCPP_LOG_LEVEL PDCPP_LOG_LEVEL_INFO
+#endif
+
+#ifndef PDCPP_LOG_MODULE_LEVEL
+#define PDCPP_LOG_MODULE_LEVEL PDCPP_LOG_LEVEL
+#endif
+
+// 32 bytes each, a power of two
+#ifndef PDCPP_LOG_RECORDS
+#define PDCPP_LOG_RECORDS 1024
+#endif
+
+#define PDCPP_LOG_ARGS 5
+
+#ifndef PDCPP_LOG_PATH
+#define PDCPP_LOG_PATH "log.pdlg"
+#endif
+
+typedef struct
+{
+	uint32_t format;            // hash of the format string
+	uint32_t us;                // pdcpp_clock_us()
+	uint16_t level;
+	uint16_t count;             // of args
+	uint32_t args[PDCPP_LOG_ARGS]; // floats as their bits
+} pdcpp_log_record_t;
+
+extern pdcpp_log_record_t pdcpp_log_ring[PDCPP_LOG_RECORDS];
+// Records logged since the start, the ring keeps the last PDCPP_LOG_RECORDS
+extern uint32_t pdcpp_log_count;
+
+static inline pdcpp_log_record_t* pdcpp_log_next(void)
+{
+	return &pdcpp_log_ring[pdcpp_log_count++ & (PDCPP_LOG_RECORDS - 1)];
+}
+
+// Zero with -DPDCPP_LOG_LEVEL=OFF
+int pdcpp_log_enabled(void);
+// Starts the clock (pdclock.h)
+void pdcpp_log_init(PlaydateAPI* pd);
+
+// Forget the records so far
+void pdcpp_log_clear(void);
+// Write the records in the ring, oldest first. Returns 0 on success, -1 on
+// error or without the log.
+int pdcpp_log_write(const char* path);
+
+#ifdef __cplusplus
+}
+
+#include <bit>
+#include <type_traits>
+
+#include "pdcpp/pdformat.h"
+#include "pdcpp/pdhash.h"
+
+namespace pdcpp
+{
+    namespace detail
+    {
+        template <typename T>
+        inline uint32_t LogWord(T value)
+        {
+            if constexpr (std::is_floating_point_v<T>)
+            {
+                return std::bit_cast<uint32_t>(static_cast<float>(value));
+            }
+            else if constexpr (std::is_pointer_v<T> || std::is_null_pointer_v<T>)
+            {
+                return static_cast<uint32_t>(reinterpret_cast<uintptr_t>(value));
+            }
+            else
+            {
+                return static_cast<uint32_t>(value);
+            }
+        }
+    }
+
+    // A format string checked against the argument types, and its hash
+    template <typename... Args>
+    struct LogFormat
+    {
+        uint32_t Hash;
+
+        consteval LogFormat(const char* format) : Hash(HashString(format))
+        {
+            constexpr char kinds[] = { detail::FormatKind<Args>()..., 0 };
+            static_assert(sizeof...(Args) <= PDCPP_LOG_ARGS, "too many log arguments");
+            // The strings aren't copied: no %s
+            detail::CheckFormat(format, kinds, sizeof...(Args), "diouxXcfFeEgGaAp");
+        }
+    };
+
+    template <int Level, typename... Args>
+    inline void Log(LogFormat<std::type_identity_t<Args>...> format, Args... args)
+    {
+        pdcpp_log_record_t* record = pdcpp_log_next();
+        record->format = format.Hash;
+        record->us = pdcpp_clock_us();
+        record->level = Level;
+        record->count = sizeof...(Args);
+        int arg = 0;
+        ((record->args[arg++] = detail::LogWord(args)), ...);
+        (void)arg;
+    }
+}
+
+#if PDCPP_LOG_LEVEL < PDCPP_LOG_LEVEL_OFF
+// The records of a filtered level are still checked, then discarded
+#define PDCPP_LOG_AT(level, ...) do { if constexpr ((level) >= PDCPP_LOG_MODULE_LEVEL) pdcpp::Log<level>(__VA_ARGS__); } while (0)
+#else
+#define PDCPP_LOG_AT(level, ...) ((void)0)
+#endif
+
+// Scanned by `pdlog table`: the format has to follow the parenthesis
+#define PDCPP_LOG_TRACE(...) PDCPP_LOG_AT(PDCPP_LOG_LEVEL_TRACE, __VA_ARGS__)
+#define PDCPP_LOG_DEBUG(...) PDCPP_LOG_AT(PDCPP_LOG_LEVEL_DEBUG, __VA_ARGS__)
+#define PDCPP_LOG_INFO(...) PDCPP_LOG_AT(PDCPP_LOG_LEVEL_INFO, __VA_ARGS__)
+#define PDCPP_LOG_WARN(...) PDCPP_LOG_AT(PDCPP_LOG_LEVEL_WARN, __VA_ARGS__)
+#define PDCPP_LOG_ERROR(...) PDCPP_LOG_AT(PDCPP_LOG_LEVEL_ERROR, __VA_ARGS__)
+
+#endif
+
+#endif
@@ -0,0 +1,83 @@
+#ifndef __PDMEMSTATS_H
+#define __PDMEMSTATS_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+
+// Allocation telemetry (src/setup.c)
+// Counts what goes through malloc/realloc/free when built with
+// -DPDCPP_ALLOC_TELEMETRY=ON, every value stays 0 otherwise.
+// Tracking adds a small header to every block to remember its size.
+
+// Request sizes: bucket 0 counts 0 to 8 bytes, bucket i up to 10 counts
+// (2^(i+2), 2^(i+3)] bytes (9-16, 17-32, ... 4K+1-8K), bucket 11 everything
+// over 8K
+#define PDCPP_MEMSTATS_BUCKETS 12
+
+typedef struct
+{
+	uint32_t allocs;          // malloc, new
+	uint32_t reallocs;        // realloc of an existing block
+	uint32_t frees;
+	uint32_t bytesRequested;  // sum of allocation and realloc sizes
+	uint32_t histogram[PDCPP_MEMSTATS_BUCKETS];
+} pdcpp_memstats_counters_t;
+
+typedef struct
+{
+	pdcpp_memstats_counters_t frame;      // current frame so far
+	pdcpp_memstats_counters_t lastFrame;  // previous complete frame
+	pdcpp_memstats_counters_t total;      // since launch
+	uint32_t liveBytes;
+	uint32_t liveBlocks;
+	uint32_t peakBytes;                   // high-water mark of liveBytes
+	uint32_t framePeakBytes;              // high-water mark during the current frame
+} pdcpp_memstats_t;
+
+// Non-zero if the allocator shims were built with telemetry
+int pdcpp_memstats_enabled(void);
+void pdcpp_memstats_get(pdcpp_memstats_t* stats);
+// Called by the update loop: current frame becomes lastFrame
+void pdcpp_memstats_new_frame(void);
+// Restart the high-water mark from the current live bytes (e.g. on level load)
+void pdcpp_memstats_reset_peak(void);
+
+#ifdef __cplusplus
+}
+
+namespace pdcpp
+{
+    // Counts the allocations made during its lifetime, to hunt hot-path allocations:
+    //   pdcpp::AllocationCounter counter;
+    //   ...
+    //   if (counter.Allocs()) logToConsole("%u allocs", counter.Allocs());
+    class AllocationCounter
+    {
+    public:
+        AllocationCounter() { Start = Snapshot(); }
+
+        uint32_t Allocs() const
+        {
+            pdcpp_memstats_counters_t now = Snapshot();
+            return now.allocs + now.reallocs - Start.allocs - Start.reallocs;
+        }
+        uint32_t Frees() const { return Snapshot().frees - Start.frees; }
+        uint32_t Bytes() const { return Snapshot().bytesRequested - Start.bytesRequested; }
+
+    private:
+        static pdcpp_memstats_counters_t Snapshot()
+        {
+            pdcpp_memstats_t stats;
+            pdcpp_memstats_get(&stats);
+            return stats.total;
+        }
+
+        pdcpp_memstats_counters_t Start;
+    };
+}
+#endif
+
+#endif
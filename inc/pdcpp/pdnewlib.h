@@ -8,6 +8,17 @@ extern "C" {
 #include "pd_api.h"
 int eventHandler_pdnewlib(PlaydateAPI*, PDSystemEvent event, uint32_t arg);
 
+// stdout/stderr (printf, std::cout...) are buffered and logged to the console
+// line by line. In deferred mode lines are only logged by pdcpp_console_flush(),
+// which the update loop calls once per frame, so logging doesn't skew frame timings.
+void pdcpp_console_set_deferred(int deferred);
+void pdcpp_console_flush(void);
+
+// open/fopen go through pd->file with a read-ahead or write-behind buffer per
+// file (PDCPP_FILE_BUFFER_SIZE bytes by default). Applies to files opened after
+// the call, 0 disables buffering.
+void pdcpp_file_set_buffer_size(unsigned int bytes);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,29 @@
+#ifndef __PDPGO_H
+#define __PDPGO_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "pd_api.h"
+
+// Function hit profile for the link order (src/pdpgo.c)
+// With -DPDCPP_PGO_INSTRUMENT=ON the device build is compiled with
+// -finstrument-functions and every function entry is counted. The counts are
+// written to the data folder on kEventTerminate, then
+// buildsupport/GenerateLinkOrder.cmake turns them into a linker script that
+// packs the hot functions together (see readme.md).
+
+#ifndef PDCPP_PGO_PROFILE_PATH
+#define PDCPP_PGO_PROFILE_PATH "pgo_profile.txt"
+#endif
+
+// Write the counts collected so far. Returns 0 on success, -1 if the file
+// can't be written or the build isn't instrumented.
+int pdcpp_pgo_write(PlaydateAPI* pd, const char* path);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
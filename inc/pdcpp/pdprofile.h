@@ -0,0 +1,118 @@
+#ifndef __PDPROFILE_H
+#define __PDPROFILE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "pd_api.h"
+
+// Hierarchical frame profiler (src/pdprofile.c)
+// Built with -DPDCPP_PROFILER=ON, PDCPP_PROFILE_SCOPE("name") times the rest
+// of the enclosing block with the clock of pdclock.h (cycle counter on device).
+// Scopes opened inside another one are its children: the tree keeps the total
+// and self time of every node, averaged over PDCPP_PROFILE_PERIOD frames.
+// PDCPP_PROFILE_HUD(pd, x, y) draws the frame time graph and the scopes with the
+// most self time. Without the option the scopes compile to nothing and the HUD
+// is pd->system->drawFPS. The scopes are also the events of -DPDCPP_TRACE=ON
+// (pdtrace.h).
+
+// Distinct (parent, name) pairs, the scopes past it are not timed
+#ifndef PDCPP_PROFILE_NODES
+#define PDCPP_PROFILE_NODES 64
+#endif
+
+#ifndef PDCPP_PROFILE_DEPTH
+#define PDCPP_PROFILE_DEPTH 16
+#endif
+
+// Frames averaged by the published values, the HUD changes at this pace
+#ifndef PDCPP_PROFILE_PERIOD
+#define PDCPP_PROFILE_PERIOD 10
+#endif
+
+// Scopes listed by the HUD
+#ifndef PDCPP_PROFILE_TOP
+#define PDCPP_PROFILE_TOP 5
+#endif
+
+// Frame time drawn at mid-height of the HUD graph (50 Hz)
+#ifndef PDCPP_PROFILE_TARGET_US
+#define PDCPP_PROFILE_TARGET_US 20000
+#endif
+
+typedef struct
+{
+	const char* name;
+	uint16_t depth;     // 0 for the scopes opened outside any other
+	uint16_t calls;     // per frame, rounded down
+	uint32_t selfUs;    // per frame, children excluded
+	uint32_t totalUs;   // per frame
+} pdcpp_profile_entry_t;
+
+// Non-zero if built with -DPDCPP_PROFILER=ON
+int pdcpp_profile_enabled(void);
+
+// `name` must be a string literal (or outlive the session): told apart by address
+void pdcpp_profile_begin(const char* name);
+// Same node as pdcpp_profile_begin, `text` only goes to the trace (a file name...)
+void pdcpp_profile_begin_text(const char* name, const char* text);
+void pdcpp_profile_end(void);
+
+// Called by playdate_cpp_app.hcpp at the start of every update callback
+void pdcpp_profile_new_frame(void);
+
+// Average frame time of the last published period, 0 before the first one
+uint32_t pdcpp_profile_frame_us(void);
+// Copies up to `max` entries of the last period, most self time first. Returns the count.
+int pdcpp_profile_get(pdcpp_profile_entry_t* entries, int max);
+
+// Draws into the frame buffer with a built-in 3x5 font, x is rounded down to
+// a multiple of 8. Falls back to drawFPS without the profiler.
+void pdcpp_profile_draw_hud(PlaydateAPI* pd, int x, int y);
+
+#ifdef __cplusplus
+}
+
+namespace pdcpp
+{
+    class ProfileScope
+    {
+    public:
+        explicit ProfileScope(const char* name) { pdcpp_profile_begin(name); }
+        ProfileScope(const char* name, const char* text) { pdcpp_profile_begin_text(name, text); }
+        ~ProfileScope() { pdcpp_profile_end(); }
+
+        ProfileScope(const ProfileScope&) = delete;
+        ProfileScope& operator=(const ProfileScope&) = delete;
+    };
+}
+
+#if PDCPP_PROFILER || PDCPP_TRACE
+#define PDCPP_PROFILE_CONCAT_(a, b) a##b
+#define PDCPP_PROFILE_CONCAT(a, b) PDCPP_PROFILE_CONCAT_(a, b)
+#define PDCPP_PROFILE_SCOPE(name) pdcpp::ProfileScope PDCPP_PROFILE_CONCAT(pdcppProfileScope, __LINE__)(name)
+#define PDCPP_PROFILE_SCOPE_TEXT(name, text) pdcpp::ProfileScope PDCPP_PROFILE_CONCAT(pdcppProfileScope, __LINE__)(name, text)
+#else
+#define PDCPP_PROFILE_SCOPE(name) ((void)0)
+#define PDCPP_PROFILE_SCOPE_TEXT(name, text) ((void)0)
+#endif
+
+#endif
+
+// For a span that isn't a block, and for C. Every BEGIN needs its END.
+#if PDCPP_PROFILER || PDCPP_TRACE
+#define PDCPP_PROFILE_BEGIN(name) pdcpp_profile_begin(name)
+#define PDCPP_PROFILE_END() pdcpp_profile_end()
+#else
+#define PDCPP_PROFILE_BEGIN(name) ((void)0)
+#define PDCPP_PROFILE_END() ((void)0)
+#endif
+
+#if PDCPP_PROFILER
+#define PDCPP_PROFILE_HUD(pd, x, y) pdcpp_profile_draw_hud(pd, x, y)
+#else
+#define PDCPP_PROFILE_HUD(pd, x, y) (pd)->system->drawFPS(x, y)
+#endif
+
+#endif
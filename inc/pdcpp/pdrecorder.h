@@ -0,0 +1,57 @@
+#ifndef __PDRECORDER_H
+#define __PDRECORDER_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "pd_api.h"
+
+// Slow-frame flight recorder (src/pdrecorder.c)
+// Always on: keeps the timing markers, allocation counts and input state of the
+// last PDCPP_RECORDER_FRAMES frames in a ring. When a frame takes longer than
+// the budget, the ring is written to the data folder as hitch_<n>.pdfr, which
+// buildsupport/DecodeFlightRecord.cmake turns back into a timeline.
+// playdate_cpp_app.hcpp brackets every update callback; the game only adds
+// markers. Allocation counts need -DPDCPP_ALLOC_TELEMETRY=ON (0 otherwise).
+
+#ifndef PDCPP_RECORDER_FRAMES
+#define PDCPP_RECORDER_FRAMES 64
+#endif
+
+// Markers kept per frame, the extra ones are counted but dropped
+#ifndef PDCPP_RECORDER_MARKERS
+#define PDCPP_RECORDER_MARKERS 8
+#endif
+
+// Distinct marker labels per session
+#ifndef PDCPP_RECORDER_LABELS
+#define PDCPP_RECORDER_LABELS 32
+#endif
+
+// Snapshots kept in the data folder, the oldest ones are overwritten (each
+// session starts again from hitch_00)
+#ifndef PDCPP_RECORDER_FILES
+#define PDCPP_RECORDER_FILES 8
+#endif
+
+// Starts the clock (pdclock.h). A frame over budgetUs is written out, 0 never writes.
+void pdcpp_recorder_init(PlaydateAPI* pd, uint32_t budgetUs);
+void pdcpp_recorder_set_budget(uint32_t budgetUs);
+
+// Update callback brackets, called by playdate_cpp_app.hcpp
+void pdcpp_recorder_begin_frame(void);
+void pdcpp_recorder_end_frame(void);
+
+// Time a step of the frame. `label` must be a string literal (or outlive the
+// session): labels are told apart by address.
+void pdcpp_recorder_mark(const char* label);
+
+// Write the frames completed so far now. Returns 0 on success.
+int pdcpp_recorder_snapshot(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
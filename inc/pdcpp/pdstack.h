@@ -0,0 +1,27 @@
+#ifndef __PDSTACK_H
+#define __PDSTACK_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Stack high-water mark (src/setup.c)
+// With -DPDCPP_STACK_PROBE=ON the device build fills PDCPP_STACK_PAINT_BYTES
+// below the stack pointer of kEventInit with a pattern before the static
+// initializers run, and logs how deep it got on kEventTerminate. Call
+// pdcpp_stack_high_water() after a heavy scene to check the margin left.
+// The build refuses to paint more than the stack size less 8 KB.
+// The build time side is -DPDCPP_STACK_USAGE=ON (see readme.md).
+
+// Deepest stack use since launch in bytes, from the kEventInit stack pointer.
+// -1 if the probe isn't built in (or off device). Reaching
+// pdcpp_stack_painted() means the painted area was overflowed.
+int pdcpp_stack_high_water(void);
+// Size of the painted area, 0 without the probe
+int pdcpp_stack_painted(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,156 @@
+#ifndef __PDTASK_H
+#define __PDTASK_H
+
+// Cooperative tasks on C++20 coroutines (src/pdtask.cpp)
+// A function returning pdcpp::Task runs a little at a time: it gives the CPU
+// back at every `co_await pdcpp::Yield()`, and `co_await pdcpp::NextFrame()`
+// waits for the next update callback. pdcpp::Tasks.Run(budgetUs) resumes the
+// spawned tasks in turn until the budget is spent; playdate_cpp_app.hcpp calls
+// it every frame with PDCPP_TASK_FRAME_BUDGET_US.
+//
+//   pdcpp::Task LoadLevel(Level& level)
+//   {
+//       for (const char* path : level.Paths)
+//       {
+//           level.Load(path);
+//           co_await pdcpp::Yield();
+//       }
+//       level.Ready = true;
+//   }
+//   ...
+//   pdcpp::Tasks.Spawn(LoadLevel(level));
+//
+// A task only gives the CPU back where it yields: the budget is overshot by
+// the longest step. Coroutine frames come from a pool of recycled blocks, not
+// from malloc every time. Main loop only, tasks don't run on another thread.
+
+#include "pdcpp/pdcontainers.h"
+
+#include <coroutine>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#ifndef PDCPP_TASK_FRAME_BUDGET_US
+#define PDCPP_TASK_FRAME_BUDGET_US 4000
+#endif
+
+namespace pdcpp
+{
+    namespace detail
+    {
+        // Power of two size classes up to 4 KB, recycled; larger frames use malloc
+        void* AllocateTaskFrame(size_t size);
+        void FreeTaskFrame(void* frame, size_t size);
+    }
+
+    class Task
+    {
+    public:
+        struct promise_type
+        {
+            // Update callbacks counted by the scheduler, the task sleeps until then
+            uint32_t ResumeFrame = 0;
+
+            Task get_return_object() { return Task(std::coroutine_handle<promise_type>::from_promise(*this)); }
+            static Task get_return_object_on_allocation_failure() { return Task(); }
+
+            // Nothing runs before the scheduler resumes the task the first time
+            std::suspend_always initial_suspend() noexcept { return {}; }
+            std::suspend_always final_suspend() noexcept { return {}; }
+            void return_void() {}
+            void unhandled_exception() { abort(); }
+
+            static void* operator new(size_t size) noexcept { return detail::AllocateTaskFrame(size); }
+            static void operator delete(void* frame, size_t size) { detail::FreeTaskFrame(frame, size); }
+        };
+
+        using Handle = std::coroutine_handle<promise_type>;
+
+        Task() = default;
+        explicit Task(Handle handle) : Coroutine(handle) {}
+        Task(Task&& other) noexcept : Coroutine(other.Release()) {}
+        ~Task() { Reset(); }
+
+        Task& operator=(Task&& other) noexcept
+        {
+            if (this != &other)
+            {
+                Reset();
+                Coroutine = other.Release();
+            }
+            return *this;
+        }
+
+        Task(const Task&) = delete;
+        Task& operator=(const Task&) = delete;
+
+        // False for a moved-from task, or when its frame couldn't be allocated
+        bool Valid() const { return static_cast<bool>(Coroutine); }
+        bool Done() const { return !Coroutine || Coroutine.done(); }
+
+        Handle Release()
+        {
+            Handle handle = Coroutine;
+            Coroutine = nullptr;
+            return handle;
+        }
+
+        void Reset()
+        {
+            if (Coroutine)
+            {
+                Coroutine.destroy();
+                Coroutine = nullptr;
+            }
+        }
+
+    private:
+        Handle Coroutine;
+    };
+
+    class Scheduler
+    {
+    public:
+        ~Scheduler() { Clear(); }
+
+        // Takes the task over, it first runs in the next Run(). Drops the task
+        // if there is no room left to keep it.
+        void Spawn(Task&& task);
+
+        // Resumes the tasks in turn until `budgetUs` is spent (at least one step
+        // if one is runnable). Tasks that finished are destroyed.
+        void Run(uint32_t budgetUs);
+
+        size_t Pending() const { return Running.size(); }
+        uint32_t Frame() const { return FrameCount; }
+
+        // Destroys the unfinished tasks, not from inside one of them
+        void Clear();
+
+    private:
+        SmallVector<Task::Handle, 16> Running;
+        size_t Next = 0;
+        uint32_t FrameCount = 0;
+    };
+
+    inline Scheduler Tasks;
+
+    // Back to the scheduler, resumed in the same Run() if the budget allows
+    struct Yield
+    {
+        bool await_ready() const noexcept { return false; }
+        void await_suspend(std::coroutine_handle<>) const noexcept {}
+        void await_resume() const noexcept {}
+    };
+
+    // Back to the scheduler, resumed in the next frame's Run()
+    struct NextFrame
+    {
+        bool await_ready() const noexcept { return false; }
+        void await_suspend(Task::Handle handle) const noexcept { handle.promise().ResumeFrame = Tasks.Frame() + 1; }
+        void await_resume() const noexcept {}
+    };
+}
+
+#endif
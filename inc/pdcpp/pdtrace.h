@@ -0,0 +1,53 @@
+#ifndef __PDTRACE_H
+#define __PDTRACE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "pd_api.h"
+
+// Trace events for Chrome/Perfetto (src/pdtrace.c)
+// Built with -DPDCPP_TRACE=ON, the begin/end of every PDCPP_PROFILE_SCOPE (see
+// pdprofile.h), of every frame and of the asset loads are stamped into a
+// preallocated buffer. playdate_cpp_app.hcpp writes it to the data folder on
+// kEventTerminate, buildsupport/TraceToJson.cmake converts it to trace_event
+// JSON for chrome://tracing or ui.perfetto.dev. Recording stops when the buffer
+// is full: the file says how many events were dropped.
+
+// 8 bytes each
+#ifndef PDCPP_TRACE_EVENTS
+#define PDCPP_TRACE_EVENTS 8192
+#endif
+
+// Distinct event names per session
+#ifndef PDCPP_TRACE_LABELS
+#define PDCPP_TRACE_LABELS 128
+#endif
+
+#ifndef PDCPP_TRACE_PATH
+#define PDCPP_TRACE_PATH "trace.pdtr"
+#endif
+
+// Non-zero if built with -DPDCPP_TRACE=ON
+int pdcpp_trace_enabled(void);
+// Starts the clock (pdclock.h)
+void pdcpp_trace_init(PlaydateAPI* pd);
+
+// `name` must be a string literal (or outlive the session): told apart by address.
+// `text` is copied (up to 63 characters) and shows in the arguments of the event.
+void pdcpp_trace_begin(const char* name);
+void pdcpp_trace_begin_text(const char* name, const char* text);
+void pdcpp_trace_end(void);
+void pdcpp_trace_instant(const char* name);
+
+// Forget the events so far, to trace only the part that matters
+void pdcpp_trace_clear(void);
+// Write the events so far. Returns 0 on success, -1 on error or without the option.
+int pdcpp_trace_write(const char* path);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
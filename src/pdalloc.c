@@ -0,0 +1,244 @@
+#include "pdcpp/pdalloc.h"
+
+#include <string.h>
+
+#define PAGE_SHIFT 12
+#define PAGE_FREE 0xFF
+
+#if TARGET_PLAYDATE || UINTPTR_MAX == 0xFFFFFFFF
+// 8 bytes alignment is what newlib malloc guarantees on the Cortex-M7
+static const uint16_t s_classSizes[] = {
+	8, 16, 24, 32, 40, 48, 64, 80, 96, 112, 128, 160, 192, 224, 256,
+	320, 384, 448, 512, 640, 768, 896, 1024
+};
+#else
+// 64-bit hosts (simulator) expect 16 bytes aligned blocks
+static const uint16_t s_classSizes[] = {
+	16, 32, 48, 64, 80, 96, 112, 128, 160, 192, 224, 256,
+	320, 384, 448, 512, 640, 768, 896, 1024
+};
+#endif
+#define CLASS_COUNT (sizeof(s_classSizes) / sizeof(s_classSizes[0]))
+
+_Static_assert((1 << PAGE_SHIFT) == PDCPP_POOL_PAGE_SIZE, "PAGE_SHIFT doesn't match PDCPP_POOL_PAGE_SIZE");
+
+typedef struct pool_page
+{
+	struct pool_page* next;   // partial list of its class, or free page list
+	struct pool_page* prev;
+	void* free;               // intrusive list of released blocks
+	uint16_t used;            // live blocks
+	uint16_t carved;          // blocks handed out from the untouched part of the page
+	uint16_t capacity;
+	uint8_t cls;
+} pool_page;
+
+static pdcpp_realloc_t s_system = NULL;
+static uint8_t* s_base = NULL;
+static uint8_t* s_end = NULL;
+static pool_page* s_pages = NULL;
+static pool_page* s_freePages = NULL;
+// Pages of a class with at least one free block
+static pool_page* s_partial[CLASS_COUNT];
+// (size + 7) / 8 -> class index
+static uint8_t s_sizeToClass[(PDCPP_POOL_MAX_BLOCK >> 3) + 1];
+static pdcpp_pool_stats_t s_stats;
+
+static inline void list_push(pool_page** head, pool_page* page)
+{
+	page->prev = NULL;
+	page->next = *head;
+	if (*head) (*head)->prev = page;
+	*head = page;
+}
+
+static inline void list_remove(pool_page** head, pool_page* page)
+{
+	if (page->prev) page->prev->next = page->next;
+	else *head = page->next;
+	if (page->next) page->next->prev = page->prev;
+	page->next = page->prev = NULL;
+}
+
+static inline pool_page* page_of(const void* ptr)
+{
+	return &s_pages[((const uint8_t*)ptr - s_base) >> PAGE_SHIFT];
+}
+
+static inline uint8_t* page_data(const pool_page* page)
+{
+	return s_base + ((size_t)(page - s_pages) << PAGE_SHIFT);
+}
+
+static void* pool_alloc(size_t size)
+{
+	uint8_t cls = s_sizeToClass[(size + 7) >> 3];
+	pool_page* page = s_partial[cls];
+	if (page == NULL)
+	{
+		page = s_freePages;
+		if (page == NULL)
+		{
+			return NULL;
+		}
+		s_freePages = page->next;
+		page->free = NULL;
+		page->used = 0;
+		page->carved = 0;
+		page->capacity = PDCPP_POOL_PAGE_SIZE / s_classSizes[cls];
+		page->cls = cls;
+		list_push(&s_partial[cls], page);
+		++s_stats.pagesUsed;
+	}
+
+	void* block;
+	if (page->free)
+	{
+		block = page->free;
+		page->free = *(void**)block;
+	}
+	else
+	{
+		block = page_data(page) + (size_t)page->carved++ * s_classSizes[cls];
+	}
+
+	if (++page->used == page->capacity)
+	{
+		list_remove(&s_partial[cls], page);
+	}
+	++s_stats.blocksLive;
+	return block;
+}
+
+static void pool_free(void* ptr)
+{
+	pool_page* page = page_of(ptr);
+	*(void**)ptr = page->free;
+	page->free = ptr;
+
+	if (page->used-- == page->capacity)
+	{
+		list_push(&s_partial[page->cls], page);
+	}
+	--s_stats.blocksLive;
+
+	// Give empty pages back to the region, but keep the last one of a class
+	// so a single alloc/free pair doesn't recycle a page every time.
+	if (page->used == 0 && (page->next || page->prev))
+	{
+		list_remove(&s_partial[page->cls], page);
+		page->cls = PAGE_FREE;
+		page->next = s_freePages;
+		s_freePages = page;
+		--s_stats.pagesUsed;
+	}
+}
+
+int pdcpp_pool_owns(const void* ptr)
+{
+	return (const uint8_t*)ptr >= s_base && (const uint8_t*)ptr < s_end;
+}
+
+void* pdcpp_pool_realloc(void* ptr, size_t size)
+{
+	if (ptr == NULL)
+	{
+		if (size <= PDCPP_POOL_MAX_BLOCK)
+		{
+			void* block = pool_alloc(size ? size : 1);
+			if (block)
+			{
+				return block;
+			}
+			++s_stats.fallbackAllocs;
+		}
+		return s_system(NULL, size);
+	}
+
+	// Blocks from before the install, large blocks and fallbacks
+	if (!pdcpp_pool_owns(ptr))
+	{
+		return s_system(ptr, size);
+	}
+
+	if (size == 0)
+	{
+		pool_free(ptr);
+		return NULL;
+	}
+
+	// Stay in place while the block still fits without wasting more than half of it
+	size_t oldSize = s_classSizes[page_of(ptr)->cls];
+	if (size <= oldSize && size > oldSize / 2)
+	{
+		return ptr;
+	}
+
+	void* block = pdcpp_pool_realloc(NULL, size);
+	if (block == NULL)
+	{
+		return NULL;
+	}
+	memcpy(block, ptr, size < oldSize ? size : oldSize);
+	pool_free(ptr);
+	return block;
+}
+
+int pdcpp_pool_install(size_t poolBytes)
+{
+	if (s_base)
+	{
+		return 0;
+	}
+
+	s_system = pdcpp_system_allocator();
+	size_t pageCount = poolBytes >> PAGE_SHIFT;
+	if (s_system == NULL || pageCount == 0)
+	{
+		return -1;
+	}
+
+	s_pages = s_system(NULL, pageCount * sizeof(pool_page));
+	s_base = s_system(NULL, pageCount << PAGE_SHIFT);
+	if (s_pages == NULL || s_base == NULL)
+	{
+		if (s_pages) s_system(s_pages, 0);
+		if (s_base) s_system(s_base, 0);
+		s_pages = NULL;
+		s_base = NULL;
+		return -1;
+	}
+	s_end = s_base + (pageCount << PAGE_SHIFT);
+
+	// Low addresses first
+	s_freePages = NULL;
+	for (size_t i = pageCount; i-- > 0;)
+	{
+		s_pages[i].cls = PAGE_FREE;
+		s_pages[i].prev = NULL;
+		s_pages[i].next = s_freePages;
+		s_freePages = &s_pages[i];
+	}
+
+	uint8_t cls = 0;
+	for (size_t i = 0; i < sizeof(s_sizeToClass); ++i)
+	{
+		while (s_classSizes[cls] < (i << 3))
+		{
+			++cls;
+		}
+		s_sizeToClass[i] = cls;
+	}
+
+	memset(s_partial, 0, sizeof(s_partial));
+	memset(&s_stats, 0, sizeof(s_stats));
+	s_stats.pagesTotal = (uint32_t)pageCount;
+
+	pdcpp_set_allocator(pdcpp_pool_realloc);
+	return 0;
+}
+
+void pdcpp_pool_get_stats(pdcpp_pool_stats_t* stats)
+{
+	*stats = s_stats;
+}
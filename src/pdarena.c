@@ -0,0 +1,84 @@
+#include "pdcpp/pdarena.h"
+#include "pdcpp/pdalloc.h"
+
+static uint8_t* s_base = NULL;
+static size_t s_capacity = 0;
+static size_t s_used = 0;
+static pdcpp_arena_stats_t s_stats;
+
+int pdcpp_arena_init(size_t bytes)
+{
+	if (s_base)
+	{
+		return 0;
+	}
+
+	// Straight from the system allocator, the arena shouldn't eat the pool
+	pdcpp_realloc_t sys = pdcpp_system_allocator();
+	s_base = sys ? sys(NULL, bytes) : NULL;
+	if (s_base == NULL)
+	{
+		return -1;
+	}
+	s_capacity = bytes;
+	s_used = 0;
+	s_stats.capacity = (uint32_t)bytes;
+	s_stats.used = s_stats.peak = s_stats.overflows = 0;
+	return 0;
+}
+
+void pdcpp_arena_shutdown(void)
+{
+	if (s_base)
+	{
+		pdcpp_system_allocator()(s_base, 0);
+	}
+	s_base = NULL;
+	s_capacity = s_used = 0;
+}
+
+void* pdcpp_arena_alloc(size_t size, size_t align)
+{
+	size_t start = (s_used + align - 1) & ~(align - 1);
+	if (start + size > s_capacity)
+	{
+		++s_stats.overflows;
+		return NULL;
+	}
+
+	s_used = start + size;
+	if (s_used > s_stats.peak)
+	{
+		s_stats.peak = (uint32_t)s_used;
+	}
+	return s_base + start;
+}
+
+int pdcpp_arena_owns(const void* ptr)
+{
+	return (const uint8_t*)ptr >= s_base && (const uint8_t*)ptr < s_base + s_capacity;
+}
+
+size_t pdcpp_arena_mark(void)
+{
+	return s_used;
+}
+
+void pdcpp_arena_release(size_t mark)
+{
+	if (mark < s_used)
+	{
+		s_used = mark;
+	}
+}
+
+void pdcpp_arena_reset(void)
+{
+	s_used = 0;
+}
+
+void pdcpp_arena_get_stats(pdcpp_arena_stats_t* stats)
+{
+	*stats = s_stats;
+	stats->used = (uint32_t)s_used;
+}
@@ -0,0 +1,112 @@
+#include "pdcpp/pdclock.h"
+
+#if TARGET_PLAYDATE
+
+// Cortex-M7 debug registers (ARMv7-M architecture reference, C1.6 and C1.8)
+#define DEMCR       (*(volatile uint32_t*)0xE000EDFCu)
+#define DWT_CTRL    (*(volatile uint32_t*)0xE0001000u)
+#define DWT_CYCCNT  (*(volatile uint32_t*)0xE0001004u)
+#define DWT_LAR     (*(volatile uint32_t*)0xE0001FB0u)
+
+#define DEMCR_TRCENA (1u << 24)
+#define DWT_CYCCNTENA 1u
+#define CALIBRATION_MS 10
+
+static PlaydateAPI* s_pd = NULL;
+static uint32_t s_cyclesPerUs = 0;   // 0: no cycle counter, millisecond clock
+static uint32_t s_lastCycles = 0;
+static uint32_t s_pendingCycles = 0; // not converted to microseconds yet
+static uint32_t s_us = 0;
+
+void pdcpp_clock_init(PlaydateAPI* pd)
+{
+	if (s_pd)
+	{
+		return;
+	}
+	s_pd = pd;
+
+	DEMCR |= DEMCR_TRCENA;
+	DWT_LAR = 0xC5ACCE55u;
+	DWT_CTRL |= DWT_CYCCNTENA;
+
+	// Start on a millisecond edge, count the cycles of the next few
+	unsigned int start = pd->system->getCurrentTimeMilliseconds();
+	while (pd->system->getCurrentTimeMilliseconds() == start) {}
+	uint32_t cycles = DWT_CYCCNT;
+	start += 1;
+	while (pd->system->getCurrentTimeMilliseconds() - start < CALIBRATION_MS) {}
+	cycles = DWT_CYCCNT - cycles;
+
+	s_cyclesPerUs = (cycles + CALIBRATION_MS * 500) / (CALIBRATION_MS * 1000);
+	s_lastCycles = DWT_CYCCNT;
+	if (s_cyclesPerUs == 0)
+	{
+		pd->system->logToConsole("pdcpp_clock: no cycle counter, using the millisecond clock");
+	}
+}
+
+uint32_t pdcpp_clock_us(void)
+{
+	if (s_cyclesPerUs == 0)
+	{
+		return s_pd ? s_pd->system->getCurrentTimeMilliseconds() * 1000u : 0;
+	}
+
+	uint32_t now = DWT_CYCCNT;
+	s_pendingCycles += now - s_lastCycles;
+	s_lastCycles = now;
+	s_us += s_pendingCycles / s_cyclesPerUs;
+	s_pendingCycles %= s_cyclesPerUs;
+	return s_us;
+}
+
+uint32_t pdcpp_clock_cycles(void)
+{
+	return s_cyclesPerUs ? DWT_CYCCNT : pdcpp_clock_us();
+}
+
+uint32_t pdcpp_clock_cycles_per_us(void)
+{
+	return s_cyclesPerUs ? s_cyclesPerUs : 1;
+}
+
+#else
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <time.h>
+#endif
+
+static uint64_t os_clock_us(void)
+{
+#ifdef _WIN32
+	LARGE_INTEGER frequency, counter;
+	QueryPerformanceFrequency(&frequency);
+	QueryPerformanceCounter(&counter);
+	return (uint64_t)(counter.QuadPart / frequency.QuadPart) * 1000000u
+		+ (uint64_t)(counter.QuadPart % frequency.QuadPart) * 1000000u / (uint64_t)frequency.QuadPart;
+#else
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000u + (uint64_t)ts.tv_nsec / 1000u;
+#endif
+}
+
+static uint64_t s_start = 0;
+
+void pdcpp_clock_init(PlaydateAPI* pd)
+{
+	if (s_start == 0)
+	{
+		s_start = os_clock_us();
+	}
+}
+
+uint32_t pdcpp_clock_us(void) { return (uint32_t)(os_clock_us() - s_start); }
+uint32_t pdcpp_clock_cycles(void) { return pdcpp_clock_us(); }
+uint32_t pdcpp_clock_cycles_per_us(void) { return 1; }
+
+#endif
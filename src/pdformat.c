@@ -0,0 +1,321 @@
+#include "pdcpp/pdformat.h"
+
+#include <math.h>
+#include <string.h>
+
+#define MAX_DECIMALS 9
+
+static const uint32_t s_pow10[MAX_DECIMALS + 1] = {
+	1u, 10u, 100u, 1000u, 10000u, 100000u, 1000000u, 10000000u, 100000000u, 1000000000u
+};
+
+// Digits of `value` at the end of a 10 chars scratch, returns the first one
+static char* decimal_digits(char* end, uint32_t value)
+{
+	char* out = end;
+	do
+	{
+		*--out = (char)('0' + value % 10);
+		value /= 10;
+	} while (value);
+	return out;
+}
+
+// Converted text of one conversion, before the padding
+typedef struct
+{
+	char sign;                 // '-', '+', ' ' or 0
+	const char* prefix;        // "0x" or ""
+	const char* text;
+	int length;
+	int zeros;                 // inserted before the text (precision of %d)
+	int trailingZeros;         // after the integer digits of a huge float
+	const char* fraction;      // '.' and decimals, or ""
+	int fractionLength;
+	int numeric;               // the '0' flag pads with zeros
+} field_t;
+
+typedef struct
+{
+	char* buffer;
+	int size;
+	int length;
+} writer_t;
+
+static void put(writer_t* w, char c)
+{
+	if (w->length < w->size - 1)
+	{
+		w->buffer[w->length++] = c;
+	}
+}
+
+static void put_text(writer_t* w, const char* text, int length)
+{
+	int room = w->size - 1 - w->length;
+	if (length > room) length = room;
+	if (length > 0)
+	{
+		memcpy(w->buffer + w->length, text, (size_t)length);
+		w->length += length;
+	}
+}
+
+static void put_repeat(writer_t* w, char c, int count)
+{
+	while (count-- > 0) put(w, c);
+}
+
+// Fixed decimals with single precision arithmetic: the integer part, then
+// the fraction (exact, v - trunc(v)) scaled and rounded to nearest, ties to
+// even as printf does. Past 2^32 the value
+// is divided by 10 until it fits, the digits dropped come back as zeros.
+// `scratch` holds 10 integer digits, '.' and MAX_DECIMALS decimals.
+static void convert_float(field_t* field, char* scratch, float value, int decimals)
+{
+	uint32_t bits;
+	memcpy(&bits, &value, sizeof(bits));
+	if (bits >> 31)
+	{
+		field->sign = '-';
+		value = -value;
+	}
+	if ((bits & 0x7F800000u) == 0x7F800000u)
+	{
+		field->text = (bits & 0x007FFFFFu) ? "nan" : "inf";
+		field->length = 3;
+		return;
+	}
+
+	while (value >= 4294967296.0f)
+	{
+		value /= 10.0f;
+		++field->trailingZeros;
+	}
+	uint32_t integer = (uint32_t)value;
+	uint32_t fraction = 0;
+	if (field->trailingZeros == 0)
+	{
+		float part = value - (float)integer;
+		float scaled = part * (float)s_pow10[decimals];
+		fraction = (uint32_t)scaled;
+		float rest = scaled - (float)fraction;
+		// A tie may come from the rounding of the product: its error (exact
+		// with a fused multiply-add) tells on which side the value is
+		float error = rest == 0.5f ? fmaf(part, (float)s_pow10[decimals], -scaled) : 0.0f;
+		uint32_t last = decimals ? fraction : integer;
+		if (rest > 0.5f || (rest == 0.5f && (error > 0.0f || (error == 0.0f && (last & 1)))))
+		{
+			++fraction;
+		}
+		if (fraction >= s_pow10[decimals])
+		{
+			fraction -= s_pow10[decimals];
+			if (++integer == 0)
+			{
+				// 4294967295.5 and up
+				integer = 429496730u;
+				field->trailingZeros = 1;
+			}
+		}
+	}
+
+	field->text = decimal_digits(scratch + 10, integer);
+	field->length = (int)(scratch + 10 - field->text);
+	if (decimals > 0)
+	{
+		char* out = scratch + 10;
+		*out++ = '.';
+		char* last = out + decimals;
+		for (char* digit = last; digit > out; fraction /= 10)
+		{
+			*--digit = (char)('0' + fraction % 10);
+		}
+		field->fraction = scratch + 10;
+		field->fractionLength = decimals + 1;
+	}
+	field->numeric = 1;
+}
+
+static void put_field(writer_t* w, const field_t* field, int width, int left, int zero)
+{
+	int length = (field->sign ? 1 : 0) + (int)strlen(field->prefix) + field->zeros + field->length
+		+ field->trailingZeros + field->fractionLength;
+	int padding = width > length ? width - length : 0;
+
+	if (!left && !(zero && field->numeric)) put_repeat(w, ' ', padding);
+	if (field->sign) put(w, field->sign);
+	put_text(w, field->prefix, (int)strlen(field->prefix));
+	if (!left && zero && field->numeric) put_repeat(w, '0', padding);
+	put_repeat(w, '0', field->zeros);
+	put_text(w, field->text, field->length);
+	put_repeat(w, '0', field->trailingZeros);
+	put_text(w, field->fraction, field->fractionLength);
+	if (left) put_repeat(w, ' ', padding);
+}
+
+int pdcpp_format_args(char* buffer, int size, const char* format, const pdcpp_format_arg_t* args, int count)
+{
+	writer_t w = { buffer, size, 0 };
+	if (size <= 0)
+	{
+		return 0;
+	}
+
+	int arg = 0;
+	const char* c = format;
+	while (*c)
+	{
+		// Plain text up to the next conversion
+		const char* percent = strchr(c, '%');
+		int plain = percent ? (int)(percent - c) : (int)strlen(c);
+		put_text(&w, c, plain);
+		c += plain;
+		if (*c == 0)
+		{
+			break;
+		}
+		if (*++c == '%')
+		{
+			put(&w, '%');
+			++c;
+			continue;
+		}
+
+		int left = 0, plus = 0, space = 0, zero = 0, alternate = 0;
+		for (;; ++c)
+		{
+			if (*c == '-') left = 1;
+			else if (*c == '+') plus = 1;
+			else if (*c == ' ') space = 1;
+			else if (*c == '0') zero = 1;
+			else if (*c == '#') alternate = 1;
+			else break;
+		}
+		int width = 0;
+		while (*c >= '0' && *c <= '9') width = width * 10 + (*c++ - '0');
+		int precision = -1;
+		if (*c == '.')
+		{
+			++c;
+			precision = 0;
+			while (*c >= '0' && *c <= '9') precision = precision * 10 + (*c++ - '0');
+		}
+		while (*c == 'h' || *c == 'l') ++c;
+
+		char conversion = *c;
+		if (conversion == 0)
+		{
+			break;
+		}
+		++c;
+		if (arg == count)
+		{
+			// Not checked (C): the rest as it is, from the '%' of this conversion
+			put_text(&w, percent, (int)strlen(percent));
+			break;
+		}
+		pdcpp_format_arg_t value = args[arg++];
+
+		char scratch[32];
+		field_t field = { 0, "", scratch, 0, 0, 0, "", 0, 0 };
+		switch (conversion)
+		{
+		case 'd':
+		case 'i':
+		{
+			uint32_t magnitude = value.i < 0 ? 0u - (uint32_t)value.i : (uint32_t)value.i;
+			field.sign = value.i < 0 ? '-' : plus ? '+' : space ? ' ' : 0;
+			field.text = decimal_digits(scratch + 10, magnitude);
+			field.length = (int)(scratch + 10 - field.text);
+			field.numeric = 1;
+			break;
+		}
+		case 'u':
+			field.text = decimal_digits(scratch + 10, value.u);
+			field.length = (int)(scratch + 10 - field.text);
+			field.numeric = 1;
+			break;
+		case 'x':
+		case 'X':
+		case 'p':
+		{
+			const char* hex = conversion == 'X' ? "0123456789ABCDEF" : "0123456789abcdef";
+			uint64_t bits = conversion == 'p' ? (uint64_t)(uintptr_t)value.p : value.u;
+			int digits = conversion == 'p' ? (int)sizeof(void*) * 2 : 0;
+			char* out = scratch + 16;
+			do
+			{
+				*--out = hex[bits & 15];
+				bits >>= 4;
+			} while (bits || scratch + 16 - out < digits);
+			field.text = out;
+			field.length = (int)(scratch + 16 - out);
+			field.prefix = (alternate && value.u) || conversion == 'p' ? (conversion == 'X' ? "0X" : "0x") : "";
+			field.numeric = 1;
+			break;
+		}
+		case 'c':
+			scratch[0] = (char)value.i;
+			field.length = 1;
+			break;
+		case 'f':
+		case 'F':
+			convert_float(&field, scratch, value.f, precision < 0 ? 6 : precision > MAX_DECIMALS ? MAX_DECIMALS : precision);
+			if (!field.sign) field.sign = plus ? '+' : space ? ' ' : 0;
+			if (alternate && field.fractionLength == 0 && field.numeric)
+			{
+				field.fraction = ".";
+				field.fractionLength = 1;
+			}
+			precision = -1;
+			break;
+		case 's':
+			field.text = value.s ? value.s : "(null)";
+			field.length = (int)strlen(field.text);
+			if (precision >= 0 && precision < field.length) field.length = precision;
+			precision = -1;
+			break;
+		default:
+			// Unknown: skipped with its argument
+			continue;
+		}
+
+		// Minimum digits of the integers, the '0' flag is then ignored
+		if (precision >= 0 && field.numeric)
+		{
+			field.zeros = precision > field.length ? precision - field.length : 0;
+			if (precision == 0 && field.length == 1 && field.text[0] == '0') field.length = 0;
+			zero = 0;
+		}
+		put_field(&w, &field, width, left, zero);
+	}
+
+	buffer[w.length] = '\0';
+	return w.length;
+}
+
+int pdcpp_format_uint(char* buffer, int size, uint32_t value)
+{
+	pdcpp_format_arg_t arg;
+	arg.u = value;
+	return pdcpp_format_args(buffer, size, "%u", &arg, 1);
+}
+
+int pdcpp_format_int(char* buffer, int size, int32_t value)
+{
+	pdcpp_format_arg_t arg;
+	arg.i = value;
+	return pdcpp_format_args(buffer, size, "%d", &arg, 1);
+}
+
+int pdcpp_format_float(char* buffer, int size, float value, int decimals)
+{
+	char format[8] = "%.0f";
+	pdcpp_format_arg_t arg;
+	arg.f = value;
+	if (decimals < 0) decimals = 0;
+	if (decimals > MAX_DECIMALS) decimals = MAX_DECIMALS;
+	format[2] = (char)('0' + decimals);
+	return pdcpp_format_args(buffer, size, format, &arg, 1);
+}
@@ -0,0 +1,91 @@
+#include "pdcpp/pdlazy.h"
+
+static pdcpp_lazy_node* s_head = NULL;
+static pdcpp_lazy_node* s_tail = NULL;
+// Built nodes, last built first
+static pdcpp_lazy_node* s_built = NULL;
+static int s_pending = 0;
+
+void pdcpp_lazy_schedule(pdcpp_lazy_node* node)
+{
+	if (node->state != PDCPP_LAZY_IDLE)
+	{
+		return;
+	}
+
+	node->state = PDCPP_LAZY_QUEUED;
+	node->next = NULL;
+	if (s_tail) s_tail->next = node;
+	else s_head = node;
+	s_tail = node;
+	++s_pending;
+}
+
+void pdcpp_lazy_run(pdcpp_lazy_node* node)
+{
+	if (node->state == PDCPP_LAZY_READY)
+	{
+		return;
+	}
+
+	// Queued nodes stay linked, pdcpp_lazy_step skips them once built
+	if (node->state == PDCPP_LAZY_QUEUED)
+	{
+		--s_pending;
+	}
+	node->init(node);
+	node->state = PDCPP_LAZY_READY;
+	node->built = s_built;
+	s_built = node;
+}
+
+int pdcpp_lazy_step(PlaydateAPI* pd, unsigned int budgetMs)
+{
+	unsigned int start = pd->system->getCurrentTimeMilliseconds();
+	while (s_head)
+	{
+		pdcpp_lazy_node* node = s_head;
+		s_head = node->next;
+		if (s_head == NULL) s_tail = NULL;
+
+		if (node->state == PDCPP_LAZY_QUEUED)
+		{
+			pdcpp_lazy_run(node);
+			if (pd->system->getCurrentTimeMilliseconds() - start >= budgetMs)
+			{
+				break;
+			}
+		}
+	}
+	return s_pending;
+}
+
+int pdcpp_lazy_pending(void)
+{
+	return s_pending;
+}
+
+void pdcpp_lazy_teardown(void)
+{
+	while (s_built)
+	{
+		pdcpp_lazy_node* node = s_built;
+		s_built = node->built;
+		if (node->destroy)
+		{
+			node->destroy(node);
+		}
+		node->built = NULL;
+		node->state = PDCPP_LAZY_IDLE;
+	}
+	// Nodes still queued were never built
+	while (s_head)
+	{
+		pdcpp_lazy_node* node = s_head;
+		s_head = node->next;
+		node->next = NULL;
+		node->state = PDCPP_LAZY_IDLE;
+	}
+	s_tail = NULL;
+	s_pending = 0;
+}
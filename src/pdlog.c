@@ -0,0 +1,95 @@
+#include "pdcpp/pdlog.h"
+
+#include <string.h>
+
+#if PDCPP_LOG_LEVEL < PDCPP_LOG_LEVEL_OFF
+
+// log.pdlg, little endian, read by `pdlog print` (buildsupport/hosttools):
+// header, then the records of the ring, oldest first
+#define LOG_VERSION 1
+
+typedef struct
+{
+	char magic[4];             // "PDLG"
+	uint16_t version;
+	uint16_t args;             // PDCPP_LOG_ARGS
+	uint32_t recordCount;
+	uint32_t lost;             // overwritten by newer ones
+} log_header_t;
+
+#if (PDCPP_LOG_RECORDS & (PDCPP_LOG_RECORDS - 1)) != 0
+#error PDCPP_LOG_RECORDS must be a power of two
+#endif
+
+pdcpp_log_record_t pdcpp_log_ring[PDCPP_LOG_RECORDS];
+uint32_t pdcpp_log_count = 0;
+
+static PlaydateAPI* s_pd = NULL;
+
+int pdcpp_log_enabled(void) { return 1; }
+
+void pdcpp_log_init(PlaydateAPI* pd)
+{
+	s_pd = pd;
+	pdcpp_clock_init(pd);
+}
+
+void pdcpp_log_clear(void)
+{
+	pdcpp_log_count = 0;
+}
+
+static int write_all(SDFile* file, const void* data, unsigned int size)
+{
+	return s_pd->file->write(file, data, size) == (int)size ? 0 : -1;
+}
+
+int pdcpp_log_write(const char* path)
+{
+	if (s_pd == NULL)
+	{
+		return -1;
+	}
+
+	SDFile* file = s_pd->file->open(path, kFileWrite);
+	if (file == NULL)
+	{
+		s_pd->system->logToConsole("log: can't write %s: %s", path, s_pd->file->geterr());
+		return -1;
+	}
+
+	uint32_t count = pdcpp_log_count < PDCPP_LOG_RECORDS ? pdcpp_log_count : PDCPP_LOG_RECORDS;
+	log_header_t header;
+	memcpy(header.magic, "PDLG", 4);
+	header.version = LOG_VERSION;
+	header.args = PDCPP_LOG_ARGS;
+	header.recordCount = count;
+	header.lost = pdcpp_log_count - count;
+	int result = write_all(file, &header, sizeof(header));
+
+	// The oldest record is the next one to be overwritten
+	uint32_t first = (pdcpp_log_count - count) & (PDCPP_LOG_RECORDS - 1);
+	uint32_t tail = count < PDCPP_LOG_RECORDS - first ? count : PDCPP_LOG_RECORDS - first;
+	if (result == 0 && tail)
+	{
+		result = write_all(file, &pdcpp_log_ring[first], tail * sizeof(pdcpp_log_record_t));
+	}
+	if (result == 0 && count > tail)
+	{
+		result = write_all(file, pdcpp_log_ring, (count - tail) * sizeof(pdcpp_log_record_t));
+	}
+
+	s_pd->file->close(file);
+	s_pd->system->logToConsole("log: %u records written to %s (%u overwritten)",
+		(unsigned int)count, path, (unsigned int)header.lost);
+	return result;
+}
+
+#else
+
+int pdcpp_log_enabled(void) { return 0; }
+void pdcpp_log_init(PlaydateAPI* pd) {}
+void pdcpp_log_clear(void) {}
+int pdcpp_log_write(const char* path) { return -1; }
+
+#endif
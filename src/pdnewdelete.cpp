@@ -1,8 +1,84 @@
 //
 // Created by MrBZapp on 9/9/2023.
 //
-#ifdef TARGET_PLAYDATE
+// The whole replaceable operator new/delete family, on device and simulator.
+// Everything ends up in malloc/free, so the allocator hook of setup.c
+// (pdcpp_set_allocator: pool, telemetry...) sees every C++ allocation too.
+#include <cstdint>
 #include <cstdlib>
-void operator delete(void* obj, unsigned int size) { free(obj); }
-void* operator new(unsigned int size) { return malloc(size); }
+#include <new>
+
+namespace
+{
+    void* allocate(std::size_t size)
+    {
+        // new must return a unique pointer even for 0 bytes
+        return malloc(size ? size : 1);
+    }
+
+    // Over-allocates and keeps the malloc'ed pointer just before the aligned block
+    void* allocate_aligned(std::size_t size, std::align_val_t al)
+    {
+        std::size_t align = static_cast<std::size_t>(al);
+        if (align < sizeof(void*))
+        {
+            align = sizeof(void*);
+        }
+
+        void* raw = malloc(size + align - 1 + sizeof(void*));
+        if (raw == nullptr)
+        {
+            return nullptr;
+        }
+
+        std::uintptr_t aligned = (reinterpret_cast<std::uintptr_t>(raw) + sizeof(void*) + align - 1) & ~(std::uintptr_t)(align - 1);
+        reinterpret_cast<void**>(aligned)[-1] = raw;
+        return reinterpret_cast<void*>(aligned);
+    }
+
+    void release_aligned(void* ptr)
+    {
+        if (ptr)
+        {
+            free(static_cast<void**>(ptr)[-1]);
+        }
+    }
+
+    void* check(void* ptr)
+    {
+        if (ptr == nullptr)
+        {
+#if __cpp_exceptions
+            throw std::bad_alloc();
+#else
+            // Built with -fno-exceptions on device: nothing sensible left to do
+            abort();
 #endif
+        }
+        return ptr;
+    }
+}
+
+void* operator new(std::size_t size) { return check(allocate(size)); }
+void* operator new[](std::size_t size) { return check(allocate(size)); }
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept { return allocate(size); }
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept { return allocate(size); }
+
+void operator delete(void* ptr) noexcept { free(ptr); }
+void operator delete[](void* ptr) noexcept { free(ptr); }
+void operator delete(void* ptr, std::size_t) noexcept { free(ptr); }
+void operator delete[](void* ptr, std::size_t) noexcept { free(ptr); }
+void operator delete(void* ptr, const std::nothrow_t&) noexcept { free(ptr); }
+void operator delete[](void* ptr, const std::nothrow_t&) noexcept { free(ptr); }
+
+void* operator new(std::size_t size, std::align_val_t al) { return check(allocate_aligned(size, al)); }
+void* operator new[](std::size_t size, std::align_val_t al) { return check(allocate_aligned(size, al)); }
+void* operator new(std::size_t size, std::align_val_t al, const std::nothrow_t&) noexcept { return allocate_aligned(size, al); }
+void* operator new[](std::size_t size, std::align_val_t al, const std::nothrow_t&) noexcept { return allocate_aligned(size, al); }
+
+void operator delete(void* ptr, std::align_val_t) noexcept { release_aligned(ptr); }
+void operator delete[](void* ptr, std::align_val_t) noexcept { release_aligned(ptr); }
+void operator delete(void* ptr, std::size_t, std::align_val_t) noexcept { release_aligned(ptr); }
+void operator delete[](void* ptr, std::size_t, std::align_val_t) noexcept { release_aligned(ptr); }
+void operator delete(void* ptr, std::align_val_t, const std::nothrow_t&) noexcept { release_aligned(ptr); }
+void operator delete[](void* ptr, std::align_val_t, const std::nothrow_t&) noexcept { release_aligned(ptr); }
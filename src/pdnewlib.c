@@ -1,8 +1,23 @@
 #include "pd_api.h"
+#include "pdcpp/pdnewlib.h"
+#include "pdcpp/pdalloc.h"
+#include "pdcpp/pdpgo.h"
+
+#if PDCPP_POOL_ALLOCATOR
+static void install_pool(PlaydateAPI* pd)
+{
+	if (pdcpp_pool_install(PDCPP_POOL_SIZE))
+	{
+		pd->system->logToConsole("pdcpp: can't reserve %d bytes for the pool allocator", PDCPP_POOL_SIZE);
+	}
+}
+#endif
 
 #if TARGET_PLAYDATE
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
 #include <sys/stat.h>
 #include <errno.h>
 #ifdef errno
@@ -10,6 +25,10 @@
 #endif
 extern int errno;
 
+#ifndef PDCPP_FILE_BUFFER_SIZE
+#define PDCPP_FILE_BUFFER_SIZE 4096
+#endif
+
 static PlaydateAPI* pd;
 
 static int _is_init = 0;
@@ -17,6 +36,112 @@ static int _is_init = 0;
 __attribute__((constructor))
 static void _init(void) { _is_init = 1; }
 
+// Console output is collected in a fixed ring buffer per stream and logged
+// one line at a time, without allocating.
+#define CONSOLE_BUFFER_SIZE 2048 // power of two
+#define CONSOLE_BUFFER_MASK (CONSOLE_BUFFER_SIZE - 1)
+#define CONSOLE_LINE_MAX 255
+
+typedef struct {
+	char data[CONSOLE_BUFFER_SIZE];
+	uint32_t head; // write position
+	uint32_t tail; // start of the pending line
+	uint32_t scan; // next byte to look at for a newline
+	const char* fmt;
+} console_t;
+
+// stdout, stderr
+static console_t consoles[2] = {{.fmt = NULL}, {.fmt = "\e[0;31m%s\e[0m"}};
+static char console_line[CONSOLE_LINE_MAX + 1];
+static int console_deferred = 0;
+
+// logs [tail, end) and moves tail to end, long lines are split
+static void console_emit(console_t* c, uint32_t end)
+{
+	do
+	{
+		uint32_t len = end - c->tail;
+		if (len > CONSOLE_LINE_MAX) len = CONSOLE_LINE_MAX;
+
+		uint32_t start = c->tail & CONSOLE_BUFFER_MASK;
+		uint32_t first = CONSOLE_BUFFER_SIZE - start;
+		if (first > len) first = len;
+		memcpy(console_line, c->data + start, first);
+		memcpy(console_line + first, c->data, len - first);
+		console_line[len] = 0;
+
+		pd->system->logToConsole(c->fmt ? c->fmt : "%s", console_line);
+		c->tail += len;
+	} while (c->tail != end);
+}
+
+// logs as far as the last newline, and the unfinished line too if `force`
+static void console_flush(console_t* c, int force)
+{
+	for (; c->scan != c->head; ++c->scan)
+	{
+		if (c->data[c->scan & CONSOLE_BUFFER_MASK] == '\n')
+		{
+			console_emit(c, c->scan);
+			c->tail = c->scan + 1;
+		}
+	}
+	if (force && c->tail != c->head)
+	{
+		console_emit(c, c->head);
+	}
+}
+
+static void console_write(console_t* c, const char* data, int size)
+{
+	while (size > 0)
+	{
+		uint32_t space = CONSOLE_BUFFER_SIZE - (c->head - c->tail);
+		if (space == 0)
+		{
+			// Full: log the complete lines, or cut a line longer than the buffer
+			console_flush(c, 0);
+			space = CONSOLE_BUFFER_SIZE - (c->head - c->tail);
+			if (space == 0)
+			{
+				console_flush(c, 1);
+				space = CONSOLE_BUFFER_SIZE;
+			}
+		}
+
+		uint32_t len = (uint32_t)size < space ? (uint32_t)size : space;
+		uint32_t start = c->head & CONSOLE_BUFFER_MASK;
+		uint32_t first = CONSOLE_BUFFER_SIZE - start;
+		if (first > len) first = len;
+		memcpy(c->data + start, data, first);
+		memcpy(c->data, data + first, len - first);
+
+		c->head += len;
+		data += len;
+		size -= len;
+	}
+
+	if (!console_deferred)
+	{
+		console_flush(c, 0);
+	}
+}
+
+void pdcpp_console_set_deferred(int deferred)
+{
+	console_deferred = deferred;
+	if (!deferred)
+	{
+		pdcpp_console_flush();
+	}
+}
+
+void pdcpp_console_flush(void)
+{
+	console_flush(&consoles[0], 0);
+	console_flush(&consoles[1], 0);
+}
+
 int eventHandler_pdnewlib(PlaydateAPI* _pd, PDSystemEvent event, uint32_t arg)
 {
 	if (event == kEventInit)
@@ -26,6 +151,20 @@ int eventHandler_pdnewlib(PlaydateAPI* _pd, PDSystemEvent event, uint32_t arg)
 		{
 			pd->system->error("Error: .init is not implemented.\nIf you are a developer, please ensure that the event handler in setup.c is up-to-date and implements .init_array execution.");
 		}
+#if PDCPP_POOL_ALLOCATOR
+		install_pool(pd);
+#endif
+	}
+	else if (event == kEventTerminate)
+	{
+#if PDCPP_PGO_INSTRUMENT
+		if (pdcpp_pgo_write(pd, PDCPP_PGO_PROFILE_PATH))
+		{
+			pd->system->logToConsole("pdcpp: can't write the function profile %s", PDCPP_PGO_PROFILE_PATH);
+		}
+#endif
+		console_flush(&consoles[0], 1);
+		console_flush(&consoles[1], 1);
 	}
 	return 0;
 }
@@ -41,47 +180,133 @@ int _getpid(void) { return 1; }
 
 #define MAXFILES 32
 #define FILEHANDLEOFF 3
-SDFile* openfiles[MAXFILES];
 
+// Each open file has its own buffer: read-ahead for files opened for reading,
+// write-behind for files opened for writing. Requests bigger than the buffer
+// go straight to pd->file. _fstat reports the buffer size as st_blksize, so
+// newlib's FILE layer reads and writes in chunks of that size.
 typedef struct {
-	char* v;
-	size_t c;
-	const char* fmt;
-} buf_t;
+	SDFile* file;
+	uint8_t* buffer;
+	uint32_t capacity;
+	uint32_t start;   // next unread byte of the buffer (reading)
+	uint32_t end;     // valid bytes (reading), pending bytes (writing)
+	int writing;
+	int position;     // position seen by the caller
+} fdesc_t;
 
-// stdout, stderr
-buf_t iobuffs[2] = {{NULL, 0, NULL}, {NULL, 0, "\e[0;31m%s\e[0m"}};
+static fdesc_t openfiles[MAXFILES];
+static uint32_t file_buffer_size = PDCPP_FILE_BUFFER_SIZE;
 
-static void write_buf(buf_t* wbuf, char* data, int size)
+void pdcpp_file_set_buffer_size(unsigned int bytes)
 {
-	wbuf->v = realloc(wbuf->v, wbuf->c + size + 1);
-	memcpy(wbuf->v + wbuf->c, data, size);
-	wbuf->c += size;
-	wbuf->v[wbuf->c] = 0;
+	file_buffer_size = bytes;
 }
 
-// logs as far as the last newline.
-static void log_buf_to_console(buf_t* buf)
+static fdesc_t* get_fdesc(int handle)
 {
-	char* start = buf->v;
-	while (1)
+	if (handle >= FILEHANDLEOFF && handle < FILEHANDLEOFF + MAXFILES && openfiles[handle - FILEHANDLEOFF].file)
 	{
-		char* end = strchr(start, '\n');
-		if (end == NULL)
+		return &openfiles[handle - FILEHANDLEOFF];
+	}
+	errno = EBADF;
+	return NULL;
+}
+
+static int fdesc_flush(fdesc_t* d)
+{
+	if (d->writing && d->end > 0)
+	{
+		int written = pd->file->write(d->file, d->buffer, d->end);
+		if (written != (int)d->end)
 		{
+			errno = EIO;
+			return -1;
+		}
+		d->end = 0;
+	}
+	return 0;
+}
+
+static int fdesc_read(fdesc_t* d, char* ptr, int len)
+{
+	int total = 0;
+	while (total < len)
+	{
+		uint32_t available = d->end - d->start;
+		if (available > 0)
+		{
+			uint32_t n = (uint32_t)(len - total) < available ? (uint32_t)(len - total) : available;
+			memcpy(ptr + total, d->buffer + d->start, n);
+			d->start += n;
+			total += n;
+			continue;
+		}
+
+		int remaining = len - total;
+		int r;
+		if ((uint32_t)remaining >= d->capacity)
+		{
+			// Big reads don't need the extra copy
+			d->start = d->end = 0;
+			r = pd->file->read(d->file, ptr + total, remaining);
+		}
+		else
+		{
+			r = pd->file->read(d->file, d->buffer, d->capacity);
+		}
+
+		if (r < 0)
+		{
+			if (total == 0)
+			{
+				errno = EIO;
+				return -1;
+			}
 			break;
 		}
-		*end = 0;
-		pd->system->logToConsole(buf->fmt ? buf->fmt : "%s", start);
-		start = end + 1;
+		if (r == 0)
+		{
+			break;
+		}
+
+		if ((uint32_t)remaining >= d->capacity)
+		{
+			total += r;
+		}
+		else
+		{
+			d->start = 0;
+			d->end = r;
+		}
 	}
-	if (start != buf->v)
+	d->position += total;
+	return total;
+}
+
+static int fdesc_write(fdesc_t* d, const char* data, int size)
+{
+	if (d->end + size > d->capacity && fdesc_flush(d))
+	{
+		return -1;
+	}
+
+	if ((uint32_t)size >= d->capacity)
 	{
-		size_t newsize = buf->c + buf->v - start;
-		memcpy(buf->v, start, newsize);
-		buf->c = newsize;
-		buf->v = realloc(buf->v, newsize ? newsize + 1 : 0);
+		int written = pd->file->write(d->file, data, size);
+		if (written < 0)
+		{
+			errno = EIO;
+			return -1;
+		}
+		d->position += written;
+		return written;
 	}
+
+	memcpy(d->buffer + d->end, data, size);
+	d->end += size;
+	d->position += size;
+	return size;
 }
 
 int _wait(int *status) {
@@ -106,50 +331,82 @@ int _write(int handle, char* data, int size)
 	
 	if (handle == HANDLE_STDOUT || handle == HANDLE_STDERR)
 	{
-		buf_t* wbuf = &iobuffs[handle == HANDLE_STDERR];
-		write_buf(wbuf, data, size);
-		log_buf_to_console(wbuf);
+		console_write(&consoles[handle == HANDLE_STDERR], data, size);
 		return size;
 	}
-	else if (handle >= FILEHANDLEOFF && handle < FILEHANDLEOFF + MAXFILES)
+
+	fdesc_t* d = get_fdesc(handle);
+	if (d == NULL)
 	{
-		SDFile* file = openfiles[handle - FILEHANDLEOFF];
-		
-		if (file)
-		{
-			int s = pd->file->write(file, data, size);
-			if (s < 0)
-			{
-				// TODO: errno
-				return -1;
-			}
-			return s;
-		}
+		return -1;
 	}
-	
-	// TODO: errno (no such open file)
-	return -1;	
+	if (!d->writing)
+	{
+		errno = EBADF;
+		return -1;
+	}
+	return fdesc_write(d, data, size);
 }
 
-int _read(int file, char* ptr, int len)
+int _read(int handle, char* ptr, int len)
 {
-	return 0;
+	if (handle == HANDLE_STDIN)
+	{
+		return 0;
+	}
+
+	fdesc_t* d = get_fdesc(handle);
+	if (d == NULL)
+	{
+		return -1;
+	}
+	if (d->writing)
+	{
+		errno = EBADF;
+		return -1;
+	}
+	return fdesc_read(d, ptr, len);
 }
 
 int _open(const char *name, int flags, int mode)
 {
-  	for (size_t i = 0; i < MAXFILES; ++i)
+	// Playdate files are either read (from the data folder first, then the
+	// game pdx), written from scratch, or appended to.
+	FileOptions options;
+	switch (flags & O_ACCMODE)
+	{
+	case O_RDONLY:
+		options = kFileRead | kFileReadData;
+		break;
+	case O_WRONLY:
+		options = (flags & O_APPEND) ? kFileAppend : kFileWrite;
+		break;
+	default:
+		errno = EINVAL;
+		return -1;
+	}
+
+	for (size_t i = 0; i < MAXFILES; ++i)
 	{
-		if (!openfiles[i])
+		fdesc_t* d = &openfiles[i];
+		if (!d->file)
 		{
-			// TODO: convert mode
-			openfiles[i] = pd->file->open(name, mode);
-			if (openfiles[i] == NULL)
+			d->file = pd->file->open(name, options);
+			if (d->file == NULL)
 			{
 				errno = ENOENT;
 				return -1;
 			}
-			
+
+			d->capacity = file_buffer_size;
+			d->buffer = d->capacity ? malloc(d->capacity) : NULL;
+			if (d->buffer == NULL)
+			{
+				d->capacity = 0;
+			}
+			d->start = d->end = 0;
+			d->writing = options != (kFileRead | kFileReadData);
+			d->position = (options == kFileAppend) ? pd->file->tell(d->file) : 0;
 			return FILEHANDLEOFF + i;
 		}
 	}
@@ -158,29 +415,23 @@ int _open(const char *name, int flags, int mode)
 	return -1;
 }
 
-int _close(int file)
+int _close(int handle)
 {
-	if (file >= FILEHANDLEOFF && file < FILEHANDLEOFF + MAXFILES)
+	fdesc_t* d = get_fdesc(handle);
+	if (d == NULL)
 	{
-		file -= FILEHANDLEOFF;
-		SDFile* f = openfiles[file];
-		if (f != NULL)
-		{
-			if (pd->file->close(f))
-			{
-				// TODO: errno
-				return -1;
-			}
-			else
-			{
-				openfiles[file] = NULL;
-				return 0;
-			}
-		}
+		return -1;
 	}
-	
-	// TODO: errno (no such file handle)
-	return -1;
+
+	int result = fdesc_flush(d);
+	if (pd->file->close(d->file))
+	{
+		errno = EIO;
+		result = -1;
+	}
+	free(d->buffer);
+	memset(d, 0, sizeof(*d));
+	return result;
 }
 
 int _mkdir(char* dir)
@@ -214,42 +465,89 @@ int _isatty(int file)
 	return file >= 0 && file <= HANDLE_STDERR;
 }
 
-int _lseek(int file, int pos, int whence) {
-	if (file < FILEHANDLEOFF || file >= MAXFILES + FILEHANDLEOFF)
+int _lseek(int handle, int pos, int whence) {
+	fdesc_t* d = get_fdesc(handle);
+	if (d == NULL)
+	{
+		return -1;
+	}
+
+	if (d->writing)
 	{
-		SDFile* f = openfiles[file - FILEHANDLEOFF];
-		if (f)
+		if (fdesc_flush(d))
 		{
-			if (pd->file->seek(f, pos, whence))
-			{
-				// TODO: errno
-				return -1;
-			}
-			return 0;
+			return -1;
 		}
 	}
-	
-	// TODO: errno (no such file)
-	return -1;
+	else if (whence != SEEK_END)
+	{
+		// Stay in the read-ahead buffer when possible
+		int target = (whence == SEEK_CUR) ? d->position + pos : pos;
+		int bufferStart = d->position - (int)d->start;
+		if (target >= bufferStart && target <= bufferStart + (int)d->end)
+		{
+			d->start = target - bufferStart;
+			d->position = target;
+			return target;
+		}
+		pos = target;
+		whence = SEEK_SET;
+	}
+
+	if (pd->file->seek(d->file, pos, whence))
+	{
+		errno = EINVAL;
+		return -1;
+	}
+	d->start = d->end = 0;
+	d->position = pd->file->tell(d->file);
+	return d->position;
+}
+
+// 1970-01-01 based day count of a civil date
+static int days_from_civil(int y, int m, int d)
+{
+	y -= m <= 2;
+	int era = (y >= 0 ? y : y - 399) / 400;
+	int yoe = y - era * 400;
+	int doy = (153 * (m + (m > 2 ? -3 : 9)) + 2) / 5 + d - 1;
+	int doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+	return era * 146097 + doe - 719468;
 }
 
 int _fstat(int file, struct stat *st) {
-	memset(stat, 0, sizeof(stat));
+	memset(st, 0, sizeof(*st));
 	if (_isatty(file))
 	{
-    	st->st_mode = S_IFCHR;
+		st->st_mode = S_IFCHR;
+		return 0;
 	}
-	else
+
+	fdesc_t* d = get_fdesc(file);
+	if (d == NULL)
 	{
-		// TODO: get filepath and then call _stat(...)
-		errno = ENFILE;
 		return -1;
 	}
-    return 0;
+
+	// No path to stat, ask the file for its size
+	if (fdesc_flush(d))
+	{
+		return -1;
+	}
+	int current = pd->file->tell(d->file);
+	pd->file->seek(d->file, 0, SEEK_END);
+	int size = pd->file->tell(d->file);
+	pd->file->seek(d->file, current, SEEK_SET);
+
+	st->st_mode = S_IFREG;
+	st->st_size = size;
+	st->st_blksize = d->capacity ? d->capacity : 512;
+	st->st_blocks = (size + 511) / 512;
+	return 0;
 }
 
 int _stat(char *file, struct stat *st) {
-	memset(stat, 0, sizeof(stat));
+	memset(st, 0, sizeof(*st));
 	FileStat pdstat;
 	
 	if (pd->file->stat(file, &pdstat))
@@ -260,11 +558,12 @@ int _stat(char *file, struct stat *st) {
 	
 	st->st_mode = pdstat.isdir ? S_IFDIR : S_IFREG;
 	st->st_size = pdstat.size;
-	st->st_blksize = 512;
-	st->st_blocks = (pdstat.size + st->st_blksize - 1) / st->st_blksize;
-	st->st_atime = (0); // TODO
-	st->st_mtime = st->st_atime;
-	st->st_ctime = st->st_ctime;
+	st->st_blksize = file_buffer_size ? file_buffer_size : 512;
+	st->st_blocks = (pdstat.size + 511) / 512;
+	st->st_mtime = (time_t)days_from_civil(pdstat.m_year, pdstat.m_month, pdstat.m_day) * 86400
+		+ pdstat.m_hour * 3600 + pdstat.m_minute * 60 + pdstat.m_second;
+	st->st_atime = st->st_mtime;
+	st->st_ctime = st->st_mtime;
   	return 0;
 }
 
@@ -273,8 +572,19 @@ char **_environ = __env;
 
 #else
 
+// The simulator prints straight to the host stdout
+void pdcpp_console_set_deferred(int deferred) {}
+void pdcpp_console_flush(void) {}
+void pdcpp_file_set_buffer_size(unsigned int bytes) {}
+
 int eventHandler_pdnewlib(PlaydateAPI* p, PDSystemEvent e, uint32_t a)
 {
+#if PDCPP_POOL_ALLOCATOR
+	if (e == kEventInit)
+	{
+		install_pool(p);
+	}
+#endif
 	return 0;
 }
 
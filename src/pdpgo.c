@@ -0,0 +1,119 @@
+#include "pdcpp/pdpgo.h"
+
+#if PDCPP_PGO_INSTRUMENT && TARGET_PLAYDATE
+
+#define NO_INSTRUMENT __attribute__((no_instrument_function))
+
+// Open addressing table of function address -> entry count
+#define PGO_SLOTS_SHIFT 12
+#define PGO_SLOTS (1 << PGO_SLOTS_SHIFT)
+
+typedef struct
+{
+	uintptr_t function;
+	uint32_t count;
+} pgo_slot_t;
+
+static pgo_slot_t s_slots[PGO_SLOTS];
+static uint32_t s_dropped = 0;
+
+NO_INSTRUMENT void __cyg_profile_func_enter(void* function, void* caller)
+{
+	uintptr_t key = (uintptr_t)function;
+	uint32_t index = ((uint32_t)(key >> 1) * 2654435761u) >> (32 - PGO_SLOTS_SHIFT);
+	for (int probe = 0; probe < PGO_SLOTS; ++probe)
+	{
+		pgo_slot_t* slot = &s_slots[index];
+		if (slot->function == key)
+		{
+			++slot->count;
+			return;
+		}
+		if (slot->function == 0)
+		{
+			slot->function = key;
+			slot->count = 1;
+			return;
+		}
+		index = (index + 1) & (PGO_SLOTS - 1);
+	}
+	++s_dropped;
+}
+
+NO_INSTRUMENT void __cyg_profile_func_exit(void* function, void* caller)
+{
+}
+
+NO_INSTRUMENT static char* append_text(char* out, const char* text)
+{
+	while (*text) *out++ = *text++;
+	return out;
+}
+
+NO_INSTRUMENT static char* append_hex(char* out, uint32_t value)
+{
+	static const char digits[] = "0123456789abcdef";
+	*out++ = '0';
+	*out++ = 'x';
+	for (int shift = 28; shift >= 0; shift -= 4)
+	{
+		*out++ = digits[(value >> shift) & 0xF];
+	}
+	return out;
+}
+
+NO_INSTRUMENT static char* append_dec(char* out, uint32_t value)
+{
+	char tmp[10];
+	int len = 0;
+	do
+	{
+		tmp[len++] = (char)('0' + value % 10);
+		value /= 10;
+	} while (value);
+	while (len) *out++ = tmp[--len];
+	return out;
+}
+
+NO_INSTRUMENT int pdcpp_pgo_write(PlaydateAPI* pd, const char* path)
+{
+	SDFile* file = pd->file->open(path, kFileWrite);
+	if (file == NULL)
+	{
+		return -1;
+	}
+
+	// The game is relocated when loaded: the generator matches this symbol
+	// against the ELF to turn runtime addresses back into link addresses.
+	char line[64];
+	char* end = append_text(line, "base pdcpp_pgo_write ");
+	end = append_hex(end, (uint32_t)(uintptr_t)&pdcpp_pgo_write);
+	end = append_text(end, "\ndropped ");
+	end = append_dec(end, s_dropped);
+	*end++ = '\n';
+	int result = pd->file->write(file, line, (unsigned int)(end - line));
+
+	for (int i = 0; i < PGO_SLOTS && result >= 0; ++i)
+	{
+		if (s_slots[i].function)
+		{
+			end = append_hex(line, (uint32_t)s_slots[i].function);
+			*end++ = ' ';
+			end = append_dec(end, s_slots[i].count);
+			*end++ = '\n';
+			result = pd->file->write(file, line, (unsigned int)(end - line));
+		}
+	}
+
+	pd->file->close(file);
+	return result < 0 ? -1 : 0;
+}
+
+#else
+
+int pdcpp_pgo_write(PlaydateAPI* pd, const char* path)
+{
+	return -1;
+}
+
+#endif
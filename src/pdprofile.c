@@ -0,0 +1,376 @@
+#include "pdcpp/pdprofile.h"
+#include "pdcpp/pdclock.h"
+#include "pdcpp/pdformat.h"
+#include "pdcpp/pdtrace.h"
+
+#include <string.h>
+
+#if PDCPP_PROFILER
+
+#define NO_NODE -1
+
+// Scope tree: children of a node are chained by nextSibling, the roots start at s_firstRoot
+typedef struct
+{
+	const char* name;
+	int16_t parent;
+	int16_t firstChild;
+	int16_t nextSibling;
+	uint16_t depth;
+	uint32_t calls;            // summed over the current period
+	uint32_t cycles;
+	uint32_t childCycles;
+} profile_node_t;
+
+typedef struct
+{
+	int16_t node;              // NO_NODE for a scope that didn't fit in the tree
+	uint32_t start;
+} profile_open_t;
+
+static profile_node_t s_nodes[PDCPP_PROFILE_NODES];
+static int s_nodeCount = 0;
+static int16_t s_firstRoot = NO_NODE;
+
+static profile_open_t s_stack[PDCPP_PROFILE_DEPTH];
+static int s_depth = 0;
+static int s_overflow = 0;     // scopes opened past PDCPP_PROFILE_DEPTH
+
+#define FRAME_HISTORY 64
+static uint32_t s_frameUs[FRAME_HISTORY];
+static uint32_t s_frameIndex = 0;
+static uint32_t s_frameStart = 0;
+static uint32_t s_periodFrames = 0;
+static uint32_t s_periodUs = 0;
+
+static pdcpp_profile_entry_t s_published[PDCPP_PROFILE_NODES];
+static int s_publishedCount = 0;
+static uint32_t s_publishedFrameUs = 0;
+
+int pdcpp_profile_enabled(void) { return 1; }
+
+static int16_t find_node(int16_t parent, const char* name)
+{
+	int16_t* link = parent == NO_NODE ? &s_firstRoot : &s_nodes[parent].firstChild;
+	while (*link != NO_NODE)
+	{
+		if (s_nodes[*link].name == name) return *link;
+		link = &s_nodes[*link].nextSibling;
+	}
+
+	if (s_nodeCount == PDCPP_PROFILE_NODES)
+	{
+		return NO_NODE;
+	}
+	int16_t index = (int16_t)s_nodeCount++;
+	profile_node_t* node = &s_nodes[index];
+	memset(node, 0, sizeof(*node));
+	node->name = name;
+	node->parent = parent;
+	node->firstChild = NO_NODE;
+	node->nextSibling = NO_NODE;
+	node->depth = parent == NO_NODE ? 0 : (uint16_t)(s_nodes[parent].depth + 1);
+	*link = index;
+	return index;
+}
+
+static void profile_begin(const char* name)
+{
+	if (s_depth == PDCPP_PROFILE_DEPTH)
+	{
+		++s_overflow;
+		return;
+	}
+
+	int16_t parent = s_depth ? s_stack[s_depth - 1].node : NO_NODE;
+	profile_open_t* open = &s_stack[s_depth++];
+	// Under an untracked scope, everything is untracked
+	open->node = (s_depth > 1 && parent == NO_NODE) ? NO_NODE : find_node(parent, name);
+	open->start = pdcpp_clock_cycles();
+}
+
+static void profile_end(void)
+{
+	uint32_t now = pdcpp_clock_cycles();
+	if (s_overflow)
+	{
+		--s_overflow;
+		return;
+	}
+	if (s_depth == 0)
+	{
+		return;
+	}
+
+	profile_open_t* open = &s_stack[--s_depth];
+	if (open->node == NO_NODE)
+	{
+		return;
+	}
+
+	uint32_t cycles = now - open->start;
+	profile_node_t* node = &s_nodes[open->node];
+	++node->calls;
+	node->cycles += cycles;
+	if (node->parent != NO_NODE)
+	{
+		s_nodes[node->parent].childCycles += cycles;
+	}
+}
+
+static void publish(void)
+{
+	uint32_t divider = s_periodFrames * pdcpp_clock_cycles_per_us();
+	s_publishedCount = 0;
+	for (int i = 0; i < s_nodeCount; ++i)
+	{
+		profile_node_t* node = &s_nodes[i];
+		pdcpp_profile_entry_t entry;
+		entry.name = node->name;
+		entry.depth = node->depth;
+		entry.calls = (uint16_t)(node->calls / s_periodFrames);
+		entry.selfUs = (node->cycles - node->childCycles) / divider;
+		entry.totalUs = node->cycles / divider;
+		node->calls = node->cycles = node->childCycles = 0;
+
+		// Insertion sort, most self time first
+		int slot = s_publishedCount++;
+		while (slot > 0 && s_published[slot - 1].selfUs < entry.selfUs)
+		{
+			s_published[slot] = s_published[slot - 1];
+			--slot;
+		}
+		s_published[slot] = entry;
+	}
+	s_publishedFrameUs = s_periodUs / s_periodFrames;
+	s_periodFrames = 0;
+	s_periodUs = 0;
+}
+
+void pdcpp_profile_new_frame(void)
+{
+	// Scopes left open by the previous frame don't carry over
+	s_depth = 0;
+	s_overflow = 0;
+
+	uint32_t now = pdcpp_clock_us();
+	if (s_frameStart)
+	{
+		uint32_t frameUs = now - s_frameStart;
+		s_frameUs[s_frameIndex++ % FRAME_HISTORY] = frameUs;
+		s_periodUs += frameUs;
+		if (++s_periodFrames == PDCPP_PROFILE_PERIOD)
+		{
+			publish();
+		}
+	}
+	s_frameStart = now;
+}
+
+uint32_t pdcpp_profile_frame_us(void)
+{
+	return s_publishedFrameUs;
+}
+
+int pdcpp_profile_get(pdcpp_profile_entry_t* entries, int max)
+{
+	int count = s_publishedCount < max ? s_publishedCount : max;
+	memcpy(entries, s_published, (size_t)count * sizeof(*entries));
+	return count;
+}
+
+//------------------------------------------------------------------------------
+// HUD: white on black, straight into the frame buffer
+
+#define HUD_WIDTH 128
+#define HUD_LINE 6
+#define HUD_GRAPH_HEIGHT 24
+#define HUD_HEIGHT (2 + HUD_LINE + HUD_GRAPH_HEIGHT + 2 + PDCPP_PROFILE_TOP * HUD_LINE + 1)
+
+// 3x5 glyphs for ' ' to '_', 3 bits per row, top row first
+#define GLYPH(a, b, c, d, e) (uint16_t)(((a) << 12) | ((b) << 9) | ((c) << 6) | ((d) << 3) | (e))
+static const uint16_t s_font[64] =
+{
+	GLYPH(0,0,0,0,0), GLYPH(2,2,2,0,2), GLYPH(5,5,0,0,0), GLYPH(5,7,5,7,5), // space ! " #
+	GLYPH(3,6,2,3,6), GLYPH(5,1,2,4,5), GLYPH(2,5,2,5,3), GLYPH(2,2,0,0,0), // $ % & '
+	GLYPH(1,2,2,2,1), GLYPH(4,2,2,2,4), GLYPH(0,5,2,5,0), GLYPH(0,2,7,2,0), // ( ) * +
+	GLYPH(0,0,0,2,4), GLYPH(0,0,7,0,0), GLYPH(0,0,0,0,2), GLYPH(1,1,2,4,4), // , - . /
+	GLYPH(7,5,5,5,7), GLYPH(2,6,2,2,7), GLYPH(7,1,7,4,7), GLYPH(7,1,3,1,7), // 0 1 2 3
+	GLYPH(5,5,7,1,1), GLYPH(7,4,7,1,7), GLYPH(7,4,7,5,7), GLYPH(7,1,1,2,2), // 4 5 6 7
+	GLYPH(7,5,7,5,7), GLYPH(7,5,7,1,7), GLYPH(0,2,0,2,0), GLYPH(0,2,0,2,4), // 8 9 : ;
+	GLYPH(1,2,4,2,1), GLYPH(0,7,0,7,0), GLYPH(4,2,1,2,4), GLYPH(7,1,2,0,2), // < = > ?
+	GLYPH(2,5,7,4,3), GLYPH(2,5,7,5,5), GLYPH(6,5,6,5,6), GLYPH(3,4,4,4,3), // @ A B C
+	GLYPH(6,5,5,5,6), GLYPH(7,4,6,4,7), GLYPH(7,4,6,4,4), GLYPH(3,4,5,5,3), // D E F G
+	GLYPH(5,5,7,5,5), GLYPH(7,2,2,2,7), GLYPH(1,1,1,5,2), GLYPH(5,5,6,5,5), // H I J K
+	GLYPH(4,4,4,4,7), GLYPH(5,7,7,5,5), GLYPH(6,5,5,5,5), GLYPH(2,5,5,5,2), // L M N O
+	GLYPH(6,5,6,4,4), GLYPH(2,5,5,6,3), GLYPH(6,5,6,5,5), GLYPH(3,4,2,1,6), // P Q R S
+	GLYPH(7,2,2,2,2), GLYPH(5,5,5,5,7), GLYPH(5,5,5,5,2), GLYPH(5,5,7,7,5), // T U V W
+	GLYPH(5,5,2,5,5), GLYPH(5,5,2,2,2), GLYPH(7,1,2,4,7), GLYPH(3,2,2,2,3), // X Y Z [
+	GLYPH(4,4,2,1,1), GLYPH(6,2,2,2,6), GLYPH(2,5,0,0,0), GLYPH(0,0,0,0,7), // \ ] ^ _
+};
+
+static inline void set_pixel(uint8_t* frame, int x, int y)
+{
+	frame[y * LCD_ROWSIZE + (x >> 3)] |= (uint8_t)(0x80 >> (x & 7));
+}
+
+// Returns the x after the text, stops at `right`
+static int draw_text(uint8_t* frame, int x, int y, int right, const char* text)
+{
+	for (; *text && x + 3 <= right; ++text, x += 4)
+	{
+		int c = (unsigned char)*text;
+		if (c >= 'a' && c <= 'z') c -= 'a' - 'A';
+		if (c < ' ' || c > '_') c = '?';
+		uint16_t glyph = s_font[c - ' '];
+		for (int row = 0; row < 5; ++row)
+		{
+			int bits = (glyph >> (12 - row * 3)) & 7;
+			if (bits & 4) set_pixel(frame, x, y + row);
+			if (bits & 2) set_pixel(frame, x + 1, y + row);
+			if (bits & 1) set_pixel(frame, x + 2, y + row);
+		}
+	}
+	return x;
+}
+
+// Milliseconds with one decimal, then `suffix`
+static void format_ms(char* text, int size, uint32_t us, const char* suffix)
+{
+	pdcpp_format_arg_t args[3];
+	args[0].u = us / 1000;
+	args[1].u = us / 100 % 10;
+	args[2].s = suffix;
+	pdcpp_format_args(text, size, "%u.%u%s", args, 3);
+}
+
+static void format_uint(char* text, int size, uint32_t value, const char* suffix)
+{
+	pdcpp_format_arg_t args[2];
+	args[0].u = value;
+	args[1].s = suffix;
+	pdcpp_format_args(text, size, "%u%s", args, 2);
+}
+
+static void draw_text_right(uint8_t* frame, int right, int y, const char* text)
+{
+	draw_text(frame, right - (int)strlen(text) * 4 + 1, y, right + 1, text);
+}
+
+void pdcpp_profile_draw_hud(PlaydateAPI* pd, int x, int y)
+{
+	uint8_t* frame = pd->graphics->getFrame();
+	if (frame == NULL)
+	{
+		return;
+	}
+
+	x &= ~7;
+	if (x < 0) x = 0;
+	if (x > LCD_COLUMNS - HUD_WIDTH) x = LCD_COLUMNS - HUD_WIDTH;
+	if (y < 0) y = 0;
+	if (y > LCD_ROWS - HUD_HEIGHT) y = LCD_ROWS - HUD_HEIGHT;
+
+	for (int row = y; row < y + HUD_HEIGHT; ++row)
+	{
+		memset(frame + row * LCD_ROWSIZE + x / 8, 0, HUD_WIDTH / 8);
+	}
+
+	char text[32];
+	int line = y + 2;
+	int right = x + HUD_WIDTH - 2;
+
+	// Frame time and rate, averaged over the period
+	uint32_t frameUs = s_publishedFrameUs;
+	format_ms(text, sizeof(text), frameUs, " MS");
+	draw_text(frame, x + 2, line, right, text);
+	if (frameUs)
+	{
+		format_uint(text, sizeof(text), (1000000 + frameUs / 2) / frameUs, " FPS");
+		draw_text_right(frame, right, line, text);
+	}
+	line += HUD_LINE + 1;
+
+	// Last frames, oldest on the left, 2 pixels each. Full height is twice the target.
+	int bottom = line + HUD_GRAPH_HEIGHT - 1;
+	for (int i = 0; i < FRAME_HISTORY; ++i)
+	{
+		uint32_t us = s_frameUs[(s_frameIndex + (uint32_t)i) % FRAME_HISTORY];
+		uint32_t height = us * HUD_GRAPH_HEIGHT / (2 * PDCPP_PROFILE_TARGET_US);
+		if (height > HUD_GRAPH_HEIGHT) height = HUD_GRAPH_HEIGHT;
+		for (uint32_t h = 0; h < height; ++h)
+		{
+			set_pixel(frame, x + i * 2, bottom - (int)h);
+			set_pixel(frame, x + i * 2 + 1, bottom - (int)h);
+		}
+	}
+	for (int i = 0; i < HUD_WIDTH; i += 4)
+	{
+		set_pixel(frame, x + i, bottom - HUD_GRAPH_HEIGHT / 2);
+	}
+	line += HUD_GRAPH_HEIGHT + 2;
+
+	// Scopes with the most self time: name (indented by depth), self ms, share of the frame
+	for (int i = 0; i < s_publishedCount && i < PDCPP_PROFILE_TOP; ++i)
+	{
+		const pdcpp_profile_entry_t* entry = &s_published[i];
+		int indent = (entry->depth < 3 ? entry->depth : 3) * 4;
+		draw_text(frame, x + 2 + indent, line, x + 80, entry->name);
+
+		format_ms(text, sizeof(text), entry->selfUs, "");
+		draw_text_right(frame, x + 100, line, text);
+		if (frameUs)
+		{
+			format_uint(text, sizeof(text), entry->selfUs * 100 / frameUs, "%");
+			draw_text_right(frame, right, line, text);
+		}
+		line += HUD_LINE;
+	}
+
+	pd->graphics->markUpdatedRows(y, y + HUD_HEIGHT - 1);
+}
+
+#else
+
+int pdcpp_profile_enabled(void) { return 0; }
+void pdcpp_profile_new_frame(void) {}
+uint32_t pdcpp_profile_frame_us(void) { return 0; }
+int pdcpp_profile_get(pdcpp_profile_entry_t* entries, int max) { return 0; }
+
+void pdcpp_profile_draw_hud(PlaydateAPI* pd, int x, int y)
+{
+	pd->system->drawFPS(x, y);
+}
+
+#endif
+
+// Scopes feed the profiler and the trace (pdtrace.h), either can be built in
+void pdcpp_profile_begin(const char* name)
+{
+#if PDCPP_TRACE
+	pdcpp_trace_begin(name);
+#endif
+#if PDCPP_PROFILER
+	profile_begin(name);
+#endif
+}
+
+void pdcpp_profile_begin_text(const char* name, const char* text)
+{
+#if PDCPP_TRACE
+	pdcpp_trace_begin_text(name, text);
+#endif
+#if PDCPP_PROFILER
+	profile_begin(name);
+#endif
+}
+
+void pdcpp_profile_end(void)
+{
+#if PDCPP_PROFILER
+	profile_end();
+#endif
+#if PDCPP_TRACE
+	pdcpp_trace_end();
+#endif
+}
@@ -0,0 +1,218 @@
+#include "pdcpp/pdrecorder.h"
+#include "pdcpp/pdclock.h"
+#include "pdcpp/pdmemstats.h"
+
+#include <string.h>
+
+// hitch_<n>.pdfr, little endian, read by buildsupport/DecodeFlightRecord.cmake:
+// header, labels (length byte + text each, padded to 4 bytes), frames oldest first
+#define RECORDER_VERSION 1
+
+typedef struct
+{
+	char magic[4];             // "PDFR"
+	uint16_t version;
+	uint16_t frameCount;
+	uint16_t markersPerFrame;
+	uint16_t labelCount;
+	uint32_t budgetUs;
+	uint32_t triggerFrame;     // frame that went over budget
+	uint32_t reserved;
+} recorder_header_t;
+
+typedef struct
+{
+	uint16_t label;            // PDCPP_RECORDER_LABELS when the table was full
+	uint16_t reserved;
+	uint32_t offsetUs;         // from the start of the frame
+} recorder_marker_t;
+
+typedef struct
+{
+	uint32_t frame;
+	uint32_t startUs;
+	uint32_t durationUs;       // update callback only, the gap to the next start is the system's
+	uint32_t allocs;
+	uint32_t frees;
+	uint32_t bytesRequested;
+	uint8_t buttons;
+	uint8_t pushed;
+	uint8_t released;
+	uint8_t markerCount;       // may be more than PDCPP_RECORDER_MARKERS
+	uint16_t crankCentidegrees;
+	uint8_t crankDocked;
+	uint8_t reserved;
+	recorder_marker_t markers[PDCPP_RECORDER_MARKERS];
+} recorder_frame_t;
+
+static PlaydateAPI* s_pd = NULL;
+static uint32_t s_budgetUs = 0;
+static recorder_frame_t s_frames[PDCPP_RECORDER_FRAMES];
+static uint32_t s_frameCount = 0;      // frames recorded since launch
+static recorder_frame_t* s_current = NULL;
+static const char* s_labels[PDCPP_RECORDER_LABELS];
+static uint16_t s_labelCount = 0;
+static uint32_t s_cooldown = 0;        // frames before the next snapshot
+static int s_nextFile = 0;
+
+void pdcpp_recorder_init(PlaydateAPI* pd, uint32_t budgetUs)
+{
+	s_pd = pd;
+	s_budgetUs = budgetUs;
+	pdcpp_clock_init(pd);
+}
+
+void pdcpp_recorder_set_budget(uint32_t budgetUs)
+{
+	s_budgetUs = budgetUs;
+}
+
+void pdcpp_recorder_begin_frame(void)
+{
+	if (s_pd == NULL)
+	{
+		return;
+	}
+
+	recorder_frame_t* frame = &s_frames[s_frameCount % PDCPP_RECORDER_FRAMES];
+	memset(frame, 0, sizeof(*frame));
+	frame->frame = s_frameCount;
+
+	PDButtons buttons, pushed, released;
+	s_pd->system->getButtonState(&buttons, &pushed, &released);
+	frame->buttons = (uint8_t)buttons;
+	frame->pushed = (uint8_t)pushed;
+	frame->released = (uint8_t)released;
+	frame->crankCentidegrees = (uint16_t)(s_pd->system->getCrankAngle() * 100.0f);
+	frame->crankDocked = (uint8_t)s_pd->system->isCrankDocked();
+
+	s_current = frame;
+	frame->startUs = pdcpp_clock_us();
+}
+
+static uint16_t label_index(const char* label)
+{
+	for (uint16_t i = 0; i < s_labelCount; ++i)
+	{
+		if (s_labels[i] == label) return i;
+	}
+	if (s_labelCount == PDCPP_RECORDER_LABELS)
+	{
+		return PDCPP_RECORDER_LABELS;
+	}
+	s_labels[s_labelCount] = label;
+	return s_labelCount++;
+}
+
+void pdcpp_recorder_mark(const char* label)
+{
+	recorder_frame_t* frame = s_current;
+	if (frame == NULL)
+	{
+		return;
+	}
+
+	if (frame->markerCount < PDCPP_RECORDER_MARKERS)
+	{
+		recorder_marker_t* marker = &frame->markers[frame->markerCount];
+		marker->label = label_index(label);
+		marker->offsetUs = pdcpp_clock_us() - frame->startUs;
+	}
+	if (frame->markerCount < 255) ++frame->markerCount;
+}
+
+void pdcpp_recorder_end_frame(void)
+{
+	recorder_frame_t* frame = s_current;
+	if (frame == NULL)
+	{
+		return;
+	}
+	frame->durationUs = pdcpp_clock_us() - frame->startUs;
+
+	pdcpp_memstats_t stats;
+	pdcpp_memstats_get(&stats);
+	frame->allocs = stats.frame.allocs + stats.frame.reallocs;
+	frame->frees = stats.frame.frees;
+	frame->bytesRequested = stats.frame.bytesRequested;
+
+	s_current = NULL;
+	++s_frameCount;
+
+	if (s_cooldown > 0)
+	{
+		--s_cooldown;
+	}
+	else if (s_budgetUs && frame->durationUs > s_budgetUs)
+	{
+		pdcpp_recorder_snapshot();
+	}
+}
+
+static int write_all(SDFile* file, const void* data, unsigned int size)
+{
+	return s_pd->file->write(file, data, size) == (int)size ? 0 : -1;
+}
+
+int pdcpp_recorder_snapshot(void)
+{
+	if (s_pd == NULL || s_frameCount == 0)
+	{
+		return -1;
+	}
+
+	// The next snapshot gets a whole new ring, writing takes a while
+	s_cooldown = PDCPP_RECORDER_FRAMES;
+
+	char path[] = "hitch_00.pdfr";
+	path[6] = (char)('0' + s_nextFile / 10 % 10);
+	path[7] = (char)('0' + s_nextFile % 10);
+	s_nextFile = (s_nextFile + 1) % PDCPP_RECORDER_FILES;
+
+	SDFile* file = s_pd->file->open(path, kFileWrite);
+	if (file == NULL)
+	{
+		s_pd->system->logToConsole("recorder: can't write %s: %s", path, s_pd->file->geterr());
+		return -1;
+	}
+
+	uint32_t count = s_frameCount < PDCPP_RECORDER_FRAMES ? s_frameCount : PDCPP_RECORDER_FRAMES;
+	uint32_t oldest = s_frameCount - count;
+
+	recorder_header_t header;
+	memcpy(header.magic, "PDFR", 4);
+	header.version = RECORDER_VERSION;
+	header.frameCount = (uint16_t)count;
+	header.markersPerFrame = PDCPP_RECORDER_MARKERS;
+	header.labelCount = s_labelCount;
+	header.budgetUs = s_budgetUs;
+	header.triggerFrame = s_frameCount - 1;
+	header.reserved = 0;
+	int result = write_all(file, &header, sizeof(header));
+
+	uint32_t labelBytes = 0;
+	for (uint16_t i = 0; i < s_labelCount && result == 0; ++i)
+	{
+		size_t length = strlen(s_labels[i]);
+		uint8_t size = (uint8_t)(length < 255 ? length : 255);
+		result = write_all(file, &size, 1);
+		if (result == 0) result = write_all(file, s_labels[i], size);
+		labelBytes += 1u + size;
+	}
+	static const uint8_t padding[3] = { 0, 0, 0 };
+	if (result == 0 && (labelBytes & 3))
+	{
+		result = write_all(file, padding, 4 - (labelBytes & 3));
+	}
+
+	// The ring wraps at most once
+	uint32_t first = oldest % PDCPP_RECORDER_FRAMES;
+	uint32_t run = count < PDCPP_RECORDER_FRAMES - first ? count : PDCPP_RECORDER_FRAMES - first;
+	if (result == 0) result = write_all(file, &s_frames[first], run * sizeof(recorder_frame_t));
+	if (result == 0 && run < count) result = write_all(file, &s_frames[0], (count - run) * sizeof(recorder_frame_t));
+
+	s_pd->file->close(file);
+	s_pd->system->logToConsole("recorder: frame %u over budget, %u frames written to %s",
+		(unsigned int)header.triggerFrame, (unsigned int)count, path);
+	return result;
+}
@@ -0,0 +1,143 @@
+// Coroutine frames pool and round-robin scheduler of pdcpp/pdtask.h
+#include "pdcpp/pdtask.h"
+#include "pdcpp/pdclock.h"
+
+#include <cstdlib>
+
+namespace
+{
+    // 64, 128 ... 4096 bytes
+    constexpr size_t kMinShift = 6;
+    constexpr size_t kClassCount = 7;
+    constexpr size_t kMaxFrame = size_t(1) << (kMinShift + kClassCount - 1);
+
+    struct FreeFrame
+    {
+        FreeFrame* Next;
+    };
+
+    // Released frames are kept for the next task of their class: loading and
+    // streaming tasks come and go with the same few sizes
+    FreeFrame* sFreeFrames[kClassCount];
+
+    size_t classOf(size_t size)
+    {
+        size_t cls = 0;
+        while ((size_t(1) << (kMinShift + cls)) < size)
+        {
+            ++cls;
+        }
+        return cls;
+    }
+
+    // Frame counts wrap, compared as a signed distance
+    bool isRunnable(pdcpp::Task::Handle handle, uint32_t frame)
+    {
+        return static_cast<int32_t>(frame - handle.promise().ResumeFrame) >= 0;
+    }
+}
+
+void* pdcpp::detail::AllocateTaskFrame(size_t size)
+{
+    if (size > kMaxFrame)
+    {
+        return malloc(size);
+    }
+
+    size_t cls = classOf(size);
+    if (FreeFrame* frame = sFreeFrames[cls])
+    {
+        sFreeFrames[cls] = frame->Next;
+        return frame;
+    }
+    return malloc(size_t(1) << (kMinShift + cls));
+}
+
+void pdcpp::detail::FreeTaskFrame(void* frame, size_t size)
+{
+    if (frame == nullptr)
+    {
+        return;
+    }
+    if (size > kMaxFrame)
+    {
+        free(frame);
+        return;
+    }
+
+    size_t cls = classOf(size);
+    auto* block = static_cast<FreeFrame*>(frame);
+    block->Next = sFreeFrames[cls];
+    sFreeFrames[cls] = block;
+}
+
+void pdcpp::Scheduler::Spawn(Task&& task)
+{
+    if (!task.Valid())
+    {
+        return;
+    }
+
+    Task::Handle handle = task.Release();
+    handle.promise().ResumeFrame = FrameCount + 1;
+    if (!Running.push_back(handle))
+    {
+        handle.destroy();
+    }
+}
+
+void pdcpp::Scheduler::Run(uint32_t budgetUs)
+{
+    ++FrameCount;
+    if (Running.empty())
+    {
+        return;
+    }
+
+    uint32_t start = pdcpp_clock_us();
+    // Tasks looked at without finding one to resume: all asleep when it reaches the count
+    size_t skipped = 0;
+    while (!Running.empty() && skipped < Running.size())
+    {
+        if (Next >= Running.size())
+        {
+            Next = 0;
+        }
+
+        // Copied: a task spawning another one may move the array
+        Task::Handle handle = Running[Next];
+        if (!isRunnable(handle, FrameCount))
+        {
+            ++Next;
+            ++skipped;
+            continue;
+        }
+        skipped = 0;
+
+        handle.resume();
+        if (handle.done())
+        {
+            handle.destroy();
+            Running.erase(Running.begin() + Next);
+        }
+        else
+        {
+            ++Next;
+        }
+
+        if (pdcpp_clock_us() - start >= budgetUs)
+        {
+            break;
+        }
+    }
+}
+
+void pdcpp::Scheduler::Clear()
+{
+    for (Task::Handle handle : Running)
+    {
+        handle.destroy();
+    }
+    Running.clear();
+    Next = 0;
+}
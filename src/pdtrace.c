@@ -0,0 +1,234 @@
+#include "pdcpp/pdtrace.h"
+#include "pdcpp/pdclock.h"
+
+#include <string.h>
+
+#if PDCPP_TRACE
+
+// trace.pdtr, little endian, read by buildsupport/TraceToJson.cmake: header,
+// names (length byte + text each, padded to 4 bytes), events
+#define TRACE_VERSION 1
+
+typedef enum
+{
+	TRACE_BEGIN,
+	TRACE_END,
+	TRACE_INSTANT,
+	TRACE_BEGIN_TEXT           // followed by `chunks` events worth of text
+} trace_type_t;
+
+typedef struct
+{
+	char magic[4];             // "PDTR"
+	uint16_t version;
+	uint16_t labelCount;
+	uint32_t eventCount;
+	uint32_t dropped;
+} trace_header_t;
+
+typedef struct
+{
+	uint32_t us;
+	uint16_t label;            // TRACE_NO_LABEL for ends and when the table is full
+	uint8_t type;
+	uint8_t chunks;
+} trace_event_t;
+
+#define TRACE_NO_LABEL 0xFFFF
+#define TRACE_TEXT_CHUNKS 8
+
+// Name address -> label, open addressing
+#define LABEL_SLOTS_SHIFT 8
+#define LABEL_SLOTS (1 << LABEL_SLOTS_SHIFT)
+
+#if PDCPP_TRACE_LABELS * 2 > LABEL_SLOTS
+#error PDCPP_TRACE_LABELS is too large for the label table
+#endif
+
+static PlaydateAPI* s_pd = NULL;
+static trace_event_t s_events[PDCPP_TRACE_EVENTS];
+static uint32_t s_count = 0;
+static uint32_t s_dropped = 0;
+// Open scopes whose BEGIN was dropped: their END is dropped too
+static uint32_t s_droppedDepth = 0;
+static const char* s_labels[PDCPP_TRACE_LABELS];
+static uint16_t s_labelCount = 0;
+static const char* s_slotName[LABEL_SLOTS];
+static uint16_t s_slotLabel[LABEL_SLOTS];
+
+int pdcpp_trace_enabled(void) { return 1; }
+
+void pdcpp_trace_init(PlaydateAPI* pd)
+{
+	s_pd = pd;
+	pdcpp_clock_init(pd);
+}
+
+static uint16_t label_index(const char* name)
+{
+	uint32_t slot = ((uint32_t)((uintptr_t)name >> 2) * 2654435761u) >> (32 - LABEL_SLOTS_SHIFT);
+	while (s_slotName[slot])
+	{
+		if (s_slotName[slot] == name) return s_slotLabel[slot];
+		slot = (slot + 1) & (LABEL_SLOTS - 1);
+	}
+
+	if (s_labelCount == PDCPP_TRACE_LABELS)
+	{
+		return TRACE_NO_LABEL;
+	}
+	s_slotName[slot] = name;
+	s_slotLabel[slot] = s_labelCount;
+	s_labels[s_labelCount] = name;
+	return s_labelCount++;
+}
+
+static trace_event_t* push(trace_type_t type, uint16_t label, uint32_t chunks)
+{
+	if (s_count + 1 + chunks > PDCPP_TRACE_EVENTS)
+	{
+		++s_dropped;
+		return NULL;
+	}
+	trace_event_t* event = &s_events[s_count];
+	s_count += 1 + chunks;
+	event->us = pdcpp_clock_us();
+	event->label = label;
+	event->type = (uint8_t)type;
+	event->chunks = (uint8_t)chunks;
+	return event;
+}
+
+// A BEGIN_TEXT can be dropped while a smaller event still fits: once a scope is
+// dropped, everything opened inside it is dropped as well so that every END
+// recorded closes a recorded BEGIN
+static trace_event_t* push_begin(trace_type_t type, uint16_t label, uint32_t chunks)
+{
+	trace_event_t* event = NULL;
+	if (s_droppedDepth == 0)
+	{
+		event = push(type, label, chunks);
+	}
+	else
+	{
+		++s_dropped;
+	}
+	if (!event)
+	{
+		++s_droppedDepth;
+	}
+	return event;
+}
+
+void pdcpp_trace_begin(const char* name)
+{
+	push_begin(TRACE_BEGIN, label_index(name), 0);
+}
+
+void pdcpp_trace_begin_text(const char* name, const char* text)
+{
+	size_t length = strlen(text);
+	if (length > TRACE_TEXT_CHUNKS * sizeof(trace_event_t) - 1)
+	{
+		// Keep the end, file names differ there
+		text += length - (TRACE_TEXT_CHUNKS * sizeof(trace_event_t) - 1);
+		length = TRACE_TEXT_CHUNKS * sizeof(trace_event_t) - 1;
+	}
+	uint32_t chunks = (uint32_t)(length + sizeof(trace_event_t)) / sizeof(trace_event_t);
+
+	trace_event_t* event = push_begin(TRACE_BEGIN_TEXT, label_index(name), chunks);
+	if (event)
+	{
+		char* out = (char*)(event + 1);
+		memset(out, 0, chunks * sizeof(trace_event_t));
+		memcpy(out, text, length);
+	}
+}
+
+void pdcpp_trace_end(void)
+{
+	if (s_droppedDepth > 0)
+	{
+		--s_droppedDepth;
+		++s_dropped;
+		return;
+	}
+	push(TRACE_END, TRACE_NO_LABEL, 0);
+}
+
+void pdcpp_trace_instant(const char* name)
+{
+	push(TRACE_INSTANT, label_index(name), 0);
+}
+
+void pdcpp_trace_clear(void)
+{
+	s_count = 0;
+	s_dropped = 0;
+	s_droppedDepth = 0;
+}
+
+static int write_all(SDFile* file, const void* data, unsigned int size)
+{
+	return s_pd->file->write(file, data, size) == (int)size ? 0 : -1;
+}
+
+int pdcpp_trace_write(const char* path)
+{
+	if (s_pd == NULL)
+	{
+		return -1;
+	}
+
+	SDFile* file = s_pd->file->open(path, kFileWrite);
+	if (file == NULL)
+	{
+		s_pd->system->logToConsole("trace: can't write %s: %s", path, s_pd->file->geterr());
+		return -1;
+	}
+
+	trace_header_t header;
+	memcpy(header.magic, "PDTR", 4);
+	header.version = TRACE_VERSION;
+	header.labelCount = s_labelCount;
+	header.eventCount = s_count;
+	header.dropped = s_dropped;
+	int result = write_all(file, &header, sizeof(header));
+
+	uint32_t labelBytes = 0;
+	for (uint16_t i = 0; i < s_labelCount && result == 0; ++i)
+	{
+		size_t length = strlen(s_labels[i]);
+		uint8_t size = (uint8_t)(length < 255 ? length : 255);
+		result = write_all(file, &size, 1);
+		if (result == 0) result = write_all(file, s_labels[i], size);
+		labelBytes += 1u + size;
+	}
+	static const uint8_t padding[3] = { 0, 0, 0 };
+	if (result == 0 && (labelBytes & 3))
+	{
+		result = write_all(file, padding, 4 - (labelBytes & 3));
+	}
+	if (result == 0 && s_count)
+	{
+		result = write_all(file, s_events, s_count * sizeof(trace_event_t));
+	}
+
+	s_pd->file->close(file);
+	s_pd->system->logToConsole("trace: %u events written to %s (%u dropped)",
+		(unsigned int)s_count, path, (unsigned int)s_dropped);
+	return result;
+}
+
+#else
+
+int pdcpp_trace_enabled(void) { return 0; }
+void pdcpp_trace_init(PlaydateAPI* pd) {}
+void pdcpp_trace_begin(const char* name) {}
+void pdcpp_trace_begin_text(const char* name, const char* text) {}
+void pdcpp_trace_end(void) {}
+void pdcpp_trace_instant(const char* name) {}
+void pdcpp_trace_clear(void) {}
+int pdcpp_trace_write(const char* path) { return -1; }
+
+#endif
@@ -3,12 +3,129 @@
 //
 
 #include "pd_api.h"
+#include "pdcpp/pdalloc.h"
+#include "pdcpp/pdmemstats.h"
+#include "pdcpp/pdstack.h"
+#include <string.h>
 
 typedef int (PDEventHandler)(PlaydateAPI* playdate, PDSystemEvent event, uint32_t arg);
 
 extern PDEventHandler eventHandler;
 
+// System allocator, and the one behind malloc/realloc/free (see pdcpp_set_allocator)
 static void* (*pdrealloc)(void* ptr, size_t size);
+static void* (*pdallocator)(void* ptr, size_t size);
+
+pdcpp_realloc_t pdcpp_set_allocator(pdcpp_realloc_t allocator)
+{
+    pdcpp_realloc_t previous = pdallocator;
+    pdallocator = allocator ? allocator : pdrealloc;
+    return previous;
+}
+
+pdcpp_realloc_t pdcpp_system_allocator(void)
+{
+    return pdrealloc;
+}
+
+// The host build leaves malloc to the C library (end of this file): there is
+// nothing to count, memstats reports disabled
+#if PDCPP_ALLOC_TELEMETRY && !PDCPP_HOST_BUILD
+
+// Requested size stored in front of every block, keeps the malloc alignment
+#define ALLOC_HEADER_SIZE (sizeof(void*) == 4 ? 8 : 16)
+
+static pdcpp_memstats_t memstats;
+
+static void count_request(pdcpp_memstats_counters_t* counters, size_t size)
+{
+    int bucket = 0;
+    size_t limit = 8;
+    while (size > limit && bucket < PDCPP_MEMSTATS_BUCKETS - 1)
+    {
+        limit <<= 1;
+        ++bucket;
+    }
+    counters->bytesRequested += (uint32_t)size;
+    ++counters->histogram[bucket];
+}
+
+static void* tracked_realloc(void* ptr, size_t size)
+{
+    uint8_t* block = NULL;
+    size_t oldSize = 0;
+    if (ptr)
+    {
+        block = (uint8_t*)ptr - ALLOC_HEADER_SIZE;
+        oldSize = *(size_t*)block;
+    }
+
+    if (size == 0)
+    {
+        if (block)
+        {
+            ++memstats.frame.frees;
+            ++memstats.total.frees;
+            memstats.liveBytes -= (uint32_t)oldSize;
+            --memstats.liveBlocks;
+            pdallocator(block, 0);
+        }
+        return NULL;
+    }
+
+    uint8_t* result = pdallocator(block, size + ALLOC_HEADER_SIZE);
+    if (result == NULL)
+    {
+        return NULL;
+    }
+    *(size_t*)result = size;
+
+    if (block)
+    {
+        ++memstats.frame.reallocs;
+        ++memstats.total.reallocs;
+    }
+    else
+    {
+        ++memstats.frame.allocs;
+        ++memstats.total.allocs;
+        ++memstats.liveBlocks;
+    }
+    count_request(&memstats.frame, size);
+    count_request(&memstats.total, size);
+
+    memstats.liveBytes += (uint32_t)size - (uint32_t)oldSize;
+    if (memstats.liveBytes > memstats.peakBytes) memstats.peakBytes = memstats.liveBytes;
+    if (memstats.liveBytes > memstats.framePeakBytes) memstats.framePeakBytes = memstats.liveBytes;
+
+    return result + ALLOC_HEADER_SIZE;
+}
+
+#define shim_realloc(ptr, size) tracked_realloc(ptr, size)
+
+int pdcpp_memstats_enabled(void) { return 1; }
+
+void pdcpp_memstats_get(pdcpp_memstats_t* stats) { *stats = memstats; }
+
+void pdcpp_memstats_new_frame(void)
+{
+    memstats.lastFrame = memstats.frame;
+    memset(&memstats.frame, 0, sizeof(memstats.frame));
+    memstats.framePeakBytes = memstats.liveBytes;
+}
+
+void pdcpp_memstats_reset_peak(void) { memstats.peakBytes = memstats.liveBytes; }
+
+#else
+
+#define shim_realloc(ptr, size) pdallocator(ptr, size)
+
+int pdcpp_memstats_enabled(void) { return 0; }
+void pdcpp_memstats_get(pdcpp_memstats_t* stats) { memset(stats, 0, sizeof(*stats)); }
+void pdcpp_memstats_new_frame(void) {}
+void pdcpp_memstats_reset_peak(void) {}
+
+#endif
 
 #if TARGET_PLAYDATE
 
@@ -16,11 +133,135 @@ typedef const void(*init_routine_t)(void);
 extern init_routine_t __preinit_array_start, __preinit_array_end, __init_array_start, __init_array_end, __fini_array_start, __fini_array_end;
 static PlaydateAPI* pd;
 
+#if PDCPP_INIT_PROFILE
+
+int eventHandlerShim(PlaydateAPI* playdate, PDSystemEvent event, uint32_t arg);
+
+// Times every static initializer and logs the slowest ones once they all ran.
+// Uses the elapsed time timer, which the application resets in its own init anyway.
+#define INIT_PROFILE_SLOTS 8
+
+typedef struct
+{
+    init_routine_t routine;
+    float seconds;
+} init_timing_t;
+
+static init_timing_t init_slowest[INIT_PROFILE_SLOTS];
+static int init_count;
+static float init_seconds;
+
+static void profile_routine(init_routine_t routine)
+{
+    pd->system->resetElapsedTime();
+    routine();
+    float seconds = pd->system->getElapsedTime();
+
+    ++init_count;
+    init_seconds += seconds;
+
+    // Keep the table sorted, slowest first
+    int slot = INIT_PROFILE_SLOTS;
+    while (slot > 0 && (init_slowest[slot - 1].routine == NULL || init_slowest[slot - 1].seconds < seconds))
+    {
+        if (slot < INIT_PROFILE_SLOTS) init_slowest[slot] = init_slowest[slot - 1];
+        --slot;
+    }
+    if (slot < INIT_PROFILE_SLOTS)
+    {
+        init_slowest[slot].routine = routine;
+        init_slowest[slot].seconds = seconds;
+    }
+}
+
+static void report_init_profile(void)
+{
+    // Addresses are relocated: subtract the shim address and look them up in game.map
+    pd->system->logToConsole("static init: %d routines in %d us (eventHandlerShim at 0x%08x)",
+        init_count, (int)(init_seconds * 1000000.0f), (unsigned int)(uintptr_t)&eventHandlerShim);
+    for (int i = 0; i < INIT_PROFILE_SLOTS && init_slowest[i].routine; ++i)
+    {
+        pd->system->logToConsole("  0x%08x %6d us", (unsigned int)(uintptr_t)init_slowest[i].routine,
+            (int)(init_slowest[i].seconds * 1000000.0f));
+    }
+}
+
+#define run_init_routine(routine) profile_routine(routine)
+
+#else
+
+#define run_init_routine(routine) (routine)()
+
+#endif
+
+#if PDCPP_STACK_PROBE
+
+#ifndef PDCPP_STACK_PAINT_BYTES
+#define PDCPP_STACK_PAINT_BYTES 32768
+#endif
+
+#ifndef PDCPP_STACK_SIZE
+#define PDCPP_STACK_SIZE 61800
+#endif
+
+// kEventInit runs below the frames of the system: the painted area stays
+// within the stack (STACK_SIZE, CMakeLists.txt) less this margin. There are
+// no linker symbols for the stack, it isn't ours.
+#define STACK_MARGIN 8192
+#if PDCPP_STACK_PAINT_BYTES > PDCPP_STACK_SIZE - STACK_MARGIN
+#error "PDCPP_STACK_PAINT_BYTES goes past the end of the stack"
+#endif
+
+#define STACK_PATTERN 0xA5C3A5C3u
+
+// The stack belongs to the system: paint the words below the kEventInit stack
+// pointer, the deepest one overwritten since tells how much was used.
+static uintptr_t stack_top;
+static volatile uint32_t* stack_bottom;
+
+static void __attribute__((noinline)) paint_stack(uintptr_t top)
+{
+    // Stops short of this frame and of the calls below it
+    uint32_t here;
+    volatile uint32_t* end = (volatile uint32_t*)((uintptr_t)&here & ~(uintptr_t)3) - 64;
+    volatile uint32_t* word = (volatile uint32_t*)((top - PDCPP_STACK_PAINT_BYTES) & ~(uintptr_t)3);
+
+    stack_top = top;
+    stack_bottom = word;
+    while (word < end) *word++ = STACK_PATTERN;
+}
+
+int pdcpp_stack_high_water(void)
+{
+    if (!stack_bottom) return -1;
+
+    volatile uint32_t* word = stack_bottom;
+    while ((uintptr_t)word < stack_top && *word == STACK_PATTERN) ++word;
+    return (int)(stack_top - (uintptr_t)word);
+}
+
+int pdcpp_stack_painted(void) { return stack_bottom ? (int)(stack_top - (uintptr_t)stack_bottom) : 0; }
+
+static void report_stack(void)
+{
+    int used = pdcpp_stack_high_water();
+    int painted = pdcpp_stack_painted();
+    pd->system->logToConsole("stack: %d bytes used of %d painted%s", used, painted,
+        used >= painted ? " (painted area overflowed, raise PDCPP_STACK_PAINT_BYTES)" : "");
+}
+
+#else
+
+int pdcpp_stack_high_water(void) { return -1; }
+int pdcpp_stack_painted(void) { return 0; }
+
+#endif
+
 static void exec_array(init_routine_t* start, init_routine_t* end)
 {
     while (start < end)
     {
-        if (*start) (*start)();
+        if (*start) run_init_routine(*start);
         ++start;
     }
 }
@@ -30,15 +271,25 @@ int eventHandlerShim(PlaydateAPI* playdate, PDSystemEvent event, uint32_t arg)
 	if ( event == kEventInit )
 	{
 		pd = playdate;
+#if PDCPP_STACK_PROBE
+		paint_stack((uintptr_t)__builtin_frame_address(0));
+#endif
 		pdrealloc = playdate->system->realloc;
+		if (!pdallocator) pdallocator = pdrealloc;
 		exec_array(&__preinit_array_start, &__preinit_array_end);
 		exec_array(&__init_array_start, &__init_array_end);
+#if PDCPP_INIT_PROFILE
+		report_init_profile();
+#endif
 	}
 
 	if (event == kEventTerminate)
 	{
 		int result = eventHandler(playdate, event, arg);
 		exec_array(&__fini_array_start, &__fini_array_end);
+#if PDCPP_STACK_PROBE
+		report_stack();
+#endif
 		return result;
 	}
 
@@ -46,9 +297,9 @@ int eventHandlerShim(PlaydateAPI* playdate, PDSystemEvent event, uint32_t arg)
 }
 
 // standard library functions
-void* _malloc_r(struct _reent* _REENT, size_t nbytes) { return pdrealloc(NULL,nbytes); }
-void* _realloc_r(struct _reent* _REENT, void* ptr, size_t nbytes) { return pdrealloc(ptr,nbytes); }
-void _free_r(struct _reent* _REENT, void* ptr ) { pdrealloc(ptr,0); }
+void* _malloc_r(struct _reent* _REENT, size_t nbytes) { return shim_realloc(NULL,nbytes); }
+void* _realloc_r(struct _reent* _REENT, void* ptr, size_t nbytes) { return shim_realloc(ptr,nbytes); }
+void _free_r(struct _reent* _REENT, void* ptr ) { shim_realloc(ptr,0); }
 
 PDEventHandler* PD_eventHandler __attribute__((section(".capi_handler"))) = &eventHandlerShim;
 
@@ -60,30 +311,43 @@ uint32_t* _bss_end __attribute__((section(".bss_end"))) = &bssEnd;
 
 #else
 
+// The probe only runs on device
+int pdcpp_stack_high_water(void) { return -1; }
+int pdcpp_stack_painted(void) { return 0; }
+
 int eventHandlerShim(PlaydateAPI* playdate, PDSystemEvent event, uint32_t arg)
 {
     if ( event == kEventInit )
+    {
         pdrealloc = playdate->system->realloc;
+        if (!pdallocator) pdallocator = pdrealloc;
+    }
 
     return eventHandler(playdate, event, arg);
 }
 
+// The host build gets its system realloc from the C library: overriding malloc
+// there would make it call itself
+#if !PDCPP_HOST_BUILD
+
 #ifdef _WINDLL
 __declspec(dllexport)
 #endif
-void* malloc(size_t nbytes) { return pdrealloc(NULL,nbytes); }
+void* malloc(size_t nbytes) { return shim_realloc(NULL,nbytes); }
 
 #ifdef _WINDLL
 __declspec(dllexport)
 #endif
-void* realloc(void* ptr, size_t nbytes) { return pdrealloc(ptr,nbytes); }
+void* realloc(void* ptr, size_t nbytes) { return shim_realloc(ptr,nbytes); }
 
 #ifdef _WINDLL
 __declspec(dllexport)
 #endif
 void  free(void* ptr )
 {
-    pdrealloc(ptr,0);
+    shim_realloc(ptr,0);
 }
 
 #endif
+
+#endif